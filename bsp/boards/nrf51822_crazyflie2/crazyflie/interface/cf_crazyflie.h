@@ -23,13 +23,18 @@
 
 //=========================== typedef =========================================
 
+typedef void (*crazyflie_syslinkRx_cbt)(void);
+
 //=========================== variables =======================================
 
 //=========================== prototypes ======================================
 
 void crazyflieInit();
 void crazyflieShutdown();
-void crazyflieHandle();
+void crazyflieHandle();                 // polling: crazyflieSyslinkHandle() + crazyfliePeriodicHandle()
+void crazyflieSyslinkHandle();          // process all received syslink frames
+void crazyfliePeriodicHandle();         // keepalive, status LED and power management, call every SYSLINK_SEND_PERIOD_MS
+void crazyflieSetSyslinkRxCb(crazyflie_syslinkRx_cbt cb); // called from the UART ISR when a frame is complete
 //void syslinkHandle();// move into crazyflieHandle
 void crazyflieEmergencyStop();
 
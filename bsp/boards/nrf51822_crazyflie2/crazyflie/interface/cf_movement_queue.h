@@ -42,6 +42,6 @@ struct simple_trajectory
 //=========================== prototypes ======================================
 
 void cf_movement_queue_init();
-void cf_movement_queue_handle(asn_t *now_asn);
+void cf_movement_queue_handle(uint32_t elapsed_asn);
 
 #endif // __CF_MOVEMENT_QUEUE__
@@ -39,6 +39,9 @@
 #define __CF_UART_H__
 
 #include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*uart_rxFrame_cbt)(void);
 
 void uartInit();
 
@@ -58,4 +61,10 @@ int uartDropped();
 uint8_t uartGetError();
 uint8_t uartGetErrorCount();
 
+/**
+ * Set the function called, in interrupt context, each time a complete
+ * syslink frame has been received.
+ */
+void uartSetRxFrameCb(uart_rxFrame_cbt cb);
+
 #endif //__CF_UART_H__
@@ -45,7 +45,8 @@ static struct syslinkPacket slTxPacket;
 
 //=========================== prototypes ======================================
 
-void _syslinkHandle();
+bool _syslinkHandle();
+void _syslinkKeepalive();
 
 //=========================== public ==========================================
 
@@ -75,10 +76,41 @@ void crazyflieShutdown()
 void crazyflieHandle()
 {
   _syslinkHandle();
+
+  // Send
+  // TODO:optimize it
+  if (systickGetTick() - lastSyslinkSendTime > SYSLINK_SEND_PERIOD_MS)
+  {
+    _syslinkKeepalive();
+  }
+
+  status_led_handle();
+  pmProcess();
+}
+
+void crazyflieSyslinkHandle()
+{
+  // process every complete frame waiting in the UART queue
+  while (_syslinkHandle());
+}
+
+void crazyfliePeriodicHandle()
+{
+  // the caller sets the period, only hold back during the startup delay
+  if (systickGetTick() > SYSLINK_STARTUP_DELAY_TIME_MS)
+  {
+    _syslinkKeepalive();
+  }
+
   status_led_handle();
   pmProcess();
 }
 
+void crazyflieSetSyslinkRxCb(crazyflie_syslinkRx_cbt cb)
+{
+  uartSetRxFrameCb(cb);
+}
+
 void crazyflieEmergencyStop()
 {
   uint8_t data[1] = {0x03}; // 0x03:EMERGENCY_STOP
@@ -87,7 +119,7 @@ void crazyflieEmergencyStop()
 
 //=========================== private =========================================
 
-void _syslinkHandle()
+bool _syslinkHandle()
 {
 
   if (syslinkReceive(&slRxPacket)) // try to receive
@@ -283,16 +315,18 @@ void _syslinkHandle()
       // sendNullCTRPPackage();
       break;
     }
-  }
 
-  // Send
-  // TODO:optimize it
-  if (systickGetTick() - lastSyslinkSendTime > SYSLINK_SEND_PERIOD_MS)
-  {
-    lastSyslinkSendTime = systickGetTick();
-    CTRPSend_NULL(); // just send NULL to keep syslink alive, otherwise the STM32 will blocked until a packet is received
+    return true;
   }
 
+  return false;
+}
+
+void _syslinkKeepalive()
+{
+  lastSyslinkSendTime = systickGetTick();
+  CTRPSend_NULL(); // just send NULL to keep syslink alive, otherwise the STM32 will blocked until a packet is received
+
   /*
     Tips:
     1. The STM32 Only sends data when it receives a packet from the NRF51822. So, we have to send a NULL packet to keep the syslink alive.
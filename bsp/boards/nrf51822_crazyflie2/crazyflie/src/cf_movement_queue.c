@@ -23,8 +23,6 @@ typedef struct
   int drone_id;  // Drone ID
   int drone_num; // Drone number
 
-  uint32_t movement_start_asn; // the ASN when the movement starts
-
   int current_step_index;          // current step index
   uint32_t current_step_start_ASN; // current step start ASN
   uint32_t current_step_end_ASN;   // current step end ASN
@@ -106,7 +104,6 @@ int _execute_current_step(Drone *drone, uint32_t now_asn);
 int _execute_next_step(Drone *drone, uint32_t now_asn);
 int _roll_back_step_by_asn_diff(int32_t asn_diff, Drone *drone);
 int _roll_forward_step_by_asn_diff(int32_t asn_diff, Drone *drone);
-uint32_t _asn_to_uint32(asn_t *asn);
 int _calculate_index_offset(int drone_id, int num_drones, int num_points);
 
 //=========================== public ==========================================
@@ -119,20 +116,22 @@ void cf_movement_queue_init()
   Drone1.current_step_index = _calculate_index_offset(Drone1.drone_id, Drone1.drone_num, Drone1.trajectory->num_steps);
   Drone1.current_step_start_ASN = 0;
   Drone1.current_step_end_ASN = Drone1.trajectory->points[0].duration_asn;
-
-  Drone1.movement_start_asn = 2100;
 }
 
-void cf_movement_queue_handle(asn_t *now_asn)
+/**
+ * @brief Called at every slot of the movement.
+ * @param elapsed_asn number of slots since the movement started, computed by
+ *        the caller on the full 40-bit ASN
+ */
+void cf_movement_queue_handle(uint32_t elapsed_asn)
 {
-  uint32_t asn = _asn_to_uint32(now_asn);
+  uint32_t asn = elapsed_asn;
 
-  if (asn <= Drone1.movement_start_asn)
+  if (asn == 0)
   {
     return;
   }
 
-  asn -= Drone1.movement_start_asn;
   int32_t diff = asn - last_asn;
 
   /**
@@ -269,12 +268,6 @@ int _calculate_index_offset(int drone_id, int num_drones, int num_points)
   return drone_id * num_points / num_drones;
 }
 
-uint32_t _asn_to_uint32(asn_t *asn)
-{
-  uint32_t test = (uint32_t)asn->bytes2and3 << 16 | (uint32_t)asn->bytes0and1;
-  return test;
-}
-
 
 // int32_t _calculate_asn_diff_int32(asn_t *asn1, asn_t *asn2)
 // {
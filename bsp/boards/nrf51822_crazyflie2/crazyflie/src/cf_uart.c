@@ -42,6 +42,7 @@
 #include "cf_pinout.h"
 
 #include "cf_uart.h"
+#include "cf_syslink.h"
 #include <nrf_gpio.h>
 
 static bool isInit = false;
@@ -58,8 +59,17 @@ static volatile char dummy;
 static volatile uint8_t uartError = 0;
 static volatile uint8_t uartErrorCount = 0;
 
+// syslink frame delimiting, only used to know when a complete frame is queued
+static enum {frame_first_start, frame_second_start, frame_type, frame_length, frame_body} frameState = frame_first_start;
+static uint8_t frameRemaining = 0;
+static uart_rxFrame_cbt rxFrameCb = 0;
+
+static void uartTrackFrame(uint8_t c);
+
 void UART0_IRQHandler()
 {
+  uint8_t c;
+
   int nhead = head+1;
 
   if (NRF_UART0->ERRORSRC) {
@@ -80,8 +90,54 @@ void UART0_IRQHandler()
   }
 
   // Push data in queue
-  rxq[head++] = NRF_UART0->RXD;
+  c = NRF_UART0->RXD;
+  rxq[head++] = c;
   if (head >= Q_LENGTH) head = 0;
+
+  uartTrackFrame(c);
+}
+
+/**
+ * Follow the syslink framing of the received bytes, without checking the
+ * checksums, and call the RX frame callback once the last byte of a frame is
+ * in the queue. The frame itself is parsed by syslinkReceive().
+ */
+static void uartTrackFrame(uint8_t c)
+{
+  switch (frameState)
+  {
+    case frame_first_start:
+      frameState = (c == 0xBC) ? frame_second_start : frame_first_start;
+      break;
+    case frame_second_start:
+      frameState = (c == 0xCF) ? frame_type : frame_first_start;
+      break;
+    case frame_type:
+      frameState = frame_length;
+      break;
+    case frame_length:
+      if (c > SYSLINK_MTU) {
+        frameState = frame_first_start;
+      } else {
+        frameRemaining = c + 2; // data and both checksum bytes
+        frameState = frame_body;
+      }
+      break;
+    case frame_body:
+      frameRemaining--;
+      if (frameRemaining == 0) {
+        frameState = frame_first_start;
+        if (rxFrameCb) {
+          rxFrameCb();
+        }
+      }
+      break;
+  }
+}
+
+void uartSetRxFrameCb(uart_rxFrame_cbt cb)
+{
+  rxFrameCb = cb;
 }
 
 void uartInit()
@@ -19,6 +19,7 @@
 #include "IEEE802154E_obj.h"
 #include "IEEE802154_security_obj.h"
 #include "adaptive_sync_obj.h"
+#include "asn_events_obj.h"
 #include "iphc_obj.h"
 #include "neighbors_obj.h"
 #include "sixtop_obj.h"
@@ -31,6 +32,7 @@
 #include "idmanager_obj.h"
 #include "openqueue_obj.h"
 #include "openrandom_obj.h"
+#include "snapshot_obj.h"
 #include "frag_obj.h"
 // applications
 #include "c6t_obj.h"
@@ -214,13 +216,21 @@ struct OpenMote {
     msf_vars_t msf_vars;
     // l2a
     adaptive_sync_vars_t adaptive_sync_vars;
+    asn_events_vars_t asn_events_vars;
     ieee802154_security_vars_t ieee802154_security_vars;
     ieee154e_vars_t ieee154e_vars;
     ieee154e_stats_t ieee154e_stats;
     ieee154e_dbg_t ieee154e_dbg;
+#if IEEE802154E_TIMING_ENABLE
+    ieee154e_timing_t ieee154e_timing;
+#endif
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+    ieee154e_channels_t ieee154e_channels;
+#endif
     // cross-layer
     idmanager_vars_t idmanager_vars;
     openqueue_vars_t openqueue_vars;
+    snapshot_vars_t snapshot_vars;
     // drivers
     opentimers_vars_t opentimers_vars;
     random_vars_t random_vars;
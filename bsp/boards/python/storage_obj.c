@@ -0,0 +1,111 @@
+/**
+\brief Python-specific definition of the "storage" bsp module.
+
+The block is kept in a file, one per mote, named after the EUI64 of the mote.
+The file is created in the directory given by the OPENWSN_STORAGE_DIR
+environment variable, or in the current directory if it is not set. Removing
+the file erases the storage of that mote.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "storage_obj.h"
+#include "eui64_obj.h"
+
+//=========================== defines =========================================
+
+#define STORAGE_DIR_VARIABLE    "OPENWSN_STORAGE_DIR"
+#define STORAGE_FILENAME_LEN    256
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+void storage_getFilename(OpenMote* self, char* filename, const char* suffix);
+
+//=========================== public ==========================================
+
+uint16_t storage_read(OpenMote* self, uint8_t* buffer, uint16_t maxLen) {
+   char       filename[STORAGE_FILENAME_LEN];
+   FILE*      file;
+   size_t     len;
+
+#ifdef TRACE_ON
+   printf("C@0x%x: storage_read()... \n",self);
+#endif
+
+   storage_getFilename(self,filename,"");
+   file = fopen(filename,"rb");
+   if (file==NULL) {
+      // nothing stored yet
+      return 0;
+   }
+   len = fread(buffer,1,maxLen,file);
+   fclose(file);
+
+   return (uint16_t)len;
+}
+
+owerror_t storage_write(OpenMote* self, uint8_t* buffer, uint16_t len) {
+   char       filename[STORAGE_FILENAME_LEN];
+   char       tempFilename[STORAGE_FILENAME_LEN];
+   FILE*      file;
+   size_t     written;
+
+#ifdef TRACE_ON
+   printf("C@0x%x: storage_write(len=%d)... \n",self,len);
+#endif
+
+   // write a temporary file, then replace the block, as flash would
+   storage_getFilename(self,filename,"");
+   storage_getFilename(self,tempFilename,".tmp");
+   file = fopen(tempFilename,"wb");
+   if (file==NULL) {
+      printf("[CRITICAL] storage_write() could not open %s\r\n",tempFilename);
+      return E_FAIL;
+   }
+   written = fwrite(buffer,1,len,file);
+   if (fclose(file)!=0 || written!=len) {
+      remove(tempFilename);
+      return E_FAIL;
+   }
+   if (rename(tempFilename,filename)!=0) {
+      remove(tempFilename);
+      return E_FAIL;
+   }
+
+   return E_SUCCESS;
+}
+
+void storage_erase(OpenMote* self) {
+   char       filename[STORAGE_FILENAME_LEN];
+
+#ifdef TRACE_ON
+   printf("C@0x%x: storage_erase()... \n",self);
+#endif
+
+   storage_getFilename(self,filename,"");
+   remove(filename);
+}
+
+//=========================== private =========================================
+
+void storage_getFilename(OpenMote* self, char* filename, const char* suffix) {
+   const char* dir;
+   uint8_t     eui64[8];
+
+   dir = getenv(STORAGE_DIR_VARIABLE);
+   if (dir==NULL || dir[0]=='\0') {
+      dir = ".";
+   }
+   eui64_get(self,eui64);
+   snprintf(
+      filename,
+      STORAGE_FILENAME_LEN,
+      "%s/storage_%02x%02x%02x%02x%02x%02x%02x%02x.bin%s",
+      dir,
+      eui64[0],eui64[1],eui64[2],eui64[3],
+      eui64[4],eui64[5],eui64[6],eui64[7],
+      suffix
+   );
+}
@@ -0,0 +1,37 @@
+#ifndef __STORAGE_H
+#define __STORAGE_H
+
+/**
+\addtogroup BSP
+\{
+\addtogroup storage
+\{
+
+\brief Cross-platform declaration "storage" bsp module.
+
+Non-volatile storage of a single block of data, which is kept across resets of
+the board. Writing replaces the whole block. An implementation on flash should
+spread the writes over several pages, and only make the new block readable once
+it is entirely written.
+*/
+
+#include "opendefs.h"
+
+//=========================== define ==========================================
+
+//=========================== typedef =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+uint16_t  storage_read(uint8_t* buffer, uint16_t maxLen);
+owerror_t storage_write(uint8_t* buffer, uint16_t len);
+void      storage_erase(void);
+
+/**
+\}
+\}
+*/
+
+#endif
@@ -0,0 +1,48 @@
+/**
+\brief Declaration of the "openchecksum" driver.
+
+Checksum engine shared by the stack and the serial port: a table-driven CRC-16
+and an Internet (one's complement) checksum accumulated over 32 bits.
+*/
+
+#ifndef __OPENCHECKSUM_H
+#define __OPENCHECKSUM_H
+
+#include "opendefs.h"
+
+/**
+\addtogroup drivers
+\{
+\addtogroup OpenChecksum
+\{
+*/
+
+//=========================== define ==========================================
+
+//=========================== typedef =========================================
+
+//=========================== prototypes ======================================
+
+// CRC-16 (polynomial 0x1021, bit-reversed), as used by HDLC and IEEE802.15.4
+uint16_t openchecksum_crc16Byte(uint16_t crc, uint8_t byte);
+
+uint16_t openchecksum_crc16(uint16_t crc, const uint8_t *ptr, uint16_t length);
+
+// Internet checksum (RFC1071)
+uint32_t openchecksum_sum(uint32_t sum, const uint8_t *ptr, uint16_t length);
+
+uint16_t openchecksum_fold(uint32_t sum);
+
+uint16_t openchecksum_finish(uint32_t sum);
+
+// incremental update of an Internet checksum (RFC1624)
+uint16_t openchecksum_update16(uint16_t checksum, uint16_t oldWord, uint16_t newWord);
+
+uint16_t openchecksum_update(uint16_t checksum, const uint8_t *oldData, const uint8_t *newData, uint16_t length);
+
+/**
+\}
+\}
+*/
+
+#endif
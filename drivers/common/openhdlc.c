@@ -6,6 +6,7 @@
 */
 
 #include "openhdlc.h"
+#include "openchecksum.h"
 
 //=========================== variables =======================================
 
@@ -14,7 +15,7 @@
 //=========================== public ==========================================
 
 uint16_t crcIteration(uint16_t crc, uint8_t byte) {
-   return (crc >> 8) ^ fcstab[(crc ^ byte) & 0xff];
+   return openchecksum_crc16Byte(crc, byte);
 }
 
 //=========================== private =========================================
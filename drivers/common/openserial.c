@@ -23,6 +23,7 @@
 #include "uart.h"
 #include "opentimers.h"
 #include "openhdlc.h"
+#include "openchecksum.h"
 #include "schedule.h"
 #include "icmpv6rpl.h"
 #include "icmpv6echo.h"
@@ -398,6 +399,28 @@ void task_openserial_debugPrint(void) {
             if (debugPrint_msf() == TRUE) {
                 break;
             }
+        case STATUS_OPENTIMERS:
+            if (debugPrint_opentimers() == TRUE) {
+                break;
+            }
+#if SCHEDULER_PROFILE_ENABLE
+        case STATUS_SCHEDULER:
+            if (debugPrint_scheduler() == TRUE) {
+                break;
+            }
+#endif
+#if IEEE802154E_TIMING_ENABLE
+        case STATUS_IEEE154E_TIMING:
+            if (debugPrint_macTiming() == TRUE) {
+                break;
+            }
+#endif
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+        case STATUS_IEEE154E_CHANNELS:
+            if (debugPrint_macChannels() == TRUE) {
+                break;
+            }
+#endif
         default:
             debugPrintCounter = 0;
     }
@@ -561,6 +584,21 @@ bool debugPrint_outBufferIndexes(void) {
     return TRUE;
 }
 
+// printed here rather than in opentimers, which is used without openserial by the driver projects
+bool debugPrint_opentimers(void) {
+    opentimers_stats_t stats;
+
+    opentimers_getStats(&stats);
+
+    openserial_printStatus(
+            STATUS_OPENTIMERS,
+            (uint8_t *) &stats,
+            sizeof(opentimers_stats_t)
+    );
+
+    return TRUE;
+}
+
 //=========================== private =========================================
 
 //===== printing
@@ -666,7 +704,7 @@ port_INLINE void outputHdlcWrite(uint8_t b) {
     DISABLE_INTERRUPTS();
 
     // iterate through CRC calculator
-    openserial_vars.hdlcOutputCrc = crcIteration(openserial_vars.hdlcOutputCrc, b);
+    openserial_vars.hdlcOutputCrc = openchecksum_crc16Byte(openserial_vars.hdlcOutputCrc, b);
 
     // add byte to buffer
     if (b == HDLC_FLAG || b == HDLC_ESCAPE) {
@@ -733,7 +771,7 @@ port_INLINE void inputHdlcWrite(uint8_t b) {
         openserial_vars.inputBufFillLevel++;
 
         // iterate through CRC calculator
-        openserial_vars.hdlcInputCrc = crcIteration(openserial_vars.hdlcInputCrc, b);
+        openserial_vars.hdlcInputCrc = openchecksum_crc16Byte(openserial_vars.hdlcInputCrc, b);
     }
 }
 
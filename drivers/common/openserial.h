@@ -173,6 +173,7 @@ void openserial_inhibitStop(void);
 
 // debugprint
 bool debugPrint_outBufferIndexes(void);
+bool debugPrint_opentimers(void);
 
 // interrupt handlers
 uint8_t isr_openserial_rx(void);
@@ -4,6 +4,16 @@
 This driver uses a single hardware timer, which it virtualizes to support
 at most MAX_NUM_TIMERS timers.
 
+The general purpose timers form a pool, chained in a free list so creating and
+destroying a timer costs O(1). A component which creates timers at run time
+can reserve some of them with opentimers_reserve(), so that other components
+cannot exhaust the pool before it needs them.
+
+The running timers are kept in a binary min-heap ordered by their compare
+value, counted from lastCompareValue, so the next timer to fire is always at
+the root. Scheduling or cancelling a timer costs O(log n), and the interrupt
+handler only touches the timers which expire.
+
 \author Tengfei Chang <tengfei.chang@inria.fr>, April 2017.
  */
 
@@ -24,6 +34,19 @@ opentimers_vars_t opentimers_vars;
 //=========================== prototypes ======================================
 
 void  opentimers_timer_callback(void);
+void  opentimers_setNextCompare(void);
+void  opentimers_coalesce(opentimers_id_t id);
+void  opentimers_scheduleNextPeriod(opentimers_id_t id);
+void  opentimers_pushTask(opentimers_id_t id);
+opentimers_id_t opentimers_allocate(uint8_t reservation, uint8_t task_prio);
+// heap of running timers
+bool  opentimers_heapIsBefore(opentimers_id_t a, opentimers_id_t b);
+void  opentimers_heapSet(uint8_t pos, opentimers_id_t id);
+void  opentimers_heapSiftUp(uint8_t pos);
+void  opentimers_heapSiftDown(uint8_t pos);
+void  opentimers_heapInsert(opentimers_id_t id);
+void  opentimers_heapRemove(opentimers_id_t id);
+void  opentimers_heapBuild(void);
 
 //=========================== public ==========================================
 
@@ -34,9 +57,19 @@ Initializes data structures and hardware timer.
  */
 void opentimers_init(void){
 
+    uint8_t i;
+
     // initialize local variables
     memset(&opentimers_vars,0,sizeof(opentimers_vars_t));
 
+    // chain the general purpose timers in the free list, lowest id first
+    for (i=TIMER_NUMBER_NON_GENERAL;i<MAX_NUM_TIMERS-1;i++){
+        opentimers_vars.timersBuf[i].nextFree = i+1;
+    }
+    opentimers_vars.timersBuf[MAX_NUM_TIMERS-1].nextFree = ERROR_NO_AVAILABLE_ENTRIES;
+    opentimers_vars.freeList = TIMER_NUMBER_NON_GENERAL;
+    opentimers_vars.numFree  = MAX_NUM_TIMERS-TIMER_NUMBER_NON_GENERAL;
+
     // set callback for sctimer module
     sctimer_set_callback(opentimers_timer_callback);
 }
@@ -66,14 +99,9 @@ opentimers_id_t opentimers_create(uint8_t timer_id, uint8_t task_prio){
     }
 
     if (timer_id==TIMER_GENERAL_PURPOSE){
-        for (id=TIMER_NUMBER_NON_GENERAL;id<MAX_NUM_TIMERS;id++){
-            if (opentimers_vars.timersBuf[id].isUsed  == FALSE){
-                opentimers_vars.timersBuf[id].isUsed   = TRUE;
-                opentimers_vars.timersBuf[id].timer_task_prio = task_prio;
-                ENABLE_INTERRUPTS();
-                return id;
-            }
-        }
+        id = opentimers_allocate(OPENTIMERS_NO_RESERVATION,task_prio);
+        ENABLE_INTERRUPTS();
+        return id;
     }
 
     ENABLE_INTERRUPTS();
@@ -82,6 +110,79 @@ opentimers_id_t opentimers_create(uint8_t timer_id, uint8_t task_prio){
     return ERROR_NO_AVAILABLE_ENTRIES;
 }
 
+/**
+\brief reserve general purpose timers for a component.
+
+The reserved timers are only handed out by opentimers_createReserved() for
+that component. A component can hold a single reservation.
+
+\param[in] component the component the timers are reserved for
+\param[in] num the number of timers to reserve
+
+\returns TRUE if the timers are reserved, FALSE if the pool is too small or
+   there is no room for another reservation
+ */
+bool opentimers_reserve(uint8_t component, uint8_t num){
+    opentimers_reservation_t* reservation;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    if (
+        opentimers_vars.numReservations==OPENTIMERS_MAX_RESERVATIONS ||
+        opentimers_vars.numFree-opentimers_vars.numReservedLeft<num
+    ){
+        ENABLE_INTERRUPTS();
+        return FALSE;
+    }
+
+    reservation = &opentimers_vars.reservations[opentimers_vars.numReservations];
+    reservation->component    = component;
+    reservation->numReserved  = num;
+    reservation->numUsed      = 0;
+    opentimers_vars.numReservations++;
+    opentimers_vars.numReservedLeft += num;
+
+    ENABLE_INTERRUPTS();
+    return TRUE;
+}
+
+/**
+\brief create a general purpose timer for a component.
+
+The timer is taken from the timers reserved by this component. Once those are
+all in use, or if the component has no reservation, it is taken from the
+timers nobody reserved, as opentimers_create() does.
+
+\param[in] component the component creating the timer
+\param[in] task_prio the priority of the task pushed when the timer fires
+
+\returns the id of the timer, or ERROR_NO_AVAILABLE_ENTRIES
+ */
+opentimers_id_t opentimers_createReserved(uint8_t component, uint8_t task_prio){
+    uint8_t         i;
+    opentimers_id_t id;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    for (i=0;i<opentimers_vars.numReservations;i++){
+        if (opentimers_vars.reservations[i].component==component){
+            break;
+        }
+    }
+    if (
+        i==opentimers_vars.numReservations ||
+        opentimers_vars.reservations[i].numUsed==opentimers_vars.reservations[i].numReserved
+    ){
+        i = OPENTIMERS_NO_RESERVATION;
+    }
+    id = opentimers_allocate(i,task_prio);
+
+    ENABLE_INTERRUPTS();
+    return id;
+}
+
 /**
 \brief schedule a period refer to comparing value set last time.
 
@@ -99,19 +200,35 @@ void opentimers_scheduleIn(opentimers_id_t    id,
                            time_type_t        uint_type,
                            timer_type_t       timer_type,
                            opentimers_cbt     cb){
-    uint8_t  i;
-    uint8_t  idToSchedule;
-    PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
+    opentimers_scheduleInWithSlack(id,duration,uint_type,timer_type,0,cb);
+}
 
+/**
+\brief schedule a timer which may fire late, to share a wakeup with other timers.
+
+Same as opentimers_scheduleIn(), except the timer fires at most slack after
+current counter + duration. The timer is moved onto the first timer already
+scheduled in that window, else onto the TSCH slot boundary in the window, else
+to the end of the window, where later timers can join it. A periodic timer
+keeps its slack each period, and its periods count from when it was due, so
+the delays do not add up.
+
+\param[in] id indicates the timer id
+\param[in] duration indicates the period asked for schedule since last comparing value
+\param[in] uint_type indicates the unit type of duration and slack: ticks or ms
+\param[in] timer_type indicates the timer type of this schedule: oneshot or periodic
+\param[in] slack indicates how late the timer may fire
+\param[in] cb indicates when this scheduled timer fired, call this callback function.
+ */
+void opentimers_scheduleInWithSlack(opentimers_id_t    id,
+                                    uint32_t           duration,
+                                    time_type_t        uint_type,
+                                    timer_type_t       timer_type,
+                                    uint32_t           slack,
+                                    opentimers_cbt     cb){
     INTERRUPT_DECLARATION();
     // 1. make sure the timer exist
-    for (i=0;i<MAX_NUM_TIMERS;i++){
-        if (opentimers_vars.timersBuf[i].isUsed && i == id){
-            break;
-        }
-    }
-    if (i==MAX_NUM_TIMERS){
+    if (id>=MAX_NUM_TIMERS || opentimers_vars.timersBuf[id].isUsed==FALSE){
         // doesn't find the timer
         return;
     }
@@ -125,46 +242,31 @@ void opentimers_scheduleIn(opentimers_id_t    id,
     case TIME_MS:
         opentimers_vars.timersBuf[id].duration = duration*PORT_TICS_PER_MS;
         opentimers_vars.timersBuf[id].wraps_remaining  = (uint32_t)(duration*PORT_TICS_PER_MS)/MAX_TICKS_IN_SINGLE_CLOCK;
+        opentimers_vars.timersBuf[id].slack    = slack*PORT_TICS_PER_MS;
         break;
     case TIME_TICS:
         opentimers_vars.timersBuf[id].duration = duration;
         opentimers_vars.timersBuf[id].wraps_remaining  = (uint32_t)(duration)/MAX_TICKS_IN_SINGLE_CLOCK;
+        opentimers_vars.timersBuf[id].slack    = slack;
         break;
     }
 
+    opentimers_vars.timersBuf[id].nominalCompareValue = (opentimers_vars.timersBuf[id].duration+sctimer_readCounter()) & MAX_TICKS_IN_SINGLE_CLOCK;
     if (opentimers_vars.timersBuf[id].wraps_remaining==0){
-        opentimers_vars.timersBuf[id].currentCompareValue = (opentimers_vars.timersBuf[id].duration+sctimer_readCounter()) & MAX_TICKS_IN_SINGLE_CLOCK;
+        opentimers_vars.timersBuf[id].currentCompareValue = opentimers_vars.timersBuf[id].nominalCompareValue;
+        opentimers_coalesce(id);
     } else {
         opentimers_vars.timersBuf[id].currentCompareValue = (MAX_TICKS_IN_SINGLE_CLOCK+sctimer_readCounter()) & MAX_TICKS_IN_SINGLE_CLOCK;
     }
 
-    opentimers_vars.timersBuf[id].isrunning           = TRUE;
     opentimers_vars.timersBuf[id].callback            = cb;
+    opentimers_heapInsert(id);
 
     // 3. find the next timer to fire
 
     // only execute update the currentCompareValue if I am not inside of ISR or the ISR itself will do this.
     if (opentimers_vars.insideISR==FALSE){
-        i = 0;
-        while (opentimers_vars.timersBuf[i].isrunning==FALSE){
-            i++;
-        }
-        timerGap     = (opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-        idToSchedule = i;
-        for (i=idToSchedule+1;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning){
-                tempTimerGap = (opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-                if (tempTimerGap < timerGap){
-                    // timer "i" is more close to lastCompare value
-                    timerGap     = tempTimerGap;
-                    idToSchedule = i;
-                }
-            }
-        }
-
-        // if I got here, assign the next to be fired timer to given timer
-        opentimers_vars.currentCompareValue = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
-        sctimer_setCompare(opentimers_vars.currentCompareValue);
+        opentimers_setNextCompare();
     }
     opentimers_vars.running        = TRUE;
 
@@ -189,20 +291,10 @@ void opentimers_scheduleAbsolute(opentimers_id_t    id,
                                  PORT_TIMER_WIDTH   reference ,
                                  time_type_t        uint_type,
                                  opentimers_cbt     cb){
-    uint8_t  i;
-    uint8_t idToSchedule;
-    PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
-
     INTERRUPT_DECLARATION();
 
     // 1. make sure the timer exist
-    for (i=0;i<MAX_NUM_TIMERS;i++){
-        if (opentimers_vars.timersBuf[i].isUsed && i == id){
-            break;
-        }
-    }
-    if (i==MAX_NUM_TIMERS){
+    if (id>=MAX_NUM_TIMERS || opentimers_vars.timersBuf[id].isUsed==FALSE){
         // doesn't find the timer
         return;
     }
@@ -211,6 +303,7 @@ void opentimers_scheduleAbsolute(opentimers_id_t    id,
 
     // absolute scheduling is for one shot timer
     opentimers_vars.timersBuf[id].timerType = TIMER_ONESHOT;
+    opentimers_vars.timersBuf[id].slack     = 0;
 
     // 2. updat the timer content
     switch (uint_type){
@@ -224,39 +317,21 @@ void opentimers_scheduleAbsolute(opentimers_id_t    id,
         break;
     }
 
+    opentimers_vars.timersBuf[id].nominalCompareValue = (opentimers_vars.timersBuf[id].duration+reference) & MAX_TICKS_IN_SINGLE_CLOCK;
     if (opentimers_vars.timersBuf[id].wraps_remaining==0){
-        opentimers_vars.timersBuf[id].currentCompareValue = (opentimers_vars.timersBuf[id].duration+reference) & MAX_TICKS_IN_SINGLE_CLOCK;
+        opentimers_vars.timersBuf[id].currentCompareValue = opentimers_vars.timersBuf[id].nominalCompareValue;
     } else {
         opentimers_vars.timersBuf[id].currentCompareValue = (MAX_TICKS_IN_SINGLE_CLOCK+reference) & MAX_TICKS_IN_SINGLE_CLOCK;
     }
 
-    opentimers_vars.timersBuf[id].isrunning = TRUE;
     opentimers_vars.timersBuf[id].callback  = cb;
+    opentimers_heapInsert(id);
 
     // 3. find the next timer to fire
 
     // only execute update the currentCompareValue if I am not inside of ISR or the ISR itself will do this.
     if (opentimers_vars.insideISR==FALSE){
-        i = 0;
-        while (opentimers_vars.timersBuf[i].isrunning==FALSE){
-            i++;
-        }
-        timerGap     = (opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-        idToSchedule = i;
-        for (i=idToSchedule+1;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning){
-                tempTimerGap = (opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-                if (tempTimerGap < timerGap){
-                    // timer "i" is more close to lastCompare value
-                    timerGap     = tempTimerGap;
-                    idToSchedule = i;
-                }
-            }
-        }
-
-        // if I got here, assign the next to be fired timer to given timer
-        opentimers_vars.currentCompareValue = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
-        sctimer_setCompare(opentimers_vars.currentCompareValue);
+        opentimers_setNextCompare();
     }
     opentimers_vars.running = TRUE;
 
@@ -293,7 +368,7 @@ void opentimers_cancel(opentimers_id_t id){
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    opentimers_vars.timersBuf[id].isrunning = FALSE;
+    opentimers_heapRemove(id);
     opentimers_vars.timersBuf[id].callback  = NULL;
 
     ENABLE_INTERRUPTS();
@@ -309,8 +384,29 @@ Reset the whole entry of given timer including the id.
 \returns False if the given can't be found or return Success
  */
 bool opentimers_destroy(opentimers_id_t id){
+    uint8_t reservation;
+    bool    wasUsed;
+
+    INTERRUPT_DECLARATION();
+
     if (id<MAX_NUM_TIMERS){
+        DISABLE_INTERRUPTS();
+        opentimers_heapRemove(id);
+        reservation = opentimers_vars.timersBuf[id].reservation;
+        wasUsed     = opentimers_vars.timersBuf[id].isUsed;
         memset(&opentimers_vars.timersBuf[id],0,sizeof(opentimers_t));
+
+        if (id>=TIMER_NUMBER_NON_GENERAL && wasUsed){
+            // back to the pool
+            opentimers_vars.timersBuf[id].nextFree = opentimers_vars.freeList;
+            opentimers_vars.freeList = id;
+            opentimers_vars.numFree++;
+            if (reservation!=OPENTIMERS_NO_RESERVATION){
+                opentimers_vars.reservations[reservation].numUsed--;
+                opentimers_vars.numReservedLeft++;
+            }
+        }
+        ENABLE_INTERRUPTS();
         return TRUE;
     } else {
         return FALSE;
@@ -335,6 +431,26 @@ PORT_TIMER_WIDTH opentimers_getCurrentCompareValue(void){
     return opentimers_vars.currentCompareValue;
 }
 
+/**
+\brief get the usage statistics of the timer pool.
+
+\param[out] stats filled with the current and peak number of general purpose
+   timers in use, and the number of failed creations
+ */
+void opentimers_getStats(opentimers_stats_t* stats){
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    stats->poolSize         = MAX_NUM_TIMERS-TIMER_NUMBER_NON_GENERAL;
+    stats->numUsed          = stats->poolSize-opentimers_vars.numFree;
+    stats->peakUsed         = opentimers_vars.peakUsed;
+    stats->numReservedLeft  = opentimers_vars.numReservedLeft;
+    stats->numCreateFailed  = opentimers_vars.numCreateFailed;
+    stats->numCoalesced     = opentimers_vars.numCoalesced;
+
+    ENABLE_INTERRUPTS();
+}
+
 /**
 \brief is the given timer running?
 
@@ -350,114 +466,396 @@ bool opentimers_isRunning(opentimers_id_t id){
 /**
 \brief this is the callback function of opentimer.
 
-This function is called when sctimer interrupt happens. The function looks the
-whole timer buffer and find out the correct timer responding to the interrupt
-and call the callback recorded for that timer.
+This function is called when sctimer interrupt happens. The timers responding
+to the interrupt are at the root of the heap: they are taken out of it and
+their callback is called. The next timer to fire is then the new root.
  */
 void opentimers_timer_callback(void){
-    uint8_t i;
-    uint8_t idToSchedule;
-    PORT_TIMER_WIDTH timerGap;
-    PORT_TIMER_WIDTH tempTimerGap;
+    opentimers_id_t  expired[MAX_NUM_TIMERS];
+    uint8_t          numExpired;
+    uint8_t          i;
+    uint8_t          j;
 
     if (
         opentimers_vars.timersBuf[TIMER_INHIBIT].isrunning==TRUE &&
         opentimers_vars.currentCompareValue == opentimers_vars.timersBuf[TIMER_INHIBIT].currentCompareValue
     ){
-        opentimers_vars.timersBuf[TIMER_INHIBIT].isrunning  = FALSE;
+        opentimers_heapRemove(TIMER_INHIBIT);
         opentimers_vars.timersBuf[TIMER_INHIBIT].callback(TIMER_INHIBIT);
         // the next timer selection will be done after SPLITE_TIMER_DURATION ticks
         sctimer_setCompare(sctimer_readCounter()+SPLITE_TIMER_DURATION);
         return;
-    } else {
-        if (opentimers_vars.timersBuf[TIMER_INHIBIT].currentCompareValue == opentimers_vars.currentCompareValue){
-            // this is the timer interrupt right after inhibit timer, pre call the non-tsch, non-inhibit timer interrupt here to avoid interrupt during receiving serial bytes
-            for (i=0;i<MAX_NUM_TIMERS;i++){
-                if (opentimers_vars.timersBuf[i].isrunning==TRUE){
-                    if (i!=TIMER_TSCH && i!=TIMER_INHIBIT && ((opentimers_vars.timersBuf[i].currentCompareValue - opentimers_vars.currentCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK) < PRE_CALL_TIMER_WINDOW){
-                        opentimers_vars.timersBuf[i].currentCompareValue = opentimers_vars.currentCompareValue;
-                    }
-                }
+    }
+
+    // the heap order is kept when the reference moves to the expiring compare
+    // value, since no running timer is before it. Timers scheduled from here on
+    // are ordered against the new reference.
+    opentimers_vars.lastCompareValue = opentimers_vars.currentCompareValue;
+
+    if (opentimers_vars.timersBuf[TIMER_INHIBIT].currentCompareValue == opentimers_vars.currentCompareValue){
+        // this is the timer interrupt right after inhibit timer, pre call the non-tsch, non-inhibit timer interrupt here to avoid interrupt during receiving serial bytes
+        for (j=0;j<opentimers_vars.heapSize;j++){
+            i = opentimers_vars.heap[j];
+            if (i!=TIMER_TSCH && i!=TIMER_INHIBIT && ((opentimers_vars.timersBuf[i].currentCompareValue - opentimers_vars.currentCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK) < PRE_CALL_TIMER_WINDOW){
+                opentimers_vars.timersBuf[i].currentCompareValue = opentimers_vars.currentCompareValue;
             }
         }
-        for (i=0;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning==TRUE){
-                if (opentimers_vars.currentCompareValue == opentimers_vars.timersBuf[i].currentCompareValue){
-                    // this timer expired, mark as expired
-                    opentimers_vars.timersBuf[i].lastCompareValue    = opentimers_vars.timersBuf[i].currentCompareValue;
-                    if (i==TIMER_TSCH){
-                        opentimers_vars.insideISR = TRUE;
+        opentimers_heapBuild();
+    }
+
+    // take the expired timers out of the heap, they come out in id order
+    numExpired = 0;
+    while (
+        opentimers_vars.heapSize>0 &&
+        opentimers_vars.timersBuf[opentimers_vars.heap[0]].currentCompareValue == opentimers_vars.currentCompareValue
+    ){
+        i = opentimers_vars.heap[0];
+        opentimers_heapRemove(i);
+        // still running, until handled below
+        opentimers_vars.timersBuf[i].isrunning  = TRUE;
+        opentimers_vars.timersBuf[i].hasExpired = TRUE;
+        expired[numExpired++] = i;
+    }
+
+    for (j=0;j<numExpired;j++){
+        i = expired[j];
+        if (opentimers_vars.timersBuf[i].hasExpired==FALSE){
+            // cancelled or rescheduled by the callback of a previous timer
+            continue;
+        }
+        opentimers_vars.timersBuf[i].hasExpired = FALSE;
+
+        // this timer expired, mark as expired
+        opentimers_vars.timersBuf[i].lastCompareValue    = opentimers_vars.timersBuf[i].currentCompareValue;
+        if (i==TIMER_TSCH){
+            opentimers_vars.insideISR = TRUE;
+            opentimers_vars.timersBuf[i].isrunning  = FALSE;
+            opentimers_vars.timersBuf[i].callback(i);
+            opentimers_vars.insideISR = FALSE;
+        } else {
+            if (opentimers_vars.timersBuf[i].wraps_remaining==0){
+                opentimers_vars.timersBuf[i].isrunning = FALSE;
+                opentimers_pushTask(i);
+                if (opentimers_vars.timersBuf[i].timerType==TIMER_PERIODIC){
+                    opentimers_scheduleNextPeriod(i);
+                }
+            } else {
+                opentimers_vars.timersBuf[i].wraps_remaining--;
+                if (opentimers_vars.timersBuf[i].wraps_remaining == 0){
+                    opentimers_vars.timersBuf[i].currentCompareValue = opentimers_vars.timersBuf[i].nominalCompareValue;
+                    if (((opentimers_vars.timersBuf[i].currentCompareValue - opentimers_vars.currentCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK) < PRE_CALL_TIMER_WINDOW){
+                        // pre-call the timer here if it will be fired within PRE_CALL_TIMER_WINDOW, when wraps_remaining decrease to 0
                         opentimers_vars.timersBuf[i].isrunning  = FALSE;
-                        opentimers_vars.timersBuf[i].callback(i);
-                        opentimers_vars.insideISR = FALSE;
-                    } else {
-                        if (opentimers_vars.timersBuf[i].wraps_remaining==0){
-                            opentimers_vars.timersBuf[i].isrunning = FALSE;
-                            scheduler_push_task((task_cbt)(opentimers_vars.timersBuf[i].callback),(task_prio_t)opentimers_vars.timersBuf[i].timer_task_prio);
-                            if (opentimers_vars.timersBuf[i].timerType==TIMER_PERIODIC){
-                                opentimers_vars.insideISR = TRUE;
-                                opentimers_scheduleIn(
-                                    i,
-                                    opentimers_vars.timersBuf[i].duration,
-                                    TIME_TICS,
-                                    TIMER_PERIODIC,
-                                    opentimers_vars.timersBuf[i].callback
-                                );
-                                opentimers_vars.insideISR = FALSE;
-                            }
-                        } else {
-                            opentimers_vars.timersBuf[i].wraps_remaining--;
-                            if (opentimers_vars.timersBuf[i].wraps_remaining == 0){
-                                opentimers_vars.timersBuf[i].currentCompareValue = (opentimers_vars.timersBuf[i].duration+opentimers_vars.timersBuf[i].lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-                                if (((opentimers_vars.timersBuf[i].currentCompareValue - opentimers_vars.currentCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK) < PRE_CALL_TIMER_WINDOW){
-                                    // pre-call the timer here if it will be fired within PRE_CALL_TIMER_WINDOW, when wraps_remaining decrease to 0
-                                    opentimers_vars.timersBuf[i].isrunning  = FALSE;
-                                    scheduler_push_task((task_cbt)(opentimers_vars.timersBuf[i].callback),(task_prio_t)opentimers_vars.timersBuf[i].timer_task_prio);
-                                    if (opentimers_vars.timersBuf[i].timerType==TIMER_PERIODIC){
-                                        opentimers_vars.insideISR = TRUE;
-                                        opentimers_scheduleIn(
-                                            i,
-                                            opentimers_vars.timersBuf[i].duration,
-                                            TIME_TICS,
-                                            TIMER_PERIODIC,
-                                            opentimers_vars.timersBuf[i].callback
-                                        );
-                                        opentimers_vars.insideISR = FALSE;
-                                    }
-                                }
-                            } else {
-                                opentimers_vars.timersBuf[i].currentCompareValue = (opentimers_vars.timersBuf[i].lastCompareValue + MAX_TICKS_IN_SINGLE_CLOCK) & MAX_TICKS_IN_SINGLE_CLOCK;
-                            }
+                        opentimers_pushTask(i);
+                        if (opentimers_vars.timersBuf[i].timerType==TIMER_PERIODIC){
+                            opentimers_scheduleNextPeriod(i);
                         }
+                    } else {
+                        opentimers_coalesce(i);
+                        opentimers_vars.timersBuf[i].isrunning = FALSE;
+                        opentimers_heapInsert(i);
                     }
+                } else {
+                    opentimers_vars.timersBuf[i].currentCompareValue = (opentimers_vars.timersBuf[i].lastCompareValue + MAX_TICKS_IN_SINGLE_CLOCK) & MAX_TICKS_IN_SINGLE_CLOCK;
+                    opentimers_vars.timersBuf[i].isrunning = FALSE;
+                    opentimers_heapInsert(i);
                 }
             }
         }
     }
-    opentimers_vars.lastCompareValue = opentimers_vars.currentCompareValue;
 
     // find the next timer to be fired
-    i = 0;
-    while (opentimers_vars.timersBuf[i].isrunning==FALSE && i<MAX_NUM_TIMERS){
-        i++;
-    }
-    if(i<MAX_NUM_TIMERS){
-        timerGap     = (opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-        idToSchedule = i;
-        for (i=idToSchedule+1;i<MAX_NUM_TIMERS;i++){
-            if (opentimers_vars.timersBuf[i].isrunning){
-                tempTimerGap = (opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
-                if (tempTimerGap < timerGap){
-                    timerGap     = tempTimerGap;
-                    idToSchedule = i;
-                }
-            }
+    opentimers_setNextCompare();
+}
+
+//=========================== private =========================================
+
+/**
+\brief Take a general purpose timer from the free list.
+
+Timers nobody reserved are only handed out while enough free timers are left
+for the pending reservations. Must be called with interrupts disabled.
+
+\param[in] reservation the index of the reservation the timer is taken from,
+   or OPENTIMERS_NO_RESERVATION
+\param[in] task_prio the priority of the task pushed when the timer fires
+
+\returns the id of the timer, or ERROR_NO_AVAILABLE_ENTRIES
+ */
+opentimers_id_t opentimers_allocate(uint8_t reservation, uint8_t task_prio){
+    opentimers_id_t id;
+    uint8_t         numUsed;
+
+    if (reservation==OPENTIMERS_NO_RESERVATION){
+        if (opentimers_vars.numFree<=opentimers_vars.numReservedLeft){
+            opentimers_vars.numCreateFailed++;
+            return ERROR_NO_AVAILABLE_ENTRIES;
         }
+    } else {
+        opentimers_vars.reservations[reservation].numUsed++;
+        opentimers_vars.numReservedLeft--;
+    }
+
+    id = opentimers_vars.freeList;
+    opentimers_vars.freeList = opentimers_vars.timersBuf[id].nextFree;
+    opentimers_vars.numFree--;
 
-        // reschedule the timer
-        opentimers_vars.currentCompareValue = opentimers_vars.timersBuf[idToSchedule].currentCompareValue;
+    opentimers_vars.timersBuf[id].isUsed          = TRUE;
+    opentimers_vars.timersBuf[id].timer_task_prio = task_prio;
+    opentimers_vars.timersBuf[id].reservation     = reservation;
+
+    numUsed = MAX_NUM_TIMERS-TIMER_NUMBER_NON_GENERAL-opentimers_vars.numFree;
+    if (numUsed>opentimers_vars.peakUsed){
+        opentimers_vars.peakUsed = numUsed;
+    }
+    return id;
+}
+
+/**
+\brief Program the hardware timer with the compare value of the next timer.
+
+The next timer is the root of the heap. If no timer is running, the hardware
+timer is left as is and the module is marked as not running.
+ */
+void opentimers_setNextCompare(void){
+    if (opentimers_vars.heapSize>0){
+        opentimers_vars.currentCompareValue = opentimers_vars.timersBuf[opentimers_vars.heap[0]].currentCompareValue;
         sctimer_setCompare(opentimers_vars.currentCompareValue);
     } else {
-        opentimers_vars.running        = FALSE;
+        opentimers_vars.running = FALSE;
+    }
+}
+
+/**
+\brief Delay the compare value of a timer within its slack, to share a wakeup.
+
+The compare value of the timer must be set. Among the running timers, the one
+firing first within the slack window gives the new compare value. Without
+one, the timer is aligned on the TSCH timer, a slot duration apart, since the
+CPU wakes up at that offset in every active slot. Otherwise it is moved to the
+end of the window, so timers scheduled later can join it.
+ */
+void opentimers_coalesce(opentimers_id_t id){
+    PORT_TIMER_WIDTH slack;
+    PORT_TIMER_WIDTH delay;
+    PORT_TIMER_WIDTH tempDelay;
+    PORT_TIMER_WIDTH tschGap;
+    PORT_TIMER_WIDTH timerGap;
+    uint8_t          pos;
+    opentimers_id_t  other;
+    bool             joined;
+
+    slack = opentimers_vars.timersBuf[id].slack;
+    if (slack==0){
+        return;
+    }
+
+    delay  = slack;
+    joined = FALSE;
+    for (pos=0;pos<opentimers_vars.heapSize;pos++){
+        other = opentimers_vars.heap[pos];
+        if (other==id || other==TIMER_INHIBIT){
+            continue;
+        }
+        tempDelay = (opentimers_vars.timersBuf[other].currentCompareValue-opentimers_vars.timersBuf[id].currentCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+        if (tempDelay<=delay){
+            delay  = tempDelay;
+            joined = TRUE;
+        }
+    }
+
+    if (joined==FALSE && opentimers_vars.timersBuf[TIMER_TSCH].isrunning){
+        // first multiple of the slot duration from the TSCH timer, at or after the compare value
+        tschGap   = (opentimers_vars.timersBuf[TIMER_TSCH].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+        timerGap  = (opentimers_vars.timersBuf[id].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+        if (tschGap>=timerGap){
+            tempDelay = (tschGap-timerGap) % PORT_TsSlotDuration;
+        } else {
+            tempDelay = (timerGap-tschGap) % PORT_TsSlotDuration;
+            if (tempDelay>0){
+                tempDelay = PORT_TsSlotDuration-tempDelay;
+            }
+        }
+        if (tempDelay<=delay){
+            delay = tempDelay;
+        }
+    }
+
+    if (joined){
+        opentimers_vars.numCoalesced++;
+    }
+    opentimers_vars.timersBuf[id].currentCompareValue = (opentimers_vars.timersBuf[id].currentCompareValue+delay) & MAX_TICKS_IN_SINGLE_CLOCK;
+}
+
+/**
+\brief Schedule the next period of a periodic timer which expired.
+
+The period counts from the nominal compare value of the previous one, not from
+when the timer actually fired, so that the delays within the slack do not
+stretch the period. If that time is already past, the period counts from now.
+Called from the interrupt, after lastCompareValue moved to the expiring compare
+value.
+ */
+void opentimers_scheduleNextPeriod(opentimers_id_t id){
+    PORT_TIMER_WIDTH reference;
+    PORT_TIMER_WIDTH nominal;
+
+    reference = opentimers_vars.timersBuf[id].nominalCompareValue;
+    opentimers_vars.timersBuf[id].wraps_remaining = opentimers_vars.timersBuf[id].duration/MAX_TICKS_IN_SINGLE_CLOCK;
+    if (opentimers_vars.timersBuf[id].wraps_remaining==0){
+        nominal = (reference+opentimers_vars.timersBuf[id].duration) & MAX_TICKS_IN_SINGLE_CLOCK;
+        if (((nominal-sctimer_readCounter()) & MAX_TICKS_IN_SINGLE_CLOCK) > opentimers_vars.timersBuf[id].duration){
+            // the previous period ended too late, the next one would already be over
+            reference = sctimer_readCounter();
+            nominal   = (reference+opentimers_vars.timersBuf[id].duration) & MAX_TICKS_IN_SINGLE_CLOCK;
+        }
+        opentimers_vars.timersBuf[id].nominalCompareValue = nominal;
+        opentimers_vars.timersBuf[id].currentCompareValue = nominal;
+        opentimers_coalesce(id);
+    } else {
+        opentimers_vars.timersBuf[id].nominalCompareValue = (reference+opentimers_vars.timersBuf[id].duration) & MAX_TICKS_IN_SINGLE_CLOCK;
+        opentimers_vars.timersBuf[id].currentCompareValue = (reference+MAX_TICKS_IN_SINGLE_CLOCK) & MAX_TICKS_IN_SINGLE_CLOCK;
+    }
+    opentimers_heapInsert(id);
+    opentimers_vars.running = TRUE;
+}
+
+/**
+\brief Push the task of a timer which expired.
+
+The callback of a one-shot timer is not called again if its task is lost, so
+that task is never shed. A periodic timer fires again, its task may be shed
+when the task list is full.
+ */
+void opentimers_pushTask(opentimers_id_t id){
+    if (opentimers_vars.timersBuf[id].timerType==TIMER_PERIODIC){
+        scheduler_push_task_coalesce((task_cbt)(opentimers_vars.timersBuf[id].callback),(task_prio_t)opentimers_vars.timersBuf[id].timer_task_prio);
+    } else {
+        scheduler_push_task_protected((task_cbt)(opentimers_vars.timersBuf[id].callback),(task_prio_t)opentimers_vars.timersBuf[id].timer_task_prio);
+    }
+}
+
+/**
+\brief Whether timer a fires before timer b.
+
+Timers are compared on the time between lastCompareValue and their compare
+value. On a tie, the lowest id comes first, so timers expiring together are
+handled in the same order as they are stored in timersBuf.
+ */
+bool opentimers_heapIsBefore(opentimers_id_t a, opentimers_id_t b){
+    PORT_TIMER_WIDTH gapA;
+    PORT_TIMER_WIDTH gapB;
+
+    gapA = (opentimers_vars.timersBuf[a].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+    gapB = (opentimers_vars.timersBuf[b].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+
+    return gapA<gapB || (gapA==gapB && a<b);
+}
+
+void opentimers_heapSet(uint8_t pos, opentimers_id_t id){
+    opentimers_vars.heap[pos]                = id;
+    opentimers_vars.timersBuf[id].heapIndex  = pos;
+}
+
+void opentimers_heapSiftUp(uint8_t pos){
+    opentimers_id_t id;
+    uint8_t         parent;
+
+    id = opentimers_vars.heap[pos];
+    while (pos>0){
+        parent = (pos-1)/2;
+        if (opentimers_heapIsBefore(id,opentimers_vars.heap[parent])==FALSE){
+            break;
+        }
+        opentimers_heapSet(pos,opentimers_vars.heap[parent]);
+        pos = parent;
+    }
+    opentimers_heapSet(pos,id);
+}
+
+void opentimers_heapSiftDown(uint8_t pos){
+    opentimers_id_t id;
+    uint8_t         child;
+
+    id = opentimers_vars.heap[pos];
+    while (2*pos+1<opentimers_vars.heapSize){
+        child = 2*pos+1;
+        if (
+            child+1<opentimers_vars.heapSize &&
+            opentimers_heapIsBefore(opentimers_vars.heap[child+1],opentimers_vars.heap[child])
+        ){
+            child++;
+        }
+        if (opentimers_heapIsBefore(opentimers_vars.heap[child],id)==FALSE){
+            break;
+        }
+        opentimers_heapSet(pos,opentimers_vars.heap[child]);
+        pos = child;
+    }
+    opentimers_heapSet(pos,id);
+}
+
+/**
+\brief Add a timer to the heap, or move it if it is already running.
+
+The compare value of the timer must be set. The timer is marked as running.
+ */
+void opentimers_heapInsert(opentimers_id_t id){
+    uint8_t pos;
+
+    if (opentimers_vars.timersBuf[id].isrunning && opentimers_vars.timersBuf[id].hasExpired==FALSE){
+        // the compare value changed, restore the order from its position
+        pos = opentimers_vars.timersBuf[id].heapIndex;
+        opentimers_heapSiftUp(pos);
+        opentimers_heapSiftDown(opentimers_vars.timersBuf[id].heapIndex);
+        return;
+    }
+    opentimers_vars.timersBuf[id].isrunning  = TRUE;
+    opentimers_vars.timersBuf[id].hasExpired = FALSE;
+    opentimers_heapSet(opentimers_vars.heapSize,id);
+    opentimers_vars.heapSize++;
+    opentimers_heapSiftUp(opentimers_vars.heapSize-1);
+}
+
+/**
+\brief Take a timer out of the heap, if it is in it.
+
+The timer is marked as not running.
+ */
+void opentimers_heapRemove(opentimers_id_t id){
+    uint8_t         pos;
+    opentimers_id_t last;
+
+    if (opentimers_vars.timersBuf[id].isrunning==FALSE){
+        return;
+    }
+    opentimers_vars.timersBuf[id].isrunning  = FALSE;
+    if (opentimers_vars.timersBuf[id].hasExpired){
+        // taken out of the heap by the interrupt handler already
+        opentimers_vars.timersBuf[id].hasExpired = FALSE;
+        return;
+    }
+
+    pos = opentimers_vars.timersBuf[id].heapIndex;
+    opentimers_vars.heapSize--;
+    if (pos<opentimers_vars.heapSize){
+        // fill the hole with the last entry
+        last = opentimers_vars.heap[opentimers_vars.heapSize];
+        opentimers_heapSet(pos,last);
+        opentimers_heapSiftUp(pos);
+        opentimers_heapSiftDown(opentimers_vars.timersBuf[last].heapIndex);
+    }
+}
+
+/**
+\brief Restore the heap order after the compare value of several timers changed.
+ */
+void opentimers_heapBuild(void){
+    uint8_t pos;
+
+    pos = opentimers_vars.heapSize/2;
+    while (pos>0){
+        pos--;
+        opentimers_heapSiftDown(pos);
     }
 }
\ No newline at end of file
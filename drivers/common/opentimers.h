@@ -19,10 +19,40 @@
 
 //=========================== define ==========================================
 
-/// Maximum number of timers that can run concurrently
-#define MAX_NUM_TIMERS             15
-#define MAX_TICKS_IN_SINGLE_CLOCK  PORT_MAX_TICKS_IN_SINGLE_CLOCK
 #define ERROR_NO_AVAILABLE_ENTRIES 255
+
+/// General purpose timers created by openserial (2), sixtop (3), msf (2), icmpv6rpl (2) and snapshot (1)
+#define OPENTIMERS_NUM_STACK       (9+OPENWSN_SNAPSHOT_C)
+/// Timers created by the fragmentation module, NUM_OF_CONCURRENT_TIMERS in frag.h
+#if OPENWSN_6LO_FRAGMENTATION_C
+#define OPENTIMERS_NUM_FRAG        (NUM_OF_VRBS+MAX_NUM_BIGPKTS)
+#else
+#define OPENTIMERS_NUM_FRAG        0
+#endif
+/// Timer created by the project for the Crazyflie syslink keepalive
+#ifdef CRAZYFLIE_NRF51822
+#define OPENTIMERS_NUM_BOARD       1
+#else
+#define OPENTIMERS_NUM_BOARD       0
+#endif
+/// Timers created by the applications, one per application and one per sensor for csensors
+#if OPENWSN_CSENSORS_C
+#include "sensors.h"
+#define OPENTIMERS_NUM_CSENSORS    NUMSENSORS
+#else
+#define OPENTIMERS_NUM_CSENSORS    0
+#endif
+#define OPENTIMERS_NUM_APPS        (OPENWSN_CEXAMPLE_C+OPENWSN_CINFRARED_C+OPENWSN_CJOIN_C+OPENWSN_CSTORM_C+ \
+                                    OPENWSN_UEXPIRATION_C+OPENWSN_UINJECT_C+OPENTIMERS_NUM_CSENSORS)
+
+/// Maximum number of timers that can run concurrently, by default sized for the enabled components
+#ifndef MAX_NUM_TIMERS
+#define MAX_NUM_TIMERS             (TIMER_NUMBER_NON_GENERAL+OPENTIMERS_NUM_STACK+OPENTIMERS_NUM_FRAG+ \
+                                    OPENTIMERS_NUM_BOARD+OPENTIMERS_NUM_APPS+OPENTIMERS_NUM_EXTRA)
+#endif
+#define OPENTIMERS_MAX_RESERVATIONS 4
+#define OPENTIMERS_NO_RESERVATION  0xff
+#define MAX_TICKS_IN_SINGLE_CLOCK  PORT_MAX_TICKS_IN_SINGLE_CLOCK
 #define MAX_DURATION_ISR           33 // 33@32768Hz = 1ms
 #define opentimers_id_t            uint8_t
 
@@ -32,6 +62,10 @@
 
 #define TIMER_NUMBER_NON_GENERAL   2
 
+#if MAX_NUM_TIMERS>=ERROR_NO_AVAILABLE_ENTRIES
+#error "MAX_NUM_TIMERS must be lower than ERROR_NO_AVAILABLE_ENTRIES"
+#endif
+
 #define SPLITE_TIMER_DURATION     15 // in ticks
 #define PRE_CALL_TIMER_WINDOW     PORT_TsSlotDuration
 
@@ -54,18 +88,50 @@ typedef struct {
    PORT_TIMER_WIDTH     currentCompareValue;// the current compare value
    uint16_t             wraps_remaining;    // the number of wraps timer is going to be fired after
    PORT_TIMER_WIDTH     lastCompareValue;   // the previous compare value
+   PORT_TIMER_WIDTH     nominalCompareValue;// when the timer is due, before it is delayed within its slack
    bool                 isrunning;          // is running?
    bool                 isUsed;             // true when this entry is occupied
    timer_type_t         timerType;          // the timer type
-   bool                 hasExpired;         // in case there are more than one interrupt occur at same time
+   bool                 hasExpired;         // taken out of the heap by the interrupt, not handled yet
+   uint8_t              heapIndex;          // position in the heap, when running
+   opentimers_id_t      nextFree;           // next timer in the free list, when not used
+   uint8_t              reservation;        // reservation the timer was taken from, or OPENTIMERS_NO_RESERVATION
+   PORT_TIMER_WIDTH     slack;              // how late the timer may fire, in ticks
    opentimers_cbt       callback;           // function to call when elapses
    uint8_t              timer_task_prio;    // when opentimer push a task, use timer_task_prio to mark the priority
 } opentimers_t;
 
+typedef struct {
+   uint8_t              component;          // component holding the reservation
+   uint8_t              numReserved;        // number of timers reserved
+   uint8_t              numUsed;            // number of reserved timers created
+} opentimers_reservation_t;
+
+BEGIN_PACK
+typedef struct {
+   uint8_t              poolSize;           // number of general purpose timers
+   uint8_t              numUsed;            // general purpose timers created
+   uint8_t              peakUsed;           // highest numUsed since boot
+   uint8_t              numReservedLeft;    // reserved timers not created yet
+   uint16_t             numCreateFailed;    // creations which found no free timer
+   uint16_t             numCoalesced;       // timers scheduled onto the wakeup of another timer
+} opentimers_stats_t;
+END_PACK
+
 //=========================== module variables ================================
 
 typedef struct {
    opentimers_t         timersBuf[MAX_NUM_TIMERS];
+   opentimers_id_t      heap[MAX_NUM_TIMERS];// ids of the running timers, as a min-heap on the compare value
+   uint8_t              heapSize;           // number of running timers
+   opentimers_id_t      freeList;           // first general purpose timer not used
+   uint8_t              numFree;            // number of general purpose timers not used
+   opentimers_reservation_t reservations[OPENTIMERS_MAX_RESERVATIONS];
+   uint8_t              numReservations;
+   uint8_t              numReservedLeft;    // reserved timers not created yet, kept in the free list
+   uint8_t              peakUsed;
+   uint16_t             numCreateFailed;
+   uint16_t             numCoalesced;
    bool                 running;
    PORT_TIMER_WIDTH     currentCompareValue;// current timeout, in ticks
    PORT_TIMER_WIDTH     lastCompareValue;   // last timeout, in ticks. This is the reference time to calculate the next to be expired timer.
@@ -76,11 +142,19 @@ typedef struct {
 
 void             opentimers_init(void);
 opentimers_id_t  opentimers_create(uint8_t timer_id, uint8_t task_priority);
+bool             opentimers_reserve(uint8_t component, uint8_t num);
+opentimers_id_t  opentimers_createReserved(uint8_t component, uint8_t task_prio);
 void             opentimers_scheduleIn(opentimers_id_t      id,
                                        uint32_t            duration,
                                        time_type_t         uint_type,
                                        timer_type_t        timer_type,
                                        opentimers_cbt      cb);
+void             opentimers_scheduleInWithSlack(opentimers_id_t      id,
+                                                uint32_t            duration,
+                                                time_type_t         uint_type,
+                                                timer_type_t        timer_type,
+                                                uint32_t            slack,
+                                                opentimers_cbt      cb);
 void             opentimers_scheduleAbsolute(opentimers_id_t      id,
                                               uint32_t            duration,
                                               PORT_TIMER_WIDTH    reference ,
@@ -94,6 +168,7 @@ bool             opentimers_destroy(opentimers_id_t id);
 PORT_TIMER_WIDTH opentimers_getValue(void);
 PORT_TIMER_WIDTH opentimers_getCurrentCompareValue(void);
 bool             opentimers_isRunning(opentimers_id_t id);
+void             opentimers_getStats(opentimers_stats_t* stats);
 /**
 \}
 \}
@@ -122,4 +122,12 @@
 #error "CoAP requires a transport layer, i.e. UDP or TCP."
 #endif
 
+#if SCHEDULER_PROFILE_ENABLE && !SCHEDULER_DEBUG_ENABLE
+#error "The scheduler profiler requires SCHEDULER_DEBUG_ENABLE."
+#endif
+
+#if OPENWSN_SNAPSHOT_C && !defined(PYTHON_BOARD)
+#error "The snapshot module requires the storage bsp module, which only the python board implements."
+#endif
+
 #endif /* OPENWSN_CHECK_CONFIG_H */
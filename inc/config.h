@@ -245,6 +245,8 @@
  *  - MAX_PKTSIZE_SUPPORTED: defines the maximum IPV6 packet size (header + payload) the mote supports. Default
  *  value is 1320. This corresponds to a 40-byte IPv6 header + the minimal IPv6 MTU of 1280 bytes.
  *  - MAX_NUM_BIGPKTS: defines how many static buffer space will be allocated for processing large packets.
+ *  - NUM_OF_VRBS: defines how many virtual reassembly buffers are kept, to forward fragments without reassembling
+ *  the packet.
  *
  */
 #ifndef OPENWSN_6LO_FRAGMENTATION_C
@@ -260,6 +262,10 @@
 #endif
 #endif
 
+#ifndef NUM_OF_VRBS
+#define NUM_OF_VRBS             2
+#endif
+
 /**
  * \def OPENWSN_ICMPV6ECHO_C
  *
@@ -304,6 +310,38 @@
 #endif
 
 
+/**
+ * \def OPENWSN_SNAPSHOT_C
+ *
+ * Periodically saves the negotiated cells, the neighbor table, the RPL parent and DODAG, and the link-layer keys to
+ * non-volatile storage (the "storage" bsp module). After a reset, once synchronized, the mote restores them instead of
+ * joining and negotiating its cells again, provided that the snapshot is recent enough and that the parent is heard.
+ * Only the python board implements the storage. The project 03oos_snapshot tests this module.
+ *
+ * Configuration options:
+ *  - SNAPSHOT_MAX_AGE: a snapshot taken more than this number of slots before the mote synchronizes is discarded.
+ *  - SNAPSHOT_PARENT_WAIT: number of seconds, after synchronizing, during which the mote waits to hear its parent
+ *  before discarding the snapshot.
+ *  - SNAPSHOT_SAVE_PERIOD: the snapshot is checked for changes and saved every SNAPSHOT_SAVE_PERIOD seconds.
+ *
+ */
+#ifndef OPENWSN_SNAPSHOT_C
+#define OPENWSN_SNAPSHOT_C (0)
+#endif
+
+#if OPENWSN_SNAPSHOT_C
+#ifndef SNAPSHOT_MAX_AGE
+#define SNAPSHOT_MAX_AGE            30000
+#endif
+#ifndef SNAPSHOT_PARENT_WAIT
+#define SNAPSHOT_PARENT_WAIT        30
+#endif
+#ifndef SNAPSHOT_SAVE_PERIOD
+#define SNAPSHOT_SAVE_PERIOD        10
+#endif
+#endif
+
+
 // ========================== Stack configuration ===========================
 
 /**
@@ -353,6 +391,111 @@
 #define IEEE802154E_SINGLE_CHANNEL      20
 #endif
 
+/**
+ * \def IEEE802154E_TIMING_ENABLE
+ *
+ * Records, in sctimer ticks, how long the TSCH slot FSM stays in each state and how far into the slot each state is
+ * entered. The time spent in a "prepare" state is the time taken by the activity preparing the radio, to compare with
+ * its budget (maxTxDataPrepare, maxRxAckPrepare, ...). The min/avg/max and histogram of each state are printed over
+ * serial as STATUS_IEEE154E_TIMING.
+ *
+ * Configuration options:
+ *  - IEEE802154E_TIMING_NUM_BINS: number of histogram bins. Bin 0 counts durations of 0 ticks, bin n durations in
+ *  [2^(n-1), 2^n[ ticks, the last bin all longer durations.
+ *
+ */
+#ifndef IEEE802154E_TIMING_ENABLE
+#define IEEE802154E_TIMING_ENABLE (0)
+#endif
+
+#if IEEE802154E_TIMING_ENABLE
+#ifndef IEEE802154E_TIMING_NUM_BINS
+#define IEEE802154E_TIMING_NUM_BINS     8
+#endif
+#endif
+
+/**
+ * \def IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+ *
+ * Hops only over the channels which work. Every IEEE802154E_HOPPING_EPOCH slots, the DAG root excludes the channels on
+ * which less than IEEE802154E_HOPPING_MIN_PDR percent of its transmissions were acknowledged and of its receptions had a
+ * valid CRC. The hopping sequence is the default template without the excluded channels. The channel hopping IE of the
+ * EBs carries the mask of the channels in use and the mask for the next epoch, which each mote takes from its preferred
+ * parent and applies at the start of the epoch. A mote which heard no EB of its parent during the epoch keeps its channels,
+ * and takes those of its parent from the next EB. An excluded channel is tried again after
+ * IEEE802154E_HOPPING_EXCLUDED_EPOCHS epochs.
+ *
+ * Configuration options:
+ *  - IEEE802154E_HOPPING_EPOCH: length of an epoch, in slots. A power of 2, at most 65536. It must leave enough time for
+ *  the next mask to reach the deepest motes through the EBs.
+ *  - IEEE802154E_HOPPING_MIN_SAMPLES: number of transmissions and receptions on a channel before it can be excluded.
+ *  - IEEE802154E_HOPPING_MIN_CHANNELS: minimum number of channels to hop over.
+ *
+ */
+#ifndef IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+#define IEEE802154E_ADAPTIVE_HOPPING_ENABLE (0)
+#endif
+
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+#ifndef IEEE802154E_HOPPING_EPOCH
+#define IEEE802154E_HOPPING_EPOCH           8192
+#endif
+
+#ifndef IEEE802154E_HOPPING_MIN_PDR
+#define IEEE802154E_HOPPING_MIN_PDR         50
+#endif
+
+#ifndef IEEE802154E_HOPPING_MIN_SAMPLES
+#define IEEE802154E_HOPPING_MIN_SAMPLES     20
+#endif
+
+#ifndef IEEE802154E_HOPPING_MIN_CHANNELS
+#define IEEE802154E_HOPPING_MIN_CHANNELS    4
+#endif
+
+#ifndef IEEE802154E_HOPPING_EXCLUDED_EPOCHS
+#define IEEE802154E_HOPPING_EXCLUDED_EPOCHS 8
+#endif
+#endif
+
+/**
+ * \def IEEE802154E_BURST_ENABLE
+ *
+ * Sends the frames queued for a neighbor in a burst over consecutive slots. When more frames wait for the same neighbor,
+ * the sender sets the frame pending bit. If its next slot is free, the receiver sets the frame pending bit in the ACK and
+ * listens in the next slot, on the channel offset of the cell the burst started in, where the sender sends the next
+ * frame. Neither cell nor 6P transaction is involved.
+ *
+ * Configuration options:
+ *  - IEEE802154E_BURST_MAX_SLOTS: maximum number of slots a burst takes after a scheduled cell.
+ *
+ */
+#ifndef IEEE802154E_BURST_ENABLE
+#define IEEE802154E_BURST_ENABLE (0)
+#endif
+
+#if IEEE802154E_BURST_ENABLE
+#ifndef IEEE802154E_BURST_MAX_SLOTS
+#define IEEE802154E_BURST_MAX_SLOTS     4
+#endif
+#endif
+
+/**
+ * \def IEEE802154E_CHANNEL_STATS_ENABLE
+ *
+ * Counts, for each channel, the unicast transmissions, the acknowledged ones, and the receptions with a valid and with
+ * a wrong CRC. They are printed over serial as STATUS_IEEE154E_CHANNELS. Always enabled with adaptive hopping, which
+ * relies on them.
+ *
+ */
+#ifndef IEEE802154E_CHANNEL_STATS_ENABLE
+#define IEEE802154E_CHANNEL_STATS_ENABLE IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+#endif
+
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE && !IEEE802154E_CHANNEL_STATS_ENABLE
+#error "IEEE802154E_ADAPTIVE_HOPPING_ENABLE requires IEEE802154E_CHANNEL_STATS_ENABLE"
+#endif
+
 /**
  * \def PACKETQUEUE_LENGTH
  *
@@ -361,7 +504,31 @@
  *
  */
 #ifndef PACKETQUEUE_LENGTH
-#define PACKETQUEUE_LENGTH              10
+#define PACKETQUEUE_LENGTH              11
+#endif
+
+/**
+ * \def OPENQUEUE_AQM
+ *
+ * Activates active queue management in openqueue: data packets which waited in the queue of a neighbor for longer than
+ * OPENQUEUE_AQM_TARGET slots during OPENQUEUE_AQM_INTERVAL slots get dropped (CoDel), rather than filling the queue.
+ *
+ */
+#ifndef OPENQUEUE_AQM
+#define OPENQUEUE_AQM (0)
+#endif
+
+/**
+ * \def STATIC_SCHEDULE
+ *
+ * Loads, at boot, the cells of this mote from a static schedule, generated at build time from a description of the
+ * deployment (stackcfg=static-schedule:<description>, see site_scons/staticSchedule.py). The cells are in a slotframe
+ * of their own, they are used as soon as the mote is synchronized and MSF does not negotiate cells to a parent to
+ * which the mote has static cells.
+ *
+ */
+#ifndef STATIC_SCHEDULE
+#define STATIC_SCHEDULE (0)
 #endif
 
 /**
@@ -454,6 +621,44 @@
 #define SCHEDULER_DEBUG_ENABLE (0)
 #endif
 
+/**
+ * \def SCHEDULER_PROFILE_ENABLE
+ *
+ * Records, in sctimer ticks, how long tasks wait in the scheduler queue (per priority) and how long each task callback
+ * runs. The histograms are printed over serial as STATUS_SCHEDULER.
+ *
+ * Configuration options:
+ *  - SCHEDULER_PROFILE_NUM_BINS: number of histogram bins. Bin 0 counts durations of 0 ticks, bin n durations in
+ *  [2^(n-1), 2^n[ ticks, the last bin all longer durations.
+ *  - SCHEDULER_PROFILE_NUM_CB: number of distinct task callbacks whose run-time is recorded.
+ *
+ * Requires: SCHEDULER_DEBUG_ENABLE
+ *
+ */
+#ifndef SCHEDULER_PROFILE_ENABLE
+#define SCHEDULER_PROFILE_ENABLE (0)
+#endif
+
+#if SCHEDULER_PROFILE_ENABLE
+#ifndef SCHEDULER_PROFILE_NUM_BINS
+#define SCHEDULER_PROFILE_NUM_BINS      10
+#endif
+#ifndef SCHEDULER_PROFILE_NUM_CB
+#define SCHEDULER_PROFILE_NUM_CB        8
+#endif
+#endif
+
+/**
+ * \def OPENTIMERS_NUM_EXTRA
+ *
+ * Number of general purpose timers added to the opentimers pool for project code. The rest of the pool is sized from
+ * the enabled stack components and applications, unless MAX_NUM_TIMERS is set. Set with stackcfg=timers:<n>.
+ *
+ */
+#ifndef OPENTIMERS_NUM_EXTRA
+#define OPENTIMERS_NUM_EXTRA            4
+#endif
+
 #include "check_config.h"
 
 #endif /* OPENWSN_CONFIG_H */
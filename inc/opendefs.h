@@ -122,7 +122,11 @@ enum {
     STATUS_KAPERIOD = 10,
     STATUS_JOINED = 11,
     STATUS_MSF = 12,
-    STATUS_MAX = 13,
+    STATUS_OPENTIMERS = 13,
+    STATUS_SCHEDULER = 14,
+    STATUS_IEEE154E_TIMING = 15,
+    STATUS_IEEE154E_CHANNELS = 16,
+    STATUS_MAX = 17,
 };
 
 // component identifiers, order is important
@@ -188,6 +192,7 @@ enum {
    COMPONENT_UEXPIRATION               = 0x2b,
    COMPONENT_UMONITOR                  = 0x2c,
    COMPONENT_CINFRARED                 = 0x2d,
+   COMPONENT_SNAPSHOT                  = 0x2e,
    COMPONENT_CCRAZYFLIE                = 0x30, //Lan HUANG Aug 2024 add
 };
 
@@ -290,6 +295,10 @@ enum {
    ERR_INVALID_PARAM                   = 0x53, // received an invalid parameter
    ERR_COPY_TO_SPKT                    = 0x54, // copy packet content to small packet (pkt len {} < max len {})
    ERR_COPY_TO_BPKT                    = 0x55, // copy packet content to big packet (pkt len {} > max len {})
+   ERR_AQM_DROP                        = 0x56, // queue management dropped a packet created by component {0} ({1} drops)
+   ERR_SNAPSHOT_RESTORED               = 0x57, // snapshot restored, {0} cells and {1} neighbors
+   ERR_SNAPSHOT_DISCARDED              = 0x58, // snapshot discarded (0: too old, 1: parent not heard), reason {0}
+   ERR_TASK_SHED                       = 0x59, // task of priority {0} shed, the task list was full ({1} tasks shed)
 };
 
 //=========================== typedef =========================================
@@ -341,6 +350,8 @@ typedef struct {
    uint16_t      max_delay;                                     // Max delay in milliseconds before which the packet should be delivered to the receiver
    bool          orgination_time_flag;
    bool          drop_flag;
+   bool          has_expiration_asn;                            // expiration_asn is set
+   asn_t         expiration_asn;                                // ASN after which the packet is useless, set by iphc
 #endif
    bool          is_cjoin_response;
 #if OPENWSN_6LO_FRAGMENTATION_C
@@ -362,6 +373,8 @@ typedef struct {
 
 #if OPENWSN_6LO_FRAGMENTATION_C
     bool         l3_isFragment;
+    uint8_t      l3_nextSegment;                                // openqueue index of the entry holding the rest of a split packet
+    uint8_t      l3_segmentLength;                              // bytes held in this entry when the packet is split
 #endif
     //l2
     owerror_t l2_sendDoneError;                                // outcome of trying to send this packet
@@ -372,8 +385,7 @@ typedef struct {
     uint8_t l2_numTxAttempts;                                  // number Tx attempts
     asn_t l2_asn;                                              // at what ASN the packet was Tx'ed or Rx'ed
     uint8_t *l2_payload;                                       // pointer to the start of the payload of l2 (used for MAC to fill in ASN in ADV)
-    cellInfo_ht l2_sixtop_celllist_add[CELLLIST_MAX_LEN];      // record celllist to be added and will be added when 6P response sendDone
-    cellInfo_ht l2_sixtop_celllist_delete[CELLLIST_MAX_LEN];   // record celllist to be removed and will be removed when 6P response sendDone
+    uint8_t l2_sixtop_cellListsHandle;                         // celllists to be added/removed when 6P response sendDone, kept by openqueue
     uint16_t l2_sixtop_frameID;                                // frameID in 6P message
     uint8_t l2_sixtop_messageType;                             // indicating the sixtop message type
     uint8_t l2_sixtop_command;                                 // command of the received 6p request, recorded in 6p response
@@ -1,6 +1,14 @@
 /**
 \brief OpenOS scheduler.
 
+Pending tasks are kept in one FIFO per priority level. A bitmap with one bit
+per priority level records which FIFOs are not empty, so that both pushing and
+popping a task take constant time, independently of the number of pending
+tasks.
+
+When the queue is full, tasks are shed by priority rather than resetting the
+board, see scheduler_enqueue(). Each shed task is logged as ERR_TASK_SHED.
+
 \author Thomas Watteyne <watteyne@eecs.berkeley.edu>, February 2012.
 */
 
@@ -9,8 +17,11 @@
 #include "board.h"
 #include "debugpins.h"
 #include "leds.h"
+#include "openserial.h"
+#if SCHEDULER_PROFILE_ENABLE
+#include "sctimer.h"
+#endif
 
-#include "cf_crazyflie.h"
 
 //=========================== variables =======================================
 
@@ -20,13 +31,35 @@ scheduler_vars_t scheduler_vars;
 scheduler_dbg_t scheduler_dbg;
 #endif
 
+/**
+\brief Position of a bit in a 32-bit word with a single bit set.
+
+Indexed by the upper 5 bits of the product of that word with the de Bruijn
+sequence 0x077CB531.
+*/
+static const uint8_t scheduler_debruijn_pos[32] = {
+    0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+   31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9,
+};
+
 //=========================== prototypes ======================================
 
-void consumeTask(uint8_t taskId);
+static task_prio_t scheduler_enqueue(task_cbt cb, task_prio_t prio, bool isProtected);
+static taskList_item_t* scheduler_dequeue(uint8_t prio, taskList_item_t* previous);
+static taskList_item_t* scheduler_shed(task_prio_t prio, bool isProtected);
+static void scheduler_coalesce(task_cbt cb, task_prio_t prio, bool isProtected);
+static void scheduler_logShed(task_prio_t shedPrio);
+static uint8_t scheduler_findFirstSet(uint32_t bitmap);
+static uint8_t scheduler_findLastSet(uint32_t bitmap);
+#if SCHEDULER_PROFILE_ENABLE
+static void scheduler_profile_record(scheduler_histogram_t* histogram, PORT_TIMER_WIDTH duration);
+static void scheduler_profile_runTime(task_cbt cb, PORT_TIMER_WIDTH duration);
+#endif
 
 //=========================== public ==========================================
 
 void scheduler_init(void) {
+    uint8_t i;
 
     // initialization module variables
     memset(&scheduler_vars,0,sizeof(scheduler_vars_t));
@@ -34,41 +67,38 @@ void scheduler_init(void) {
     memset(&scheduler_dbg,0,sizeof(scheduler_dbg_t));
 #endif
 
+    // chain all task containers into the free list
+    for (i=0;i<TASK_LIST_DEPTH+TASK_LIST_RESERVED-1;i++) {
+        scheduler_vars.taskBuf[i].next = &scheduler_vars.taskBuf[i+1];
+    }
+    scheduler_vars.freeList = &scheduler_vars.taskBuf[0];
+    scheduler_vars.numFree  = TASK_LIST_DEPTH+TASK_LIST_RESERVED;
+
     // enable the scheduler's interrupt so SW can wake up the scheduler
     SCHEDULER_ENABLE_INTERRUPT();
 }
 
 void scheduler_start(void) {
-    taskList_item_t* pThisTask;
+    task_cbt cb;
+#if SCHEDULER_PROFILE_ENABLE
+    PORT_TIMER_WIDTH startTime;
+#endif
     while (1) {
-        
-        // crazyflie task
-        crazyflieHandle();
-      
-        while(scheduler_vars.task_list!=NULL) {
-         // there is still at least one task in the linked-list of tasks
-
-         INTERRUPT_DECLARATION();
-         DISABLE_INTERRUPTS();
-
-         // the task to execute is the one at the head of the queue
-         pThisTask                = scheduler_vars.task_list;
+        while(scheduler_vars.prioBitmap!=0) {
+         // there is still at least one task pending
 
-         // shift the queue by one task
-         scheduler_vars.task_list = pThisTask->next;
-
-         ENABLE_INTERRUPTS();
+         cb = scheduler_pop_task();
 
          // execute the current task
-         pThisTask->cb();
-
-         // free up this task container
-         pThisTask->cb            = NULL;
-         pThisTask->prio          = TASKPRIO_NONE;
-         pThisTask->next          = NULL;
-#if SCHEDULER_DEBUG_ENABLE
-         scheduler_dbg.numTasksCur--;
+         if (cb!=NULL) {
+#if SCHEDULER_PROFILE_ENABLE
+            startTime = sctimer_readCounter();
+            cb();
+            scheduler_profile_runTime(cb,sctimer_readCounter()-startTime);
+#else
+            cb();
 #endif
+         }
       }
       debugpins_task_clr();
       board_sleep();
@@ -77,51 +107,96 @@ void scheduler_start(void) {
 }
 
 void scheduler_push_task(task_cbt cb, task_prio_t prio) {
+    task_prio_t       shedPrio;
+    INTERRUPT_DECLARATION();
+
+    DISABLE_INTERRUPTS();
+    shedPrio = scheduler_enqueue(cb,prio,FALSE);
+    ENABLE_INTERRUPTS();
+
+    scheduler_logShed(shedPrio);
+}
+
+/**
+\brief Push a task, unless the same callback is already pending.
+
+Meant for tasks which only signal that some work is to be done, such as the
+callbacks of periodic timers, for which running the callback once is enough
+however many times it was pushed. Do not use it for tasks which each process
+one item (e.g. one packet).
+
+The check only walks the tasks pending at priority prio.
+*/
+void scheduler_push_task_coalesce(task_cbt cb, task_prio_t prio) {
+    scheduler_coalesce(cb,prio,FALSE);
+}
+
+/**
+\brief Push a task which is never shed, unless the same callback is already pending.
+
+Meant for tasks whose owner waits for them to run, such as the callbacks of
+one-shot timers, which are not called again if the task is lost. Such a task
+is never shed to make room for another one, and may use the reserved task
+containers, like the tasks of priority TASKPRIO_CRITICAL or more urgent. It is
+coalesced as with scheduler_push_task_coalesce().
+*/
+void scheduler_push_task_protected(task_cbt cb, task_prio_t prio) {
+    scheduler_coalesce(cb,prio,TRUE);
+}
+
+/**
+\brief Remove the highest priority pending task.
+
+Among tasks of the same priority, the one pushed first is returned first. The
+task container is released before returning.
+
+\returns The callback of the task, or NULL if no task is pending.
+*/
+task_cbt scheduler_pop_task(void) {
     taskList_item_t*  taskContainer;
-    taskList_item_t** taskListWalker;
+    task_cbt          cb;
+    uint8_t           prio;
     INTERRUPT_DECLARATION();
 
     DISABLE_INTERRUPTS();
 
-    // find an empty task container
-    taskContainer = &scheduler_vars.taskBuf[0];
-    while (taskContainer->cb!=NULL &&
-          taskContainer<=&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-       taskContainer++;
+    if (scheduler_vars.prioBitmap==0) {
+       ENABLE_INTERRUPTS();
+       return NULL;
     }
-    if (taskContainer>&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-       // task list has overflown. This should never happpen!
 
-       // we can not print from within the kernel. Instead:
-       // blink the error LED
-       leds_error_blink();
-       // reset the board
-       board_reset();
-    }
-    // fill that task container with this task
-    taskContainer->cb              = cb;
-    taskContainer->prio            = prio;
-
-    // find position in queue
-    taskListWalker                 = &scheduler_vars.task_list;
-    while (*taskListWalker!=NULL &&
-          (*taskListWalker)->prio <= taskContainer->prio) {
-       taskListWalker              = (taskList_item_t**)&((*taskListWalker)->next);
-    }
-    // insert at that position
-    taskContainer->next            = *taskListWalker;
-    *taskListWalker                = taskContainer;
-    // maintain debug stats
-#if SCHEDULER_DEBUG_ENABLE
-    scheduler_dbg.numTasksCur++;
-    if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
-        scheduler_dbg.numTasksMax   = scheduler_dbg.numTasksCur;
-    }
+    // the task to execute is the one at the head of the highest priority FIFO
+    prio                           = scheduler_findFirstSet(scheduler_vars.prioBitmap);
+    taskContainer                  = scheduler_dequeue(prio,NULL);
+
+#if SCHEDULER_PROFILE_ENABLE
+    scheduler_profile_record(
+        &scheduler_dbg.queueDelay[prio],
+        sctimer_readCounter()-taskContainer->pushTime
+    );
 #endif
 
+    // free up this task container
+    cb                             = taskContainer->cb;
+    taskContainer->cb              = NULL;
+    taskContainer->prio            = TASKPRIO_NONE;
+    taskContainer->isProtected     = FALSE;
+    taskContainer->next            = scheduler_vars.freeList;
+    scheduler_vars.freeList        = taskContainer;
+    scheduler_vars.numFree++;
+
     ENABLE_INTERRUPTS();
+
+    return cb;
+}
+
+uint16_t scheduler_get_numTasksShed(void) {
+    return scheduler_vars.numTasksShed;
 }
 
+uint16_t scheduler_get_numTasksCoalesced(void) {
+    return scheduler_vars.numTasksCoalesced;
+}
 
 #if SCHEDULER_DEBUG_ENABLE
 uint8_t scheduler_debug_get_TasksCur(void)
@@ -134,4 +209,337 @@ uint8_t scheduler_debug_get_TasksMax(void)
    return scheduler_dbg.numTasksMax;
 }
 #endif
+
+#if SCHEDULER_PROFILE_ENABLE
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+Each call prints one row: first the queueing delay histogram of each
+priority, then the run-time histogram of each profiled callback.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_scheduler(void) {
+    debugSchedulerProfileEntry_t temp;
+    scheduler_histogram_t*       histogram;
+    INTERRUPT_DECLARATION();
+
+    // increment the row just printed
+    scheduler_dbg.debugPrintRow = (scheduler_dbg.debugPrintRow+1)%(TASKPRIO_MAX+1+SCHEDULER_PROFILE_NUM_CB);
+
+    // gather status data
+    temp.row                      = scheduler_dbg.debugPrintRow;
+    if (temp.row<=TASKPRIO_MAX) {
+        temp.type                 = SCHEDULER_PROFILE_QUEUEDELAY;
+        temp.id                   = temp.row;
+        histogram                 = &scheduler_dbg.queueDelay[temp.row];
+    } else {
+        temp.type                 = SCHEDULER_PROFILE_RUNTIME;
+        temp.id                   = (uint32_t)(uintptr_t)scheduler_dbg.cbProfile[temp.row-(TASKPRIO_MAX+1)].cb;
+        histogram                 = &scheduler_dbg.cbProfile[temp.row-(TASKPRIO_MAX+1)].runTime;
+    }
+
+    //<<<<<<<<<<<<<<<<<<<<<<<
+    DISABLE_INTERRUPTS();
+    temp.numTasksCur              = scheduler_dbg.numTasksCur;
+    temp.numTasksMax              = scheduler_dbg.numTasksMax;
+    temp.numCbNotProfiled         = scheduler_dbg.numCbNotProfiled;
+    temp.numTasksShed             = scheduler_vars.numTasksShed;
+    temp.numTasksCoalesced        = scheduler_vars.numTasksCoalesced;
+    temp.max                      = histogram->max;
+    memcpy(temp.bins,histogram->bins,sizeof(temp.bins));
+    ENABLE_INTERRUPTS();
+    //>>>>>>>>>>>>>>>>>>>>>>>
+
+    // send status data over serial port
+    openserial_printStatus(STATUS_SCHEDULER,(uint8_t*)&temp,sizeof(debugSchedulerProfileEntry_t));
+
+    return TRUE;
+}
+#endif
 //=========================== private =========================================
+
+/**
+\brief Push a task, unless the same callback is already pending at that priority.
+*/
+static void scheduler_coalesce(task_cbt cb, task_prio_t prio, bool isProtected) {
+    taskList_item_t*  taskWalker;
+    task_prio_t       shedPrio;
+    INTERRUPT_DECLARATION();
+
+    DISABLE_INTERRUPTS();
+    for (
+        taskWalker  = scheduler_vars.fifo[prio].head;
+        taskWalker != NULL;
+        taskWalker  = taskWalker->next
+    ) {
+        if (taskWalker->cb==cb) {
+            if (scheduler_vars.numTasksCoalesced<0xffff) {
+                scheduler_vars.numTasksCoalesced++;
+            }
+            // the pending task is protected if any of its pushes is
+            taskWalker->isProtected   |= isProtected;
+            ENABLE_INTERRUPTS();
+            return;
+        }
+    }
+    shedPrio = scheduler_enqueue(cb,prio,isProtected);
+    ENABLE_INTERRUPTS();
+
+    scheduler_logShed(shedPrio);
+}
+
+/**
+\brief Append a task to the FIFO of its priority.
+
+Interrupts must be disabled when calling this function.
+
+Tasks of priority TASKPRIO_CRITICAL or more urgent are protected, as are tasks
+pushed with scheduler_push_task_protected(). When all general task containers
+are in use, only protected tasks can use the TASK_LIST_RESERVED reserved ones.
+
+If no container is available, the oldest unprotected task of the least urgent
+priority is shed, provided it is less urgent than the new task or the new task
+is protected. Otherwise, an unprotected new task is shed. A protected task is
+never shed; the board is only reset when the queue is full of those.
+
+\returns The priority of the shed task, TASKPRIO_NONE if no task was shed.
+*/
+static task_prio_t scheduler_enqueue(task_cbt cb, task_prio_t prio, bool isProtected) {
+    taskList_item_t*  taskContainer;
+    taskList_fifo_t*  fifo;
+    task_prio_t       shedPrio;
+
+    if (prio<=TASKPRIO_CRITICAL) {
+        isProtected = TRUE;
+    }
+
+    shedPrio = TASKPRIO_NONE;
+    if (
+        scheduler_vars.numFree>TASK_LIST_RESERVED ||
+        (isProtected && scheduler_vars.numFree>0)
+    ) {
+        // take an empty task container from the free list
+        taskContainer                  = scheduler_vars.freeList;
+        scheduler_vars.freeList        = taskContainer->next;
+        scheduler_vars.numFree--;
+    } else {
+        // task list is full, shed an unprotected task
+        taskContainer = scheduler_shed(prio,isProtected);
+        if (taskContainer!=NULL) {
+            // reuse the container of the shed task
+            shedPrio                   = taskContainer->prio;
+        } else if (isProtected==FALSE) {
+            // drop the new task
+            shedPrio                   = prio;
+        } else {
+            // only protected tasks are pending. This should never happpen!
+
+            // we can not print from within the kernel. Instead:
+            // blink the error LED
+            leds_error_blink();
+            // reset the board
+            board_reset();
+            return TASKPRIO_NONE;
+        }
+        if (scheduler_vars.numTasksShed<0xffff) {
+            scheduler_vars.numTasksShed++;
+        }
+        if (taskContainer==NULL) {
+            return shedPrio;
+        }
+    }
+
+    // fill that task container with this task
+    taskContainer->cb                  = cb;
+    taskContainer->prio                = prio;
+    taskContainer->isProtected         = isProtected;
+    taskContainer->next                = NULL;
+#if SCHEDULER_PROFILE_ENABLE
+    taskContainer->pushTime            = sctimer_readCounter();
+#endif
+
+    // append to the FIFO of that priority
+    fifo                               = &scheduler_vars.fifo[prio];
+    if (fifo->tail==NULL) {
+       fifo->head                      = taskContainer;
+       scheduler_vars.prioBitmap      |= ((uint32_t)1)<<prio;
+    } else {
+       fifo->tail->next                = taskContainer;
+    }
+    fifo->tail                         = taskContainer;
+    // maintain debug stats
+#if SCHEDULER_DEBUG_ENABLE
+    scheduler_dbg.numTasksCur++;
+    if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
+        scheduler_dbg.numTasksMax      = scheduler_dbg.numTasksCur;
+    }
+#endif
+
+    return shedPrio;
+}
+
+/**
+\brief Unlink a task of a non-empty priority FIFO.
+
+Interrupts must be disabled when calling this function.
+
+\param[in] prio     The priority of the FIFO.
+\param[in] previous The task before the one to unlink, NULL to unlink the
+    oldest task.
+*/
+static taskList_item_t* scheduler_dequeue(uint8_t prio, taskList_item_t* previous) {
+    taskList_item_t*  taskContainer;
+    taskList_fifo_t*  fifo;
+
+    fifo                               = &scheduler_vars.fifo[prio];
+    if (previous==NULL) {
+       taskContainer                   = fifo->head;
+       fifo->head                      = taskContainer->next;
+    } else {
+       taskContainer                   = previous->next;
+       previous->next                  = taskContainer->next;
+    }
+    if (fifo->tail==taskContainer) {
+       fifo->tail                      = previous;
+    }
+    if (fifo->head==NULL) {
+       scheduler_vars.prioBitmap      &= ~(((uint32_t)1)<<prio);
+    }
+#if SCHEDULER_DEBUG_ENABLE
+    scheduler_dbg.numTasksCur--;
+#endif
+
+    return taskContainer;
+}
+
+/**
+\brief Unlink the task to shed to make room for a new task.
+
+Interrupts must be disabled when calling this function.
+
+The FIFOs are searched from the least urgent priority, for the oldest task
+which is not protected. Only the priorities less urgent than the one of the
+new task are searched, unless the new task is protected.
+
+\returns The container of the unlinked task, or NULL if no task can be shed.
+*/
+static taskList_item_t* scheduler_shed(task_prio_t prio, bool isProtected) {
+    taskList_item_t*  previous;
+    taskList_item_t*  taskWalker;
+    uint32_t          bitmap;
+    uint8_t           victimPrio;
+
+    bitmap = scheduler_vars.prioBitmap;
+    while (bitmap!=0) {
+        victimPrio = scheduler_findLastSet(bitmap);
+        if (victimPrio<=TASKPRIO_CRITICAL || (isProtected==FALSE && victimPrio<=prio)) {
+            // all the remaining tasks are protected or at least as urgent
+            break;
+        }
+        previous = NULL;
+        for (
+            taskWalker  = scheduler_vars.fifo[victimPrio].head;
+            taskWalker != NULL;
+            taskWalker  = taskWalker->next
+        ) {
+            if (taskWalker->isProtected==FALSE) {
+                return scheduler_dequeue(victimPrio,previous);
+            }
+            previous = taskWalker;
+        }
+        bitmap &= ~(((uint32_t)1)<<victimPrio);
+    }
+    return NULL;
+}
+
+/**
+\brief Report a shed task over serial.
+
+Called with interrupts enabled, after the task list was updated.
+*/
+static void scheduler_logShed(task_prio_t shedPrio) {
+    if (shedPrio==TASKPRIO_NONE) {
+        return;
+    }
+    LOG_ERROR(
+        COMPONENT_OPENWSN,
+        ERR_TASK_SHED,
+        (errorparameter_t) shedPrio,
+        (errorparameter_t) scheduler_vars.numTasksShed
+    );
+}
+
+/**
+\brief Index of the least significant bit set in a non-zero bitmap.
+
+Uses a de Bruijn multiplication rather than a count-trailing-zeros
+instruction, which is not available on all the supported MCUs.
+*/
+static uint8_t scheduler_findFirstSet(uint32_t bitmap) {
+    return scheduler_debruijn_pos[((uint32_t)((bitmap & (~bitmap+1))*0x077CB531UL))>>27];
+}
+
+/**
+\brief Index of the most significant bit set in a non-zero bitmap.
+*/
+static uint8_t scheduler_findLastSet(uint32_t bitmap) {
+    // set all bits below the most significant one
+    bitmap |= bitmap>>1;
+    bitmap |= bitmap>>2;
+    bitmap |= bitmap>>4;
+    bitmap |= bitmap>>8;
+    bitmap |= bitmap>>16;
+    // keep only the most significant one
+    return scheduler_findFirstSet(bitmap-(bitmap>>1));
+}
+
+#if SCHEDULER_PROFILE_ENABLE
+/**
+\brief Add a duration to a histogram.
+
+Bin 0 counts durations of 0 ticks, bin n durations in [2^(n-1), 2^n[ ticks.
+Counters saturate rather than wrap around.
+*/
+static void scheduler_profile_record(scheduler_histogram_t* histogram, PORT_TIMER_WIDTH duration) {
+    uint8_t          bin;
+    PORT_TIMER_WIDTH remaining;
+
+    bin       = 0;
+    remaining = duration;
+    while (remaining!=0 && bin<SCHEDULER_PROFILE_NUM_BINS-1) {
+        remaining >>= 1;
+        bin++;
+    }
+    if (histogram->bins[bin]<0xffff) {
+        histogram->bins[bin]++;
+    }
+    if (duration>histogram->max) {
+        histogram->max = (duration>0xffff)?0xffff:(uint16_t)duration;
+    }
+}
+
+/**
+\brief Record the run-time of a task callback.
+
+Callbacks get a profile entry the first time they run. Once all entries are
+taken, executions of other callbacks are only counted.
+*/
+static void scheduler_profile_runTime(task_cbt cb, PORT_TIMER_WIDTH duration) {
+    uint8_t i;
+
+    for (i=0;i<SCHEDULER_PROFILE_NUM_CB;i++) {
+        if (scheduler_dbg.cbProfile[i].cb==cb || scheduler_dbg.cbProfile[i].cb==NULL) {
+            scheduler_dbg.cbProfile[i].cb = cb;
+            scheduler_profile_record(&scheduler_dbg.cbProfile[i].runTime,duration);
+            return;
+        }
+    }
+    if (scheduler_dbg.numCbNotProfiled<0xffff) {
+        scheduler_dbg.numCbNotProfiled++;
+    }
+}
+#endif
@@ -13,21 +13,70 @@
 typedef struct task_llist_t {
    task_cbt                       cb;
    task_prio_t                    prio;
+   bool                           isProtected;              // never shed when the list is full
    void*                          next;
+#if SCHEDULER_PROFILE_ENABLE
+   PORT_TIMER_WIDTH               pushTime;                 // sctimer value when pushed
+#endif
 } taskList_item_t;
 
 typedef struct {
-   taskList_item_t                taskBuf[TASK_LIST_DEPTH];
-   taskList_item_t*               task_list;
+   taskList_item_t*               head;
+   taskList_item_t*               tail;
+} taskList_fifo_t;
+
+typedef struct {
+   taskList_item_t                taskBuf[TASK_LIST_DEPTH+TASK_LIST_RESERVED];
+   taskList_item_t*               freeList;                 // unused task containers
+   uint8_t                        numFree;                  // number of containers in freeList
+   taskList_fifo_t                fifo[TASKPRIO_MAX+1];     // one FIFO per priority
+   uint32_t                       prioBitmap;               // bit n set iff fifo[n] not empty
+   uint16_t                       numTasksShed;             // tasks dropped because the queue was full
+   uint16_t                       numTasksCoalesced;        // pushes merged with an identical pending task
 } scheduler_vars_t;
 
+#if SCHEDULER_PROFILE_ENABLE
+typedef struct {
+   uint16_t                       bins[SCHEDULER_PROFILE_NUM_BINS];
+   uint16_t                       max;                      // longest duration seen, in ticks
+} scheduler_histogram_t;
+
+typedef struct {
+   task_cbt                       cb;
+   scheduler_histogram_t          runTime;
+} scheduler_cbProfile_t;
+#endif
+
 #if SCHEDULER_DEBUG_ENABLE
 typedef struct {
    uint8_t                        numTasksCur;
    uint8_t                        numTasksMax;
+#if SCHEDULER_PROFILE_ENABLE
+   scheduler_histogram_t          queueDelay[TASKPRIO_MAX+1];
+   scheduler_cbProfile_t          cbProfile[SCHEDULER_PROFILE_NUM_CB];
+   uint16_t                       numCbNotProfiled;         // executions of callbacks not fitting in cbProfile
+   uint8_t                        debugPrintRow;
+#endif
 } scheduler_dbg_t;
 #endif
 
+#if SCHEDULER_PROFILE_ENABLE
+BEGIN_PACK
+typedef struct {
+   uint8_t                        row;
+   uint8_t                        numTasksCur;
+   uint8_t                        numTasksMax;
+   uint8_t                        type;                     // SCHEDULER_PROFILE_QUEUEDELAY or _RUNTIME
+   uint32_t                       id;                       // priority, or callback address
+   uint16_t                       numCbNotProfiled;
+   uint16_t                       numTasksShed;
+   uint16_t                       numTasksCoalesced;
+   uint16_t                       max;
+   uint16_t                       bins[SCHEDULER_PROFILE_NUM_BINS];
+} debugSchedulerProfileEntry_t;
+END_PACK
+#endif
+
 /**
 \}
 \}
@@ -29,13 +29,22 @@ typedef enum {
     TASKPRIO_MSF                   = 0x0b,
     // tasks trigger by other interrupts
     TASKPRIO_BUTTON                = 0x0c,
-    TASKPRIO_SIXTOP_TIMEOUT        = 0x0d,
-    TASKPRIO_SNIFFER               = 0x0e,
-    TASKPRIO_OPENSERIAL            = 0X0f,
-    TASKPRIO_MAX                   = 0x10,
+    TASKPRIO_CRAZYFLIE             = 0x0d,
+    TASKPRIO_SIXTOP_TIMEOUT        = 0x0e,
+    TASKPRIO_SNIFFER               = 0x0f,
+    TASKPRIO_OPENSERIAL            = 0X10,
+    TASKPRIO_MAX                   = 0x11,
 } task_prio_t;
 
 #define TASK_LIST_DEPTH           10
+#define TASK_LIST_RESERVED        2                             // extra containers only for protected tasks
+#define TASKPRIO_CRITICAL         TASKPRIO_SIXTOP_NOTIF_TXDONE  // least urgent priority never shed
+
+#if SCHEDULER_PROFILE_ENABLE
+// types of rows printed in STATUS_SCHEDULER
+#define SCHEDULER_PROFILE_QUEUEDELAY     0
+#define SCHEDULER_PROFILE_RUNTIME        1
+#endif
 
 //=========================== typedef =========================================
 
@@ -49,12 +58,21 @@ typedef void (*task_cbt)(void);
 void scheduler_init(void);
 void scheduler_start(void);
 void scheduler_push_task(task_cbt task_cb, task_prio_t prio);
+void scheduler_push_task_coalesce(task_cbt task_cb, task_prio_t prio);
+void scheduler_push_task_protected(task_cbt task_cb, task_prio_t prio);
+task_cbt scheduler_pop_task(void);
+uint16_t scheduler_get_numTasksShed(void);
+uint16_t scheduler_get_numTasksCoalesced(void);
 
 #if SCHEDULER_DEBUG_ENABLE
 uint8_t scheduler_debug_get_TasksCur(void);
 uint8_t scheduler_debug_get_TasksMax(void);
 #endif
 
+#if SCHEDULER_PROFILE_ENABLE
+bool debugPrint_scheduler(void);
+#endif
+
 #include "openos/scheduler_types.h"
 
 /**
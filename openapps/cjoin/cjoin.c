@@ -215,6 +215,12 @@ void cjoin_task_cb(void) {
         return;
     }
 
+    // don't run if already joined, e.g. after restoring a snapshot
+    if (cjoin_getIsJoined() == TRUE) {
+        opentimers_cancel(cjoin_vars.timerId);
+        return;
+    }
+
     joinProxy = neighbors_getJoinProxy();
     if (joinProxy == NULL) {
         return;
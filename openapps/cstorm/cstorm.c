@@ -65,11 +65,12 @@ void cstorm_init(void) {
     cstorm_vars.period           = 6553;
 
     cstorm_vars.timerId          = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_COAP);
-    opentimers_scheduleIn(
+    opentimers_scheduleInWithSlack(
         cstorm_vars.timerId,
         cstorm_vars.period,
         TIME_MS,
         TIMER_PERIODIC,
+        cstorm_vars.period/10,
         cstorm_timer_cb
     );
     */
@@ -126,11 +127,12 @@ owerror_t cstorm_receive(
             opentimers_cancel(cstorm_vars.timerId);
 
             if(cstorm_vars.period > 0) {
-                  opentimers_scheduleIn(
+                  opentimers_scheduleInWithSlack(
                       cstorm_vars.timerId,
                       cstorm_vars.period,
                       TIME_MS,
                       TIMER_PERIODIC,
+                      cstorm_vars.period/10,
                       cstorm_timer_cb
                   );
             }
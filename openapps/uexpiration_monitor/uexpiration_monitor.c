@@ -9,7 +9,7 @@
 #include "openserial.h"
 #include "packetfunctions.h"
 
-#ifdef DEADLINE_OPTION
+#if DEADLINE_OPTION
 #include "iphc.h"
 #endif
 
@@ -29,13 +29,18 @@ void _sock_handler(sock_udp_t *sock, sock_async_flags_t type, void *arg) {
         sock_udp_ep_t remote;
             size_t len = 0;
         if (sock_udp_recv(sock, buf, sizeof(buf), 0, &remote) >= 0) {
-#ifdef DEADLINE_OPTION
+#if DEADLINE_OPTION
             monitor_expiration_vars_t deadline = { 0 };
             iphc_getDeadlineInfo(&deadline);
             memcpy(&buf[0], &deadline.time_elapsed, sizeof(uint16_t));
             memcpy(&buf[2], &deadline.time_left, sizeof(int16_t));
+            memcpy(&buf[4], &deadline.num_met, sizeof(uint16_t));
+            memcpy(&buf[6], &deadline.num_missed, sizeof(uint16_t));
+            memcpy(&buf[8], &deadline.num_dropped, sizeof(uint16_t));
+            memcpy(&buf[10], &deadline.num_failed, sizeof(uint16_t));
             len += sizeof(uint16_t);
             len += sizeof(int16_t);
+            len += 4 * sizeof(uint16_t);
 #endif
             if (sock_udp_send(sock, (char*) buf, len, &remote) < 0) {
                 LOG_ERROR(COMPONENT_UMONITOR, ERR_PUSH_LOWER_LAYER,
@@ -58,6 +58,15 @@ else:
             time_elapsed_ms = time_elapsed * slotDuration            
             time_left = n[3] << 8 | n[2]
             time_left_ms = time_left * slotDuration
+            # packets with an expiration time this mote sent in time, late, or dropped
+            if len(n) >= 10:
+                num_met     = n[5] << 8 | n[4]
+                num_missed  = n[7] << 8 | n[6]
+                num_dropped = n[9] << 8 | n[8]
+                print 'Deadline met : {0}\tmissed : {1}\tdropped : {2}'.format(num_met,num_missed,num_dropped)
+            if len(n) >= 12:
+                num_failed  = n[11] << 8 | n[10]
+                print 'Deadline failed : {0}'.format(num_failed)
                         
             
             if(time_elapsed != 0):
@@ -63,11 +63,12 @@ void uinject_init(void) {
     // start periodic timer
     uinject_vars.period = UINJECT_PERIOD_MS;
     uinject_vars.timerId = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_UDP);
-    opentimers_scheduleIn(
+    opentimers_scheduleInWithSlack(
             uinject_vars.timerId,
             UINJECT_PERIOD_MS,
             TIME_MS,
             TIMER_PERIODIC,
+            UINJECT_SLACK_MS,
             _uinject_timer_cb
     );
 }
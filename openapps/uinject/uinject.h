@@ -15,6 +15,7 @@
 //=========================== define ==========================================
 
 #define UINJECT_PERIOD_MS 60000
+#define UINJECT_SLACK_MS  (UINJECT_PERIOD_MS/10) // how late a packet may be sent, to share a wakeup
 
 //=========================== typedef =========================================
 
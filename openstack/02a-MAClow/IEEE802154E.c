@@ -4,6 +4,7 @@
 #include "radio.h"
 #include "IEEE802154.h"
 #include "IEEE802154_security.h"
+#include "IEEE802154_ie.h"
 #include "openqueue.h"
 #include "idmanager.h"
 #include "openserial.h"
@@ -18,16 +19,12 @@
 #include "sctimer.h"
 #include "openrandom.h"
 #include "msf.h"
+#include "asn_events.h"
+#include "asnfunctions.h"
 
 //#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=
-#include "cf_api_commander_high_level.h"
-#include "cf_crazyflie.h"
-#include "cf_param.h"
 #include "single_status_led.h"
-#include "cf_movement_queue.h"
 #define bool uint8_t
-asn_t target_asn;
-PORT_TIMER_WIDTH asn_diff;
 //#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=
 
 //=========================== definition ======================================
@@ -37,6 +34,12 @@ PORT_TIMER_WIDTH asn_diff;
 ieee154e_vars_t ieee154e_vars;
 ieee154e_stats_t ieee154e_stats;
 ieee154e_dbg_t ieee154e_dbg;
+#if IEEE802154E_TIMING_ENABLE
+ieee154e_timing_t ieee154e_timing;
+#endif
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+ieee154e_channels_t ieee154e_channels;
+#endif
 
 //=========================== prototypes ======================================
 
@@ -123,6 +126,12 @@ void timeslotTemplateIDStoreFromEB(uint8_t id);
 
 void channelhoppingTemplateIDStoreFromEB(uint8_t id);
 
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+
+void channelMaskStoreFromEB(OpenQueueEntry_t *pkt, uint16_t channelMask, uint16_t nextChannelMask);
+
+#endif
+
 // ASN handling
 void incrementAsnOffset(void);
 
@@ -130,6 +139,8 @@ void ieee154e_resetAsn(void);
 
 void ieee154e_syncSlotOffset(void);
 
+void ieee154e_inferAsnOffset(void);
+
 void asnStoreFromEB(uint8_t *asn);
 
 void joinPriorityStoreFromEB(uint8_t jp);
@@ -141,6 +152,12 @@ void synchronizeAck(PORT_SIGNED_INT_WIDTH timeCorrection);
 
 void changeIsSync(bool newIsSync);
 
+#if IEEE802154E_BURST_ENABLE
+// burst
+bool burstCanContinue(void);
+
+#endif
+
 // notifying upper layer
 void notif_sendDone(OpenQueueEntry_t *packetSent, owerror_t error);
 
@@ -151,11 +168,33 @@ void resetStats(void);
 
 void updateStats(PORT_SIGNED_INT_WIDTH timeCorrection);
 
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+
+void recordChannelTx(bool isAcked);
+
+void recordChannelRx(bool isCrcValid);
+
+#endif
+
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+
+void updateChannelMask(void);
+
+void applyChannelMask(uint16_t channelMask);
+
+#endif
+
 // misc
 uint8_t calculateFrequency(uint8_t channelOffset);
 
 void changeState(ieee154e_state_t newstate);
 
+#if IEEE802154E_TIMING_ENABLE
+
+void recordStateTiming(ieee154e_state_t oldState, ieee154e_state_t newState);
+
+#endif
+
 void endSlot(void);
 
 bool debugPrint_asn(void);
@@ -179,15 +218,15 @@ during boot-up.
 */
 void ieee154e_init(void) {
 
-    //#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=
-    target_asn.byte4 = 0x00;
-    target_asn.bytes2and3 = 0x0000;
-    target_asn.bytes0and1 = 0x0800;
-    //#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=
-
     // initialize variables
     memset(&ieee154e_vars, 0, sizeof(ieee154e_vars_t));
     memset(&ieee154e_dbg, 0, sizeof(ieee154e_dbg_t));
+#if IEEE802154E_TIMING_ENABLE
+    memset(&ieee154e_timing, 0, sizeof(ieee154e_timing_t));
+#endif
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+    memset(&ieee154e_channels, 0, sizeof(ieee154e_channels_t));
+#endif
 
     // set singleChannel to 0 to enable channel hopping.
 #if IEEE802154E_SINGLE_CHANNEL
@@ -202,6 +241,10 @@ void ieee154e_init(void) {
 
     // default hopping template
     memcpy(&(ieee154e_vars.chTemplate[0]), chTemplate_default, sizeof(ieee154e_vars.chTemplate));
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+    applyChannelMask(CHANNELHOPPING_ALL_CHANNELS);
+    ieee154e_vars.nextChannelMask = CHANNELHOPPING_ALL_CHANNELS;
+#endif
 
     if (idmanager_getIsDAGroot() == TRUE) {
         changeIsSync(TRUE);
@@ -236,108 +279,47 @@ void ieee154e_init(void) {
 //=========================== public ==========================================
 
 /**
-/brief Difference between some older ASN and the current ASN.
+\brief Number of slots since some older ASN.
 
 \param[in] someASN some ASN to compare to the current
 
-\returns The ASN difference, or 0xffff if more than 65535 different
+\returns The ASN difference, saturated to the largest PORT_TIMER_WIDTH value,
+   which is also returned if someASN is after the current ASN.
 */
 PORT_TIMER_WIDTH ieee154e_asnDiff(asn_t *someASN) {
-    PORT_TIMER_WIDTH diff;
+    int32_t diff;
     INTERRUPT_DECLARATION();
+
     DISABLE_INTERRUPTS();
-    if (ieee154e_vars.asn.byte4 != someASN->byte4) {
-        ENABLE_INTERRUPTS();
-        return (PORT_TIMER_WIDTH) 0xFFFFFFFF;;
-    }
-
-    diff = 0;
-    if (ieee154e_vars.asn.bytes2and3 == someASN->bytes2and3) {
-        ENABLE_INTERRUPTS();
-        return ieee154e_vars.asn.bytes0and1 - someASN->bytes0and1;
-    } else if (ieee154e_vars.asn.bytes2and3 - someASN->bytes2and3 == 1) {
-        diff = ieee154e_vars.asn.bytes0and1;
-        diff += 0xffff - someASN->bytes0and1;
-        diff += 1;
-    } else {
-        diff = (PORT_TIMER_WIDTH) 0xFFFFFFFF;;
-    }
+    diff = asnfunctions_diff(&ieee154e_vars.asn, someASN);
     ENABLE_INTERRUPTS();
-    return diff;
-}
-
-#if DEADLINE_OPTION
-/**
-/brief Difference between two ASN values
-
-\param[in] h_asn bigger ASN value
-\param[in] l_asn smaller ASN value
-
-\returns The ASN difference, or 0xffff if more than 65535 different
-*/
-int16_t ieee154e_computeAsnDiff(asn_t *h_asn, asn_t *l_asn) {
-    int16_t diff;
 
-    if (h_asn->byte4 != l_asn->byte4) {
-        return (int16_t) 0xFFFFFFFF;
+    if (diff < 0 || (uint32_t) diff > (PORT_TIMER_WIDTH) 0xFFFFFFFF) {
+        return (PORT_TIMER_WIDTH) 0xFFFFFFFF;
     }
-
-    diff = 0;
-    if (h_asn->bytes2and3 == l_asn->bytes2and3) {
-        return h_asn->bytes0and1 - l_asn->bytes0and1;
-    } else if (h_asn->bytes2and3 - l_asn->bytes2and3 == 1) {
-        diff = h_asn->bytes0and1;
-        diff += 0xffff - l_asn->bytes0and1;
-        diff += 1;
-    } else {
-        diff = (int16_t) 0xFFFFFFFF;
-    }
-    return diff;
+    return (PORT_TIMER_WIDTH) diff;
 }
 
+#if DEADLINE_OPTION
 /**
-/brief Determine Expiration Time in ASN
+\brief Determine the expiration time of a packet.
 
 \param[in]  max_delay Maximum permissible delay before which
-            packet is expected to reach destination
+            packet is expected to reach destination, in ms
 
-\param[out] et_asn bigger ASN value
+\param[out] et_asn    ASN at which the packet expires
 */
-void ieee154e_calculateExpTime(uint16_t max_delay, uint8_t *et_asn) {
-    uint8_t delay_array[5];
-    uint8_t i = 0, carry = 0, slot_time = 0;
-    uint16_t sum = 0, delay_in_asn = 0;
-
-    memset(&delay_array[0], 0, 5);
-
-    //Slot time = (Duration in ticks * Time equivalent ticks w.r.t 32kHz) in ms
-    slot_time = (ieee154e_getSlotDuration() * 305) / 10000;
-    delay_in_asn = max_delay / slot_time;
-
-    delay_array[0] = (delay_in_asn & 0xff);
-    delay_array[1] = (delay_in_asn / 256 & 0xff);
-
-    ieee154e_getAsn(&et_asn[0]);
-    for (i = 0; i < 5; i++) {
-        sum = et_asn[i] + delay_array[i] + carry;
-        et_asn[i] = sum & 0xFF;
-        carry = ((sum >> 8) & 0xFF);
-    }
-}
-
-/**
-/brief Format asn to asn_t structure
+void ieee154e_calculateExpTime(uint16_t max_delay, asn_t *et_asn) {
+    INTERRUPT_DECLARATION();
 
-\param[in]  in  asn value represented in array format
+    DISABLE_INTERRUPTS();
+    memcpy(et_asn, &ieee154e_vars.asn, sizeof(asn_t));
+    ENABLE_INTERRUPTS();
 
-\param[out] val_asn   asn value represented in asn_t format
-*/
-void ieee154e_orderToASNStructure(uint8_t *in, asn_t *val_asn) {
-    val_asn->bytes0and1 = in[0] + 256 * in[1];
-    val_asn->bytes2and3 = in[2] + 256 * in[3];
-    val_asn->byte4 = in[4];
+    asnfunctions_add(et_asn, asnfunctions_msToSlots(max_delay));
 }
 #endif
+
 //======= events
 
 /**
@@ -600,6 +582,91 @@ bool debugPrint_macStats(void) {
     return TRUE;
 }
 
+#if IEEE802154E_TIMING_ENABLE
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+Each call prints the timing of one state of the slot FSM.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_macTiming(void) {
+    debugIeee154eTimingEntry_t temp;
+    ieee154e_stateTiming_t *timing;
+    INTERRUPT_DECLARATION();
+
+    // increment the row just printed
+    ieee154e_timing.debugPrintRow = (ieee154e_timing.debugPrintRow + 1) % IEEE802154E_TIMING_NUM_STATES;
+
+    // gather status data
+    temp.state = ieee154e_timing.debugPrintRow;
+    timing = &ieee154e_timing.states[temp.state];
+
+    //<<<<<<<<<<<<<<<<<<<<<<<
+    DISABLE_INTERRUPTS();
+    temp.count = timing->count;
+    temp.min = timing->min;
+    temp.avg = (timing->count == 0) ? 0 : (uint16_t) (timing->sum / timing->count);
+    temp.max = timing->max;
+    temp.maxEntryOffset = timing->maxEntryOffset;
+    memcpy(temp.bins, timing->bins, sizeof(temp.bins));
+    ENABLE_INTERRUPTS();
+    //>>>>>>>>>>>>>>>>>>>>>>>
+
+    // send status data over serial port
+    openserial_printStatus(STATUS_IEEE154E_TIMING, (uint8_t * ) & temp, sizeof(debugIeee154eTimingEntry_t));
+
+    return TRUE;
+}
+#endif
+
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+Each call prints the statistics of one channel.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_macChannels(void) {
+    debugIeee154eChannelEntry_t temp;
+    ieee154e_channelStats_t *stats;
+    INTERRUPT_DECLARATION();
+
+    // increment the row just printed
+    ieee154e_channels.debugPrintRow = (ieee154e_channels.debugPrintRow + 1) % NUM_CHANNELS;
+
+    // gather status data
+    temp.channel = 11 + ieee154e_channels.debugPrintRow;
+    stats = &ieee154e_channels.channels[ieee154e_channels.debugPrintRow];
+
+    //<<<<<<<<<<<<<<<<<<<<<<<
+    DISABLE_INTERRUPTS();
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+    temp.isHopping = (ieee154e_vars.channelMask & (1 << ieee154e_channels.debugPrintRow)) != 0;
+#else
+    temp.isHopping = TRUE;
+#endif
+    temp.numTx = stats->numTx;
+    temp.numTxAck = stats->numTxAck;
+    temp.numRx = stats->numRx;
+    temp.numRxCrcError = stats->numRxCrcError;
+    ENABLE_INTERRUPTS();
+    //>>>>>>>>>>>>>>>>>>>>>>>
+
+    // send status data over serial port
+    openserial_printStatus(STATUS_IEEE154E_CHANNELS, (uint8_t * ) & temp, sizeof(debugIeee154eChannelEntry_t));
+
+    return TRUE;
+}
+#endif
+
 //=========================== private =========================================
 
 //======= SYNCHRONIZING
@@ -897,20 +964,13 @@ port_INLINE void activity_synchronize_endOfFrame(PORT_TIMER_WIDTH capturedTime)
 }
 
 port_INLINE bool ieee154e_processIEs(OpenQueueEntry_t* pkt, uint16_t* lenIE) {
-    uint8_t i;
     if (isValidEbFormat(pkt, lenIE) == TRUE){
         // At this point, ASN and frame length are known and the current slotoffset can be inferred
         ieee154e_syncSlotOffset();
         schedule_syncSlotOffset(ieee154e_vars.slotOffset);
         ieee154e_vars.nextActiveSlotOffset = schedule_getNextActiveSlotOffset();
 
-        /* infer the asnOffset based on the fact that ieee154e_vars.freq = 11 + (asnOffset + channelOffset)%16 */
-        for (i = 0; i < NUM_CHANNELS; i++){
-            if ((ieee154e_vars.freq - 11) == ieee154e_vars.chTemplate[i]){
-                break;
-            }
-        }
-        ieee154e_vars.asnOffset = i - schedule_getChannelOffset();
+        ieee154e_inferAsnOffset();
         return TRUE;
     } else {
         // wrong eb format
@@ -928,10 +988,20 @@ port_INLINE void activity_ti1ORri1(void) {
     uint8_t asn[5];
     uint8_t join_priority;
     bool couldSendEB = FALSE;
+#if IEEE802154E_BURST_ENABLE
+    ieee154e_burst_t burst;
+#endif
 
     // increment ASN (do this first so debug pins are in sync)
     incrementAsnOffset();
 
+#if IEEE802154E_BURST_ENABLE
+    // a burst only goes on in the slot right after its last frame
+    burst = ieee154e_vars.burst;
+    ieee154e_vars.burst = BURST_NONE;
+    ieee154e_vars.burstFramePending = FALSE;
+#endif
+
     // wiggle debug pins
     debugpins_slot_toggle();
     if (ieee154e_vars.slotOffset == 0) {
@@ -981,6 +1051,10 @@ port_INLINE void activity_ti1ORri1(void) {
     ieee154e_vars.nextActiveSlotOffset = schedule_getNextActiveSlotOffset();
     if (ieee154e_vars.slotOffset == ieee154e_vars.nextActiveSlotOffset) {
         // this is the next active slot
+#if IEEE802154E_BURST_ENABLE
+        burst = BURST_NONE;
+        ieee154e_vars.burstNumSlots = 0;
+#endif
 
         // advance the schedule
         schedule_advanceSlot();
@@ -1009,9 +1083,15 @@ port_INLINE void activity_ti1ORri1(void) {
 
             //increase ASN by numOfSleepSlots-1 slots as at this slot is already incremented by 1
             for (i = 0; i < ieee154e_vars.numOfSleepSlots - 1; i++) {
-                incrementAsnOffset(); // TODO: Waking from sleep can result in intensive calls of multiple commands, which may lead to some blocking.
+                incrementAsnOffset(); // the ASN events of the skipped slots are pushed as tasks, not run here
             }
         }
+#if IEEE802154E_BURST_ENABLE
+    } else if (burst != BURST_NONE) {
+        // this slot continues a burst, on the channel offset of the cell it started in
+        ieee154e_vars.freq = calculateFrequency(schedule_getChannelOffset());
+        ieee154e_vars.burstNumSlots++;
+#endif
     } else {
         // this is NOT the next active slot, abort
         endSlot();
@@ -1020,6 +1100,13 @@ port_INLINE void activity_ti1ORri1(void) {
 
     // check the schedule to see what type of slot this is
     cellType = schedule_getType();
+#if IEEE802154E_BURST_ENABLE
+    if (burst == BURST_TX) {
+        cellType = CELLTYPE_TX;
+    } else if (burst == BURST_RX) {
+        cellType = CELLTYPE_RX;
+    }
+#endif
     switch (cellType) {
         case CELLTYPE_TXRX:
         case CELLTYPE_TX:
@@ -1029,9 +1116,21 @@ port_INLINE void activity_ti1ORri1(void) {
             schedule_getNeighbor(&neighbor);
 
             // check whether we can send
+#if IEEE802154E_BURST_ENABLE
+            if (burst == BURST_TX) {
+                // send the next frame of the burst
+                ieee154e_vars.dataToSend = openqueue_macGetUnicastPacket(&ieee154e_vars.burstNeighbor);
+            } else if (schedule_getOkToSend()) {
+#else
             if (schedule_getOkToSend()) {
+#endif
                 if (packetfunctions_isBroadcastMulticast(&neighbor) == FALSE) {
 
+#if OPENQUEUE_AQM
+                    // drop the packets which have been waiting for too long
+                    openqueue_macAqmCheck(&neighbor);
+#endif
+
                     // look for a unicast packet to send
                     ieee154e_vars.dataToSend = openqueue_macGetUnicastPacket(&neighbor);
 
@@ -1039,7 +1138,7 @@ port_INLINE void activity_ti1ORri1(void) {
                         ieee154e_vars.dataToSend = openqueue_macGetKaPacket(&neighbor);
                     }
 
-                    if (schedule_getShared() == FALSE) {
+                    if (schedule_getShared() == FALSE && schedule_getIsDefaultSlotframe()) {
                         // update numCellElapsed and numCellUsed on managed Tx cell
                         if (ieee154e_vars.dataToSend != NULL) {
                             ieee154e_vars.dataToSend->l2_sendOnTxCell = TRUE;
@@ -1069,12 +1168,30 @@ port_INLINE void activity_ti1ORri1(void) {
                 changeState(S_TXDATAOFFSET);
                 // change owner
                 ieee154e_vars.dataToSend->owner = COMPONENT_IEEE802154E;
+#if IEEE802154E_BURST_ENABLE
+                // announce the next frame to the neighbor, if it can follow in the next slot
+                ieee154e_vars.burstFramePending =
+                        packetfunctions_isBroadcastMulticast(&ieee154e_vars.dataToSend->l2_nextORpreviousHop) == FALSE &&
+                        burstCanContinue() &&
+                        openqueue_getNumTxPackets(&ieee154e_vars.dataToSend->l2_nextORpreviousHop) > 1;
+#endif
                 if (couldSendEB == TRUE) { // I will be sending an EB copy synch IE -- should be Little endian?
                     // fill in the ASN field of the EB
                     ieee154e_getAsn(asn);
                     join_priority = (icmpv6rpl_getMyDAGrank() / MINHOPRANKINCREASE) - 1; //poipoi -- use dagrank(rank)-1
                     memcpy(ieee154e_vars.dataToSend->l2_ASNpayload, &asn[0], sizeof(asn_t));
                     memcpy(ieee154e_vars.dataToSend->l2_ASNpayload + sizeof(asn_t), &join_priority, sizeof(uint8_t));
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+                    // fill in the channel masks of the channel hopping IE, little endian
+                    ieee154e_vars.dataToSend->l2_ASNpayload[EB_CH_MASK_OFFSET - EB_ASN0_OFFSET] =
+                            (uint8_t)(ieee154e_vars.channelMask & 0x00FF);
+                    ieee154e_vars.dataToSend->l2_ASNpayload[EB_CH_MASK_OFFSET - EB_ASN0_OFFSET + 1] =
+                            (uint8_t)(ieee154e_vars.channelMask >> 8);
+                    ieee154e_vars.dataToSend->l2_ASNpayload[EB_CH_MASK_OFFSET - EB_ASN0_OFFSET + 2] =
+                            (uint8_t)(ieee154e_vars.nextChannelMask & 0x00FF);
+                    ieee154e_vars.dataToSend->l2_ASNpayload[EB_CH_MASK_OFFSET - EB_ASN0_OFFSET + 3] =
+                            (uint8_t)(ieee154e_vars.nextChannelMask >> 8);
+#endif
                 }
                 // record that I attempt to transmit this packet
                 ieee154e_vars.dataToSend->l2_numTxAttempts++;
@@ -1084,6 +1201,13 @@ port_INLINE void activity_ti1ORri1(void) {
                 // prepare the packet for load packet action at DURATION_tt1
                 // make a local copy of the frame
                 packetfunctions_duplicatePacket(&ieee154e_vars.localCopyForTransmission, ieee154e_vars.dataToSend);
+#if IEEE802154E_BURST_ENABLE
+                if (ieee154e_vars.burstFramePending == TRUE) {
+                    // set the frame pending bit in the local copy only, the next attempt decides again
+                    ieee154e_vars.localCopyForTransmission.payload[0] |=
+                            IEEE154_PENDING_YES_FRAMEPENDING << IEEE154_FCF_FRAME_PENDING;
+                }
+#endif
 
                 // check if packet needs to be encrypted/authenticated before transmission
                 if (ieee154e_vars.localCopyForTransmission.l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) { // security enabled
@@ -1184,6 +1308,13 @@ port_INLINE void activity_ti2(void) {
     );
     // make a local copy of the frame
     packetfunctions_duplicatePacket(&ieee154e_vars.localCopyForTransmission, ieee154e_vars.dataToSend);
+#if IEEE802154E_BURST_ENABLE
+    if (ieee154e_vars.burstFramePending == TRUE) {
+        // set the frame pending bit in the local copy only, the next attempt decides again
+        ieee154e_vars.localCopyForTransmission.payload[0] |=
+                IEEE154_PENDING_YES_FRAMEPENDING << IEEE154_FCF_FRAME_PENDING;
+    }
+#endif
 
     // check if packet needs to be encrypted/authenticated before transmission
     if (ieee154e_vars.localCopyForTransmission.l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) { // security enabled
@@ -1436,6 +1567,9 @@ port_INLINE void activity_ti7(void) {
 port_INLINE void activity_tie5(void) {
     // indicate transmit failed to schedule to keep stats
     schedule_indicateTx(&ieee154e_vars.asn, FALSE);
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+    recordChannelTx(FALSE);
+#endif
 
     // decrement transmits left counter
     ieee154e_vars.dataToSend->l2_retriesLeft--;
@@ -1609,6 +1743,14 @@ port_INLINE void activity_ti9(PORT_TIMER_WIDTH capturedTime) {
             break;
         }
 
+#if IEEE802154E_BURST_ENABLE
+        if (ieee154e_vars.burstFramePending == TRUE && ieee802514_header.framePending == TRUE) {
+            // the neighbor listens in the next slot, send it the next frame then
+            ieee154e_vars.burst = BURST_TX;
+            memcpy(&ieee154e_vars.burstNeighbor, &ieee154e_vars.dataToSend->l2_nextORpreviousHop, sizeof(open_addr_t));
+        }
+#endif
+
         if (idmanager_getIsDAGroot() == FALSE &&
             icmpv6rpl_isPreferredParent(&(ieee154e_vars.ackReceived->l2_nextORpreviousHop))) {
             synchronizeAck(ieee802514_header.timeCorrection);
@@ -1616,6 +1758,9 @@ port_INLINE void activity_ti9(PORT_TIMER_WIDTH capturedTime) {
 
         // inform schedule of successful transmission
         schedule_indicateTx(&ieee154e_vars.asn, TRUE);
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+        recordChannelTx(TRUE);
+#endif
 
         // inform upper layer
         notif_sendDone(ieee154e_vars.dataToSend, E_SUCCESS);
@@ -1808,6 +1953,10 @@ port_INLINE void activity_ri5(PORT_TIMER_WIDTH capturedTime) {
         // toss CRC (2 last bytes)
         packetfunctions_tossFooter(&ieee154e_vars.dataReceived, LENGTH_CRC);
 
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+        recordChannelRx(ieee154e_vars.dataReceived->l1_crc);
+#endif
+
         // if CRC doesn't check, stop
         if (ieee154e_vars.dataReceived->l1_crc == FALSE) {
             // jump to the error code below this do-while loop
@@ -1887,6 +2036,18 @@ port_INLINE void activity_ri5(PORT_TIMER_WIDTH capturedTime) {
         ieee154e_vars.dataReceived->l2_timeCorrection = (PORT_SIGNED_INT_WIDTH)(
                 (PORT_SIGNED_INT_WIDTH) TsTxOffset - (PORT_SIGNED_INT_WIDTH) ieee154e_vars.syncCapturedTime);
 
+#if IEEE802154E_BURST_ENABLE
+        if (
+                ieee802514_header.framePending == TRUE &&
+                ieee802514_header.ackRequested == 1 &&
+                ieee154e_vars.isAckEnabled == TRUE &&
+                burstCanContinue()
+                ) {
+            // the sender has more frames for me, listen in the next slot and tell it in the ACK
+            ieee154e_vars.burst = BURST_RX;
+        }
+#endif
+
         // check if ack requested
         if (ieee802514_header.ackRequested == 1 && ieee154e_vars.isAckEnabled == TRUE) {
 #ifdef SLOT_FSM_IMPLEMENTATION_MULTIPLE_TIMER_INTERRUPT
@@ -1929,6 +2090,12 @@ port_INLINE void activity_ri5(PORT_TIMER_WIDTH capturedTime) {
                     ieee154e_vars.dataReceived->l2_dsn,
                     &(ieee154e_vars.dataReceived->l2_nextORpreviousHop)
             );
+#if IEEE802154E_BURST_ENABLE
+            if (ieee154e_vars.burst == BURST_RX) {
+                // tell the sender I listen in the next slot
+                ieee154e_vars.ackToSend->payload[0] |= IEEE154_PENDING_YES_FRAMEPENDING << IEEE154_FCF_FRAME_PENDING;
+            }
+#endif
 
             // if security is enabled, encrypt directly in OpenQueue as there are no retransmissions for ACKs
             if (ieee154e_vars.ackToSend->l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) {
@@ -2064,6 +2231,12 @@ port_INLINE void activity_ri6(void) {
                              ieee154e_vars.dataReceived->l2_dsn,
                              &(ieee154e_vars.dataReceived->l2_nextORpreviousHop)
     );
+#if IEEE802154E_BURST_ENABLE
+    if (ieee154e_vars.burst == BURST_RX) {
+        // tell the sender I listen in the next slot
+        ieee154e_vars.ackToSend->payload[0] |= IEEE154_PENDING_YES_FRAMEPENDING << IEEE154_FCF_FRAME_PENDING;
+    }
+#endif
 
     // if security is enabled, encrypt directly in OpenQueue as there are no retransmissions for ACKs
     if (ieee154e_vars.ackToSend->l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) {
@@ -2276,67 +2449,10 @@ port_INLINE void incrementAsnOffset(void) {
         }
     }
 
-
-    //#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=
-    asn_diff = ieee154e_asnDiff(&target_asn);
-    if (ieee154e_vars.isSync){
-        
-        // new scheduling
-        //INTERRUPT_DECLARATION();
-        //DISABLE_INTERRUPTS();
-        //cf_movement_queue_handle(&ieee154e_vars.asn);
-        //ENABLE_INTERRUPTS();
-        
-        //status_led_set(LED_BLINK_LSS);
-        if (asn_diff == 0)
-        {
-           high_level_enable();
-           //leds_all_on();
-        }
-        if (asn_diff == 50)
-        {
-           high_level_takeoff(0.7, 1.0, 0.0);
-           //param_read(10);
-        }
-
-        if (asn_diff > 50 && asn_diff < 600)
-        {
-           cf_movement_queue_handle(&ieee154e_vars.asn);
-        }
-        //if (asn_diff == 100)
-        //{
-        //    high_level_goto(0.5, 0.0, 0.0, 0.0, 1.0, TRUE);
-        //}
-        
-        //if (asn_diff == 200)
-        //{
-        //    high_level_goto(0.0, 0.5, 0.0, 0.0, 1.0, TRUE);
-        //}
-
-        //if (asn_diff == 300)
-        //{
-        //    high_level_goto(-0.5, 0.0, 0.0, 0.0, 1.0, TRUE);
-        //}
-        
-        //if (asn_diff == 400)
-        //{
-        //    high_level_goto(0.0, -0.5, 0.0, 0.0, 1.0, TRUE);
-        //}
-
-        //if (asn_diff == 500)
-        //{
-        //    high_level_land(0.0, 1.0, 0.0);
-        //    //high_level_goto(-0.5, 0.0, 0.0, 0.0, 1.0, TRUE);
-        //}
-        if (asn_diff >= 600 && asn_diff < 9999999)
-        {
-           crazyflieEmergencyStop(); 
-           //leds_all_off();
-           crazyflieShutdown();
-        }
+    // dispatch the events registered for this slot
+    if (ieee154e_vars.isSync) {
+        asn_events_indicateAsn(&ieee154e_vars.asn);
     }
-    //#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=#=
-
 
     // increment the offsets
     frameLength = schedule_getFrameLength();
@@ -2345,7 +2461,24 @@ port_INLINE void incrementAsnOffset(void) {
     } else {
         ieee154e_vars.slotOffset = (ieee154e_vars.slotOffset + 1) % frameLength;
     }
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+    if ((ieee154e_vars.asn.bytes0and1 & (IEEE802154E_HOPPING_EPOCH - 1)) == 0) {
+        // start of an epoch, switch to the channels announced for it
+        if (ieee154e_vars.isNextChannelMaskConfirmed == FALSE) {
+            // no EB of the preferred parent announced them, keep the current ones until one does
+            ieee154e_vars.nextChannelMask = ieee154e_vars.channelMask;
+        }
+        ieee154e_vars.isNextChannelMaskConfirmed = FALSE;
+        applyChannelMask(ieee154e_vars.nextChannelMask);
+        if (idmanager_getIsDAGroot() == TRUE) {
+            updateChannelMask();
+        }
+    } else {
+        ieee154e_vars.asnOffset = (ieee154e_vars.asnOffset + 1) % ieee154e_vars.numHoppingChannels;
+    }
+#else
     ieee154e_vars.asnOffset = (ieee154e_vars.asnOffset + 1) % NUM_CHANNELS;
+#endif
 }
 
 port_INLINE void ieee154e_resetAsn(void) {
@@ -2432,21 +2565,10 @@ bool isValidJoin(OpenQueueEntry_t *eb, ieee802154_header_iht *parsedHeader) {
 
 bool isValidEbFormat(OpenQueueEntry_t *pkt, uint16_t *lenIE) {
 
-    bool chTemplate_checkPass;
-    bool tsTemplate_checkpass;
-    bool sync_ie_checkPass;
-    bool slotframelink_ie_checkPass;
+    ieee802154_ie_index_t ieIndex;
+    uint8_t *ie;
 
-    uint8_t ptr;
     uint16_t temp16b;
-    bool mlme_ie_found;
-    uint8_t mlme_ie_content_offset;
-    uint8_t ielen;
-
-    uint8_t subtype;
-    uint8_t sublen;
-    uint8_t subid;
-
     uint8_t i;
     uint8_t oldFrameLength;
     uint8_t numlinks;
@@ -2454,129 +2576,90 @@ bool isValidEbFormat(OpenQueueEntry_t *pkt, uint16_t *lenIE) {
     uint16_t slotoffset;
     uint16_t channeloffset;
 
-    chTemplate_checkPass = FALSE;
-    tsTemplate_checkpass = FALSE;
-    sync_ie_checkPass = FALSE;
-    slotframelink_ie_checkPass = FALSE;
-
-    ptr = 0;
-    mlme_ie_found = FALSE;
-
-    while (ptr < pkt->length) {
-
-        temp16b = *((uint8_t * )(pkt->payload) + ptr);
-        temp16b |= (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-        ptr += 2;
-
-        ielen = temp16b & IEEE802154E_DESC_LEN_PAYLOAD_IE_MASK;
+    if (ieee802154_ie_parse(pkt->payload, pkt->length, &ieIndex) != E_SUCCESS) {
+        // malformed IE list
+        return FALSE;
+    }
 
-        if (
-                (temp16b & IEEE802154E_DESC_GROUPID_PAYLOAD_IE_MASK) >> IEEE802154E_DESC_GROUPID_PAYLOAD_IE_SHIFT !=
-                IEEE802154E_MLME_IE_GROUPID ||
-                (temp16b & IEEE802154E_DESC_TYPE_LONG) == 0
-                ) {
-            // this is not MLME IE
-            ptr += ielen;
-        } else {
-            // found the MLME payload IE
-            mlme_ie_found = TRUE;
-            mlme_ie_content_offset = ptr;
-            break;
-        }
+    if (
+            ieee802154_ie_isPresent(&ieIndex, IEEE802154_IE_SYNC) == FALSE ||
+            ieee802154_ie_isPresent(&ieIndex, IEEE802154_IE_TIMESLOT) == FALSE ||
+            ieee802154_ie_isPresent(&ieIndex, IEEE802154_IE_CHANNELHOPPING) == FALSE ||
+            ieee802154_ie_isPresent(&ieIndex, IEEE802154_IE_SLOTFRAME_LINK) == FALSE
+            ) {
+        // one of the MLME sub-IEs is missing
+        return FALSE;
     }
 
-    if (mlme_ie_found == FALSE) {
-        // didn't find the MLME payload IE
+    // the slotframe and link IE must hold all its links
+    ie = pkt->payload + ieIndex.offset[IEEE802154_IE_SLOTFRAME_LINK];
+    numlinks = ie[4];
+    if (5 + 5 * numlinks > ieIndex.length[IEEE802154_IE_SLOTFRAME_LINK]) {
         return FALSE;
     }
 
-    while (
-            ptr < mlme_ie_content_offset + ielen &&
-            (
-                    chTemplate_checkPass == FALSE || tsTemplate_checkpass == FALSE ||
-                    sync_ie_checkPass == FALSE || slotframelink_ie_checkPass == FALSE
-            )
+    // sync IE
+    ie = pkt->payload + ieIndex.offset[IEEE802154_IE_SYNC];
+    asnStoreFromEB(ie);
+    joinPriorityStoreFromEB(ie[5]);
+
+    // timeslot IE
+    ie = pkt->payload + ieIndex.offset[IEEE802154_IE_TIMESLOT];
+    timeslotTemplateIDStoreFromEB(ie[0]);
+
+    // channel hopping IE
+    ie = pkt->payload + ieIndex.offset[IEEE802154_IE_CHANNELHOPPING];
+    channelhoppingTemplateIDStoreFromEB(ie[0]);
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+    if (
+            ieee154e_vars.chTemplateId == CHANNELHOPPING_TEMPLATE_ID_ADAPTIVE &&
+            ieIndex.length[IEEE802154_IE_CHANNELHOPPING] >= 1 + 2 * sizeof(uint16_t)
             ) {
-        // subID
-        temp16b = *((uint8_t * )(pkt->payload) + ptr);
-        temp16b |= (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-        ptr += 2;
-
-        subtype = (temp16b & IEEE802154E_DESC_TYPE_IE_MASK) >> IEEE802154E_DESC_TYPE_IE_SHIFT;
-        if (subtype == 1) {
-            // this is long type subID
-            subid = (temp16b & IEEE802154E_DESC_SUBID_LONG_MLME_IE_MASK) >> IEEE802154E_DESC_SUBID_LONG_MLME_IE_SHIFT;
-            sublen = (temp16b & IEEE802154E_DESC_LEN_LONG_MLME_IE_MASK);
-            switch (subid) {
-                case IEEE802154E_MLME_CHANNELHOPPING_IE_SUBID:
-                    channelhoppingTemplateIDStoreFromEB(*((uint8_t * )(pkt->payload + ptr)));
-                    chTemplate_checkPass = TRUE;
-                    break;
-                default:
-                    // unsupported IE type, skip the ie
-                    break;
-            }
-        } else {
-            // this is short type subID
-            subid = (temp16b & IEEE802154E_DESC_SUBID_SHORT_MLME_IE_MASK) >> IEEE802154E_DESC_SUBID_SHORT_MLME_IE_SHIFT;
-            sublen = (temp16b & IEEE802154E_DESC_LEN_SHORT_MLME_IE_MASK);
-            switch (subid) {
-                case IEEE802154E_MLME_SYNC_IE_SUBID:
-                    asnStoreFromEB((uint8_t * )(pkt->payload + ptr));
-                    joinPriorityStoreFromEB(*((uint8_t * )(pkt->payload) + ptr + 5));
-                    sync_ie_checkPass = TRUE;
-                    break;
-                case IEEE802154E_MLME_TIMESLOT_IE_SUBID:
-                    timeslotTemplateIDStoreFromEB(*((uint8_t * )(pkt->payload) + ptr));
-                    tsTemplate_checkpass = TRUE;
-                    break;
-                case IEEE802154E_MLME_SLOTFRAME_LINK_IE_SUBID:
-                    schedule_setFrameNumber(*((uint8_t * )(pkt->payload) + ptr));           // number of slotframes
-                    schedule_setFrameHandle(*((uint8_t * )(pkt->payload) + ptr + 1));       // slotframe id
-                    oldFrameLength = schedule_getFrameLength();
-                    if (oldFrameLength == 0) {
-                        temp16b = *((uint8_t * )(pkt->payload + ptr + 2));                  // slotframes length
-                        temp16b |= *((uint8_t * )(pkt->payload + ptr + 3)) << 8;
-                        schedule_setFrameLength(temp16b);
-                        numlinks = *((uint8_t * )(pkt->payload + ptr + 4));                 // number of links
-
-                        // shared TXRX anycast slot(s)
-                        memset(&temp_neighbor, 0, sizeof(temp_neighbor));
-                        temp_neighbor.type = ADDR_ANYCAST;
-
-                        for (i = 0; i < numlinks; i++) {
-                            slotoffset = *((uint8_t * )(pkt->payload + ptr + 5 + 5 * i));               // slotframes length
-                            slotoffset |= *((uint8_t * )(pkt->payload + ptr + 5 + 5 * i + 1)) << 8;
-
-                            channeloffset = *((uint8_t * )(pkt->payload + ptr + 5 + 5 * i + 2));        // slotframes length
-                            channeloffset |= *((uint8_t * )(pkt->payload + ptr + 5 + 5 * i + 3)) << 8;
-
-                            schedule_addActiveSlot(
-                                    slotoffset,    // slot offset
-                                    CELLTYPE_TXRX, // type of slot
-                                    TRUE,          // shared?
-                                    FALSE,         // auto cell
-                                    channeloffset, // channel offset
-                                    &temp_neighbor // neighbor
-                            );
-                        }
-                    }
-                    slotframelink_ie_checkPass = TRUE;
-                    break;
-                default:
-                    // unsupported IE type, skip the ie
-                    break;
-            }
-        }
-        ptr += sublen;
+        channelMaskStoreFromEB(
+                pkt,
+                ie[1] | (ie[2] << 8),
+                ie[3] | (ie[4] << 8)
+        );
+    } else {
+        // the default template hops over all the channels
+        channelMaskStoreFromEB(pkt, CHANNELHOPPING_ALL_CHANNELS, CHANNELHOPPING_ALL_CHANNELS);
     }
+#endif
 
-    if (chTemplate_checkPass && tsTemplate_checkpass && sync_ie_checkPass && slotframelink_ie_checkPass) {
-        *lenIE = pkt->length;
-        return TRUE;
-    } else {
-        return FALSE;
+    // slotframe and link IE
+    ie = pkt->payload + ieIndex.offset[IEEE802154_IE_SLOTFRAME_LINK];
+    schedule_setFrameNumber(ie[0]);                                 // number of slotframes
+    schedule_setFrameHandle(ie[1]);                                 // slotframe id
+    oldFrameLength = schedule_getFrameLength();
+    if (oldFrameLength == 0) {
+        temp16b = ie[2];                                            // slotframes length
+        temp16b |= ie[3] << 8;
+        schedule_setFrameLength(temp16b);
+
+        // shared TXRX anycast slot(s)
+        memset(&temp_neighbor, 0, sizeof(temp_neighbor));
+        temp_neighbor.type = ADDR_ANYCAST;
+
+        for (i = 0; i < numlinks; i++) {
+            slotoffset = ie[5 + 5 * i];
+            slotoffset |= ie[5 + 5 * i + 1] << 8;
+
+            channeloffset = ie[5 + 5 * i + 2];
+            channeloffset |= ie[5 + 5 * i + 3] << 8;
+
+            schedule_addActiveSlot(
+                    slotoffset,    // slot offset
+                    CELLTYPE_TXRX, // type of slot
+                    TRUE,          // shared?
+                    FALSE,         // auto cell
+                    channeloffset, // channel offset
+                    &temp_neighbor // neighbor
+            );
+        }
     }
+
+    *lenIE = pkt->length;
+    return TRUE;
 }
 
 port_INLINE void asnStoreFromEB(uint8_t *asn) {
@@ -2590,7 +2673,6 @@ port_INLINE void asnStoreFromEB(uint8_t *asn) {
 port_INLINE void ieee154e_syncSlotOffset(void) {
     frameLength_t frameLength;
     uint32_t slotOffset;
-    uint8_t i;
 
     frameLength = schedule_getFrameLength();
 
@@ -2608,6 +2690,29 @@ port_INLINE void ieee154e_syncSlotOffset(void) {
 
     schedule_syncSlotOffset(ieee154e_vars.slotOffset);
     ieee154e_vars.nextActiveSlotOffset = schedule_getNextActiveSlotOffset();
+    ieee154e_inferAsnOffset();
+}
+
+/**
+\brief Infers the position of the current slot in the hopping sequence.
+*/
+port_INLINE void ieee154e_inferAsnOffset(void) {
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+    uint32_t asnOffset;
+
+    // the sequence can be shorter than NUM_CHANNELS, use ASN % length as in RFC8180
+    asnOffset = ieee154e_vars.asn.byte4 % ieee154e_vars.numHoppingChannels;
+    asnOffset = asnOffset << 16;
+    asnOffset = asnOffset + ieee154e_vars.asn.bytes2and3;
+    asnOffset = asnOffset % ieee154e_vars.numHoppingChannels;
+    asnOffset = asnOffset << 16;
+    asnOffset = asnOffset + ieee154e_vars.asn.bytes0and1;
+    asnOffset = asnOffset % ieee154e_vars.numHoppingChannels;
+
+    ieee154e_vars.asnOffset = (uint8_t) asnOffset;
+#else
+    uint8_t i;
+
     /*
     infer the asnOffset based on the fact that
     ieee154e_vars.freq = 11 + (asnOffset + channelOffset)%16
@@ -2618,6 +2723,7 @@ port_INLINE void ieee154e_syncSlotOffset(void) {
         }
     }
     ieee154e_vars.asnOffset = i - schedule_getChannelOffset();
+#endif
 }
 
 uint16_t ieee154e_getSlotDuration(void) {
@@ -2633,6 +2739,127 @@ port_INLINE void timeslotTemplateIDStoreFromEB(uint8_t id) {
 port_INLINE void channelhoppingTemplateIDStoreFromEB(uint8_t id) {
     ieee154e_vars.chTemplateId = id;
 }
+
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+/**
+\brief Takes the channel masks from the channel hopping IE of an EB.
+
+Before synchronizing, the masks of any EB are used. Once synchronized, only
+those of the preferred parent are, so that the mote starts hopping over the
+next channels at the same epoch as its parent.
+
+The EB carries the masks of the epoch it was sent in, which is the current one.
+The next mask is only applied at the start of the next epoch if such an EB
+announced it; otherwise the mote keeps its channels, and takes those of its
+parent from the first EB it hears in that epoch.
+
+\param[in] pkt The received EB.
+\param[in] channelMask The channels the sender hops over.
+\param[in] nextChannelMask The channels the sender hops over from the next epoch.
+*/
+port_INLINE void channelMaskStoreFromEB(OpenQueueEntry_t *pkt, uint16_t channelMask, uint16_t nextChannelMask) {
+    if (idmanager_getIsDAGroot() == TRUE) {
+        // the DAG root chooses the channels
+        return;
+    }
+    if (
+            ieee154e_vars.isSync == TRUE &&
+            icmpv6rpl_isPreferredParent(&pkt->l2_nextORpreviousHop) == FALSE
+            ) {
+        return;
+    }
+    if (channelMask == 0 || nextChannelMask == 0) {
+        // invalid masks
+        return;
+    }
+
+    if (channelMask != ieee154e_vars.channelMask) {
+        applyChannelMask(channelMask);
+    }
+    ieee154e_vars.nextChannelMask = nextChannelMask;
+    ieee154e_vars.isNextChannelMaskConfirmed = TRUE;
+}
+
+/**
+\brief Builds the hopping sequence over the channels of a mask.
+
+The channels keep the order of the default template.
+
+\param[in] channelMask The channels to hop over, bit n is channel 11+n.
+*/
+port_INLINE void applyChannelMask(uint16_t channelMask) {
+    uint8_t i;
+
+    ieee154e_vars.numHoppingChannels = 0;
+    for (i = 0; i < NUM_CHANNELS; i++) {
+        if ((channelMask & (1 << chTemplate_default[i])) != 0) {
+            ieee154e_vars.chTemplate[ieee154e_vars.numHoppingChannels] = chTemplate_default[i];
+            ieee154e_vars.numHoppingChannels++;
+        }
+    }
+    ieee154e_vars.channelMask = channelMask;
+
+    // the length of the sequence may have changed
+    ieee154e_inferAsnOffset();
+}
+
+/**
+\brief Chooses the channels to hop over during the next epoch.
+
+Called by the DAG root at the start of each epoch. A channel is excluded when
+less than IEEE802154E_HOPPING_MIN_PDR percent of the transmissions and
+receptions on it succeeded, and tried again IEEE802154E_HOPPING_EXCLUDED_EPOCHS
+epochs later. The statistics are halved at each epoch, so the recent ones
+weigh more.
+*/
+port_INLINE void updateChannelMask(void) {
+    ieee154e_channelStats_t *stats;
+    uint32_t numAttempts;
+    uint32_t numSuccesses;
+    uint16_t nextChannelMask;
+    uint8_t numChannels;
+    uint8_t i;
+
+    nextChannelMask = 0;
+    numChannels = 0;
+    for (i = 0; i < NUM_CHANNELS; i++) {
+        stats = &ieee154e_channels.channels[i];
+        if ((ieee154e_vars.channelMask & (1 << i)) == 0) {
+            // excluded channel, try it again after a while
+            stats->numExcludedEpochs++;
+            if (stats->numExcludedEpochs < IEEE802154E_HOPPING_EXCLUDED_EPOCHS) {
+                continue;
+            }
+            stats->numExcludedEpochs = 0;
+        } else {
+            numAttempts = (uint32_t) stats->numTx + stats->numRx + stats->numRxCrcError;
+            numSuccesses = (uint32_t) stats->numTxAck + stats->numRx;
+            stats->numTx >>= 1;
+            stats->numTxAck >>= 1;
+            stats->numRx >>= 1;
+            stats->numRxCrcError >>= 1;
+            if (
+                    numAttempts >= IEEE802154E_HOPPING_MIN_SAMPLES &&
+                    numSuccesses * 100 < numAttempts * IEEE802154E_HOPPING_MIN_PDR
+                    ) {
+                // bad channel, start afresh when it is tried again
+                memset(stats, 0, sizeof(ieee154e_channelStats_t));
+                continue;
+            }
+        }
+        nextChannelMask |= 1 << i;
+        numChannels++;
+    }
+
+    if (numChannels < IEEE802154E_HOPPING_MIN_CHANNELS) {
+        // too few good channels, keep the current ones
+        nextChannelMask |= ieee154e_vars.channelMask;
+    }
+
+    ieee154e_vars.nextChannelMask = nextChannelMask;
+    ieee154e_vars.isNextChannelMaskConfirmed = TRUE;
+}
+#endif
 //======= synchronization
 
 void synchronizePacket(PORT_TIMER_WIDTH timeReceived) {
@@ -2757,6 +2984,8 @@ void changeIsSync(bool newIsSync) {
         //leds_sync_on();
         status_led_set(LED_BLINK_LSS);
         resetStats();
+        // the events registered for the slots before are not dispatched
+        asn_events_indicateSync(&ieee154e_vars.asn);
     } else {
         //leds_sync_off();
         status_led_set(LED_OFF);
@@ -2764,6 +2993,32 @@ void changeIsSync(bool newIsSync) {
     }
 }
 
+#if IEEE802154E_BURST_ENABLE
+//======= burst
+
+/**
+\brief Tells whether a burst can go on in the next slot.
+
+The next slot must not be scheduled, the mote must not sleep over it, and the
+burst must not have used IEEE802154E_BURST_MAX_SLOTS slots already.
+
+\returns TRUE if the next slot can carry a frame of the burst.
+*/
+port_INLINE bool burstCanContinue(void) {
+    frameLength_t frameLength;
+
+    frameLength = schedule_getFrameLength();
+    if (
+            frameLength == 0 ||
+            ieee154e_vars.numOfSleepSlots != 1 ||
+            ieee154e_vars.burstNumSlots >= IEEE802154E_BURST_MAX_SLOTS
+            ) {
+        return FALSE;
+    }
+    return ieee154e_vars.nextActiveSlotOffset != (ieee154e_vars.slotOffset + 1) % frameLength;
+}
+#endif
+
 //======= notifying upper layer
 
 void notif_sendDone(OpenQueueEntry_t *packetSent, owerror_t error) {
@@ -2771,6 +3026,8 @@ void notif_sendDone(OpenQueueEntry_t *packetSent, owerror_t error) {
     packetSent->l2_sendDoneError = error;
     // record the current ASN
     memcpy(&packetSent->l2_asn, &ieee154e_vars.asn, sizeof(asn_t));
+    // take the packet out of the transmit lists
+    openqueue_macTxDone(packetSent);
     // associate this packet with the virtual component COMPONENT_IEEE802154E_TO_RES so RES can knows it's for it
     packetSent->owner = COMPONENT_IEEE802154E_TO_SIXTOP;
     // post RES's sendDone task
@@ -2816,6 +3073,49 @@ void updateStats(PORT_SIGNED_INT_WIDTH timeCorrection) {
     }
 }
 
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+/**
+\brief Records the outcome of a unicast transmission on the current channel.
+
+\param[in] isAcked TRUE if the transmission was acknowledged.
+*/
+void recordChannelTx(bool isAcked) {
+    ieee154e_channelStats_t *stats;
+
+    stats = &ieee154e_channels.channels[ieee154e_vars.freq - 11];
+    if (stats->numTx == 0xFFFF) {
+        // keep the ratio, forget the oldest transmissions
+        stats->numTx >>= 1;
+        stats->numTxAck >>= 1;
+    }
+    stats->numTx++;
+    if (isAcked == TRUE) {
+        stats->numTxAck++;
+    }
+}
+
+/**
+\brief Records a frame received on the current channel.
+
+\param[in] isCrcValid TRUE if the CRC of the frame checks.
+*/
+void recordChannelRx(bool isCrcValid) {
+    ieee154e_channelStats_t *stats;
+
+    stats = &ieee154e_channels.channels[ieee154e_vars.freq - 11];
+    if (stats->numRx == 0xFFFF || stats->numRxCrcError == 0xFFFF) {
+        // keep the ratio, forget the oldest receptions
+        stats->numRx >>= 1;
+        stats->numRxCrcError >>= 1;
+    }
+    if (isCrcValid == TRUE) {
+        stats->numRx++;
+    } else {
+        stats->numRxCrcError++;
+    }
+}
+#endif
+
 //======= misc
 
 /**
@@ -2839,7 +3139,12 @@ port_INLINE uint8_t calculateFrequency(uint8_t channelOffset) {
         return ieee154e_vars.singleChannel; // single channel
     } else {
         // channel hopping enabled, use the channel depending on hopping template
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+        return 11 + ieee154e_vars.chTemplate[(ieee154e_vars.asnOffset + channelOffset) %
+                                             ieee154e_vars.numHoppingChannels];
+#else
         return 11 + ieee154e_vars.chTemplate[(ieee154e_vars.asnOffset + channelOffset) % NUM_CHANNELS];
+#endif
     }
 }
 
@@ -2851,6 +3156,9 @@ Besides simply updating the state global variable, this function toggles the FSM
 \param[in] newstate The state the IEEE802.15.4e FSM is now in.
 */
 void changeState(ieee154e_state_t newstate) {
+#if IEEE802154E_TIMING_ENABLE
+    recordStateTiming(ieee154e_vars.state, newstate);
+#endif
     // update the state
     ieee154e_vars.state = newstate;
     // wiggle the FSM debug pin
@@ -2890,6 +3198,67 @@ void changeState(ieee154e_state_t newstate) {
     }
 }
 
+#if IEEE802154E_TIMING_ENABLE
+/**
+\brief Record the time spent in the state being left, and how far into the slot
+   the new state is entered.
+
+Each state is entered by one activity, so the time spent in a "prepare" state is
+the time its activity took to prepare the radio, to compare with its budget
+(e.g. maxTxDataPrepare). The time spent in S_SLEEP, which spans the slots
+without activity, is not recorded. When the count of a state saturates, its
+count and sum are halved, so that the average follows the recent slots.
+
+\param oldState    The state being left.
+\param newState    The state being entered.
+*/
+void recordStateTiming(ieee154e_state_t oldState, ieee154e_state_t newState) {
+    ieee154e_stateTiming_t *timing;
+    PORT_TIMER_WIDTH now;
+    PORT_TIMER_WIDTH elapsed;
+    uint16_t duration;
+    uint8_t bin;
+
+    now = sctimer_readCounter();
+
+    if (oldState != S_SLEEP) {
+        timing = &ieee154e_timing.states[oldState];
+        elapsed = now - ieee154e_timing.stateEntryTime;
+        duration = (elapsed > 0xffff) ? 0xffff : (uint16_t) elapsed;
+
+        if (timing->count == 0xffff) {
+            timing->count >>= 1;
+            timing->sum >>= 1;
+        }
+        if (timing->count == 0 || duration < timing->min) {
+            timing->min = duration;
+        }
+        if (duration > timing->max) {
+            timing->max = duration;
+        }
+        timing->count++;
+        timing->sum += duration;
+
+        // bin 0 counts 0 ticks, bin n [2^(n-1), 2^n[ ticks
+        bin = 0;
+        while (elapsed != 0 && bin < IEEE802154E_TIMING_NUM_BINS - 1) {
+            elapsed >>= 1;
+            bin++;
+        }
+        if (timing->bins[bin] < 0xffff) {
+            timing->bins[bin]++;
+        }
+    }
+
+    timing = &ieee154e_timing.states[newState];
+    elapsed = now - (PORT_TIMER_WIDTH) ieee154e_vars.startOfSlotReference;
+    if (elapsed > timing->maxEntryOffset) {
+        timing->maxEntryOffset = (elapsed > 0xffff) ? 0xffff : (uint16_t) elapsed;
+    }
+    ieee154e_timing.stateEntryTime = now;
+}
+#endif
+
 /**
 \brief Housekeeping tasks to do at the end of each slot.
 
@@ -2947,6 +3316,9 @@ void endSlot(void) {
         // if everything went well, dataToSend was set to NULL in ti9, getting here means transmit failed
         // indicate Tx fail to schedule to update stats
         schedule_indicateTx(&ieee154e_vars.asn, FALSE);
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+        recordChannelTx(FALSE);
+#endif
 
         //decrement transmits left counter
         ieee154e_vars.dataToSend->l2_retriesLeft--;
@@ -2963,7 +3335,12 @@ void endSlot(void) {
         ieee154e_vars.dataToSend = NULL;
     }
 
-    schedule_getSlotInfo(ieee154e_vars.slotOffset, &info);
+    // only the cells of the default slotframe are managed by msf
+    if (schedule_getIsDefaultSlotframe()) {
+        schedule_getSlotInfo(ieee154e_vars.slotOffset, &info);
+    } else {
+        info.link_type = CELLTYPE_OFF;
+    }
     if (info.link_type == CELLTYPE_RX) {
         // update numcellelapsed and numcellused on Rx cell
 
@@ -3022,6 +3399,7 @@ void endSlot(void) {
 
     // check if this is auto tx cell
     if (
+            schedule_getIsDefaultSlotframe() &&
             schedule_getSlottOffset() == ieee154e_vars.slotOffset &&
             schedule_getIsAutoCell() && schedule_getType() == CELLTYPE_TX
             ) {
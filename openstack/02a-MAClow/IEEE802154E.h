@@ -22,21 +22,40 @@ static const uint8_t chTemplate_default[] = {
 
 // refer to RFC8180: https://tools.ietf.org/html/rfc8180#appendix-A.1
 // ASN and join Metric are replaced later when sending an EB
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+// the channel hopping IE carries the template id 0x01, then the current and next channel masks, also replaced later
+static const uint8_t ebIEsBytestream[] = {
+        0x1E, 0x88, 0x06, 0x1A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x1C, 0x00, 0x05,
+        0xC8, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x0A, 0x1B, 0x01, 0x00, SLOTFRAME_LENGTH, 0x00,
+        SCHEDULE_MINIMAL_6TISCH_ACTIVE_CELLS, 0x00, 0x00, 0x00, 0x00, 0x0F
+};
+#else
 static const uint8_t ebIEsBytestream[] = {
         0x1A, 0x88, 0x06, 0x1A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x1C, 0x00, 0x01,
         0xC8, 0x00, 0x0A, 0x1B, 0x01, 0x00, SLOTFRAME_LENGTH, 0x00, SCHEDULE_MINIMAL_6TISCH_ACTIVE_CELLS, 0x00, 0x00,
         0x00, 0x00, 0x0F
 };
+#endif
 //=========================== define ==========================================
 
 #define EB_ASN0_OFFSET               4
 #define EB_JP_OFFSET                 9
 #define EB_SLOTFRAME_TS_ID_OFFSET   12
 #define EB_SLOTFRAME_CH_ID_OFFSET   15
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+#define EB_CH_MASK_OFFSET           16
+#define EB_SLOTFRAME_IE_LEN_OFFSET  20
+#define EB_SLOTFRAME_LEN_OFFSET     24
+#define EB_SLOTFRAME_NUMLINK_OFFSET 26
+
+#define EB_IE_LEN                   32
+#else
+#define EB_SLOTFRAME_IE_LEN_OFFSET  16
 #define EB_SLOTFRAME_LEN_OFFSET     20
 #define EB_SLOTFRAME_NUMLINK_OFFSET 22
 
 #define EB_IE_LEN                   28
+#endif
 
 #define NUM_CHANNELS                16  // number of channels to channel hop on
 #define TXRETRIES                   15  // number of MAC retries before declaring failed
@@ -156,8 +175,19 @@ typedef enum {
     S_RXPROC = 0x19,            // processing received data
 } ieee154e_state_t;
 
+#if IEEE802154E_BURST_ENABLE
+// what the next slot does for a burst of frames to the same neighbor
+typedef enum {
+    BURST_NONE = 0x00,          // nothing, unless scheduled
+    BURST_TX = 0x01,            // send the next frame to burstNeighbor
+    BURST_RX = 0x02,            // listen for the next frame
+} ieee154e_burst_t;
+#endif
+
 #define  TIMESLOT_TEMPLATE_ID         0x00
 #define  CHANNELHOPPING_TEMPLATE_ID   0x00
+#define  CHANNELHOPPING_TEMPLATE_ID_ADAPTIVE    0x01
+#define  CHANNELHOPPING_ALL_CHANNELS  0xFFFF
 
 // Atomic durations
 // expressed in 32kHz ticks:
@@ -272,6 +302,12 @@ typedef struct {
     uint8_t singleChannel;                          // the single channel used for transmission
     bool singleChannelChanged;                      // detect id singleChannelChanged
     uint8_t chTemplate[NUM_CHANNELS];               // storing the template of hopping sequence
+#if IEEE802154E_ADAPTIVE_HOPPING_ENABLE
+    uint8_t numHoppingChannels;                     // number of channels in chTemplate
+    uint16_t channelMask;                           // channels in chTemplate, bit n is channel 11+n
+    uint16_t nextChannelMask;                       // channels to hop over from the next epoch
+    bool isNextChannelMaskConfirmed;                // nextChannelMask announced for the next epoch by the preferred parent
+#endif
     // template ID
     uint8_t tsTemplateId;                           // timeslot template id
     uint8_t chTemplateId;                           // channel hopping tempalte id
@@ -295,6 +331,14 @@ typedef struct {
     uint32_t receivedFrameFromParent;               // True when received a frame from parent
 
     uint16_t compensatingCounter;
+
+#if IEEE802154E_BURST_ENABLE
+    // burst
+    ieee154e_burst_t burst;                         // what the next slot does for the burst
+    uint8_t burstNumSlots;                          // number of slots of the burst since the last scheduled one
+    bool burstFramePending;                         // TRUE iff the frame being sent announces another one
+    open_addr_t burstNeighbor;                      // neighbor the burst is sent to
+#endif
 } ieee154e_vars_t;
 
 BEGIN_PACK
@@ -316,6 +360,63 @@ typedef struct {
     PORT_TIMER_WIDTH num_endOfFrame;
 } ieee154e_dbg_t;
 
+#if IEEE802154E_TIMING_ENABLE
+#define IEEE802154E_TIMING_NUM_STATES   (S_RXPROC+1)
+
+typedef struct {
+    uint16_t count;                                 // number of times the state was left, see recordStateTiming()
+    uint32_t sum;                                   // total time spent in the state, in ticks
+    uint16_t min;                                   // shortest time spent in the state, in ticks
+    uint16_t max;                                   // longest time spent in the state, in ticks
+    uint16_t maxEntryOffset;                        // latest time into the slot the state was entered, in ticks
+    uint16_t bins[IEEE802154E_TIMING_NUM_BINS];     // histogram of the time spent in the state
+} ieee154e_stateTiming_t;
+
+typedef struct {
+    ieee154e_stateTiming_t states[IEEE802154E_TIMING_NUM_STATES];
+    PORT_TIMER_WIDTH stateEntryTime;                // when the current state was entered
+    uint8_t debugPrintRow;
+} ieee154e_timing_t;
+
+BEGIN_PACK
+typedef struct {
+    uint8_t state;
+    uint16_t count;
+    uint16_t min;
+    uint16_t avg;
+    uint16_t max;
+    uint16_t maxEntryOffset;
+    uint16_t bins[IEEE802154E_TIMING_NUM_BINS];
+} debugIeee154eTimingEntry_t;
+END_PACK
+#endif
+
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+typedef struct {
+    uint16_t numTx;                                 // unicast transmissions, waiting for an ACK
+    uint16_t numTxAck;                              // unicast transmissions which were acknowledged
+    uint16_t numRx;                                 // frames received with a valid CRC
+    uint16_t numRxCrcError;                         // frames received with a wrong CRC
+    uint8_t numExcludedEpochs;                      // epochs since the channel was excluded from the hopping sequence
+} ieee154e_channelStats_t;
+
+typedef struct {
+    ieee154e_channelStats_t channels[NUM_CHANNELS]; // index n is channel 11+n
+    uint8_t debugPrintRow;
+} ieee154e_channels_t;
+
+BEGIN_PACK
+typedef struct {
+    uint8_t channel;
+    bool isHopping;
+    uint16_t numTx;
+    uint16_t numTxAck;
+    uint16_t numRx;
+    uint16_t numRxCrcError;
+} debugIeee154eChannelEntry_t;
+END_PACK
+#endif
+
 //=========================== prototypes ======================================
 
 // admin
@@ -325,11 +426,7 @@ void ieee154e_init(void);
 PORT_TIMER_WIDTH ieee154e_asnDiff(asn_t *someASN);
 
 #ifdef DEADLINE_OPTION
-int16_t ieee154e_computeAsnDiff(asn_t *h_asn, asn_t *l_asn);
-
-void ieee154e_calculateExpTime(uint16_t max_delay, uint8_t *et_asn);
-
-void ieee154e_orderToASNStructure(uint8_t *in, asn_t *val_asn);
+void ieee154e_calculateExpTime(uint16_t max_delay, asn_t *et_asn);
 
 #endif
 
@@ -355,6 +452,14 @@ bool debugPrint_isSync(void);
 
 bool debugPrint_macStats(void);
 
+#if IEEE802154E_TIMING_ENABLE
+bool debugPrint_macTiming(void);
+#endif
+
+#if IEEE802154E_CHANNEL_STATS_ENABLE
+bool debugPrint_macChannels(void);
+#endif
+
 /**
 \}
 \}
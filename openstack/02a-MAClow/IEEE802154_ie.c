@@ -0,0 +1,226 @@
+#include "config.h"
+#include "opendefs.h"
+#include "IEEE802154_ie.h"
+#include "IEEE802154.h"
+#include "IEEE802154E.h"
+#include "sixtop.h"
+
+//=========================== define ==========================================
+
+#define IEEE802154_IE_GROUPID_IETF   (IANA_IETF_IE_GROUP_ID >> IEEE802154E_DESC_GROUPID_PAYLOAD_IE_SHIFT)
+
+//=========================== variables =======================================
+
+static const ieee802154_ie_desc_t ieee802154_ie_table[] = {
+    // groupId                      format                            subId                                     minLength  id
+    {IEEE802154E_MLME_IE_GROUPID, IEEE802154_IE_FORMAT_MLME_SHORT, IEEE802154E_MLME_SYNC_IE_SUBID,           6, IEEE802154_IE_SYNC},
+    {IEEE802154E_MLME_IE_GROUPID, IEEE802154_IE_FORMAT_MLME_SHORT, IEEE802154E_MLME_SLOTFRAME_LINK_IE_SUBID, 5, IEEE802154_IE_SLOTFRAME_LINK},
+    {IEEE802154E_MLME_IE_GROUPID, IEEE802154_IE_FORMAT_MLME_SHORT, IEEE802154E_MLME_TIMESLOT_IE_SUBID,       1, IEEE802154_IE_TIMESLOT},
+    {IEEE802154E_MLME_IE_GROUPID, IEEE802154_IE_FORMAT_MLME_LONG,  IEEE802154E_MLME_CHANNELHOPPING_IE_SUBID, 1, IEEE802154_IE_CHANNELHOPPING},
+    {IEEE802154_IE_GROUPID_IETF,  IEEE802154_IE_FORMAT_IETF,       IANA_6TOP_SUBIE_ID,                       4, IEEE802154_IE_6P},
+};
+
+//=========================== prototypes ======================================
+
+uint8_t ieee802154_ie_lookup(uint8_t groupId, uint8_t format, uint8_t subId);
+
+owerror_t ieee802154_ie_record(
+        ieee802154_ie_index_t *index,
+        uint8_t groupId,
+        uint8_t format,
+        uint8_t subId,
+        uint16_t offset,
+        uint16_t length
+);
+
+owerror_t ieee802154_ie_parseMlme(uint8_t *buffer, uint16_t offset, uint16_t length, ieee802154_ie_index_t *index);
+
+//=========================== public ==========================================
+
+/**
+\brief Walk the payload IE list of a frame and index the known IEs.
+
+The walk ends at the payload termination IE, or at the end of the buffer.
+Unknown IEs are skipped. When an IE appears more than once, the first one is
+recorded.
+
+\param[in]  buffer The first byte of the payload IE list.
+\param[in]  length Number of bytes from buffer to the end of the frame.
+\param[out] index  Where the known IEs are recorded.
+
+\returns E_SUCCESS if the list is well formed, E_FAIL if an IE is truncated,
+   is not a payload IE, or a known IE is shorter than its minimum length.
+*/
+owerror_t ieee802154_ie_parse(uint8_t *buffer, uint16_t length, ieee802154_ie_index_t *index) {
+    uint16_t ptr;
+    uint16_t temp16b;
+    uint16_t ielen;
+    uint8_t groupId;
+
+    memset(index->offset, IEEE802154_IE_NOT_PRESENT, sizeof(index->offset));
+    memset(index->length, 0, sizeof(index->length));
+    index->totalLength = 0;
+
+    ptr = 0;
+    while (ptr < length) {
+        if (ptr + 2 > length) {
+            // truncated descriptor
+            return E_FAIL;
+        }
+        temp16b = buffer[ptr];
+        temp16b |= buffer[ptr + 1] << 8;
+        ptr += 2;
+
+        if (temp16b == PAYLOAD_TERMINATION_IE) {
+            // MAC payload follows
+            break;
+        }
+        if ((temp16b & IEEE802154E_DESC_TYPE_IE_MASK) != IEEE802154E_DESC_TYPE_PAYLOAD_IE) {
+            // only payload IEs are expected here
+            return E_FAIL;
+        }
+
+        ielen = temp16b & IEEE802154E_DESC_LEN_PAYLOAD_IE_MASK;
+        if (ptr + ielen > length) {
+            // truncated content
+            return E_FAIL;
+        }
+        groupId = (temp16b & IEEE802154E_DESC_GROUPID_PAYLOAD_IE_MASK) >> IEEE802154E_DESC_GROUPID_PAYLOAD_IE_SHIFT;
+
+        switch (groupId) {
+            case IEEE802154E_MLME_IE_GROUPID:
+                if (ieee802154_ie_parseMlme(buffer, ptr, ielen, index) != E_SUCCESS) {
+                    return E_FAIL;
+                }
+                break;
+            case IEEE802154_IE_GROUPID_IETF:
+                // the first byte of the content is the subtype
+                if (
+                        ielen > 0 &&
+                        ieee802154_ie_record(
+                                index,
+                                groupId,
+                                IEEE802154_IE_FORMAT_IETF,
+                                buffer[ptr],
+                                ptr + 1,
+                                ielen - 1
+                        ) != E_SUCCESS
+                        ) {
+                    return E_FAIL;
+                }
+                break;
+            default:
+                // unsupported group, skip the IE
+                break;
+        }
+        ptr += ielen;
+    }
+
+    index->totalLength = ptr;
+    return E_SUCCESS;
+}
+
+bool ieee802154_ie_isPresent(ieee802154_ie_index_t *index, uint8_t id) {
+    return index->offset[id] != IEEE802154_IE_NOT_PRESENT;
+}
+
+//=========================== private =========================================
+
+/**
+\brief Walk the sub-IEs of an MLME payload IE.
+
+\param[in]  buffer The first byte of the payload IE list.
+\param[in]  offset Offset of the content of the MLME IE in buffer.
+\param[in]  length Length of the content of the MLME IE.
+\param[out] index  Where the known sub-IEs are recorded.
+*/
+owerror_t ieee802154_ie_parseMlme(uint8_t *buffer, uint16_t offset, uint16_t length, ieee802154_ie_index_t *index) {
+    uint16_t ptr;
+    uint16_t end;
+    uint16_t temp16b;
+    uint16_t sublen;
+    uint8_t subid;
+    uint8_t format;
+
+    ptr = offset;
+    end = offset + length;
+    while (ptr < end) {
+        if (ptr + 2 > end) {
+            return E_FAIL;
+        }
+        temp16b = buffer[ptr];
+        temp16b |= buffer[ptr + 1] << 8;
+        ptr += 2;
+
+        if ((temp16b & IEEE802154E_DESC_TYPE_IE_MASK) >> IEEE802154E_DESC_TYPE_IE_SHIFT == 1) {
+            format = IEEE802154_IE_FORMAT_MLME_LONG;
+            subid = (temp16b & IEEE802154E_DESC_SUBID_LONG_MLME_IE_MASK) >> IEEE802154E_DESC_SUBID_LONG_MLME_IE_SHIFT;
+            sublen = temp16b & IEEE802154E_DESC_LEN_LONG_MLME_IE_MASK;
+        } else {
+            format = IEEE802154_IE_FORMAT_MLME_SHORT;
+            subid = (temp16b & IEEE802154E_DESC_SUBID_SHORT_MLME_IE_MASK) >> IEEE802154E_DESC_SUBID_SHORT_MLME_IE_SHIFT;
+            sublen = temp16b & IEEE802154E_DESC_LEN_SHORT_MLME_IE_MASK;
+        }
+        if (ptr + sublen > end) {
+            return E_FAIL;
+        }
+        if (ieee802154_ie_record(index, IEEE802154E_MLME_IE_GROUPID, format, subid, ptr, sublen) != E_SUCCESS) {
+            return E_FAIL;
+        }
+        ptr += sublen;
+    }
+    return E_SUCCESS;
+}
+
+/**
+\brief Record an IE in the index, if it is in the descriptor table.
+
+\returns E_FAIL if the IE is known but shorter than its minimum length.
+*/
+owerror_t ieee802154_ie_record(
+        ieee802154_ie_index_t *index,
+        uint8_t groupId,
+        uint8_t format,
+        uint8_t subId,
+        uint16_t offset,
+        uint16_t length
+) {
+    uint8_t i;
+    uint8_t id;
+
+    i = ieee802154_ie_lookup(groupId, format, subId);
+    if (i == IEEE802154_IE_NOT_PRESENT) {
+        // unsupported IE, skip it
+        return E_SUCCESS;
+    }
+    if (length < ieee802154_ie_table[i].minLength || offset + length >= IEEE802154_IE_NOT_PRESENT) {
+        return E_FAIL;
+    }
+    id = ieee802154_ie_table[i].id;
+    if (index->offset[id] == IEEE802154_IE_NOT_PRESENT) {
+        index->offset[id] = (uint8_t) offset;
+        index->length[id] = (uint8_t) length;
+    }
+    return E_SUCCESS;
+}
+
+/**
+\brief Find an IE in the descriptor table.
+
+\returns The position of the IE in the table, IEEE802154_IE_NOT_PRESENT if it
+   is not in the table.
+*/
+uint8_t ieee802154_ie_lookup(uint8_t groupId, uint8_t format, uint8_t subId) {
+    uint8_t i;
+
+    for (i = 0; i < sizeof(ieee802154_ie_table) / sizeof(ieee802154_ie_table[0]); i++) {
+        if (
+                ieee802154_ie_table[i].groupId == groupId &&
+                ieee802154_ie_table[i].format == format &&
+                ieee802154_ie_table[i].subId == subId
+                ) {
+            return i;
+        }
+    }
+    return IEEE802154_IE_NOT_PRESENT;
+}
@@ -0,0 +1,69 @@
+#ifndef OPENWSN_IEEE802154_IE_H
+#define OPENWSN_IEEE802154_IE_H
+
+/**
+\addtogroup MAClow
+\{
+\addtogroup IEEE802154_ie
+\{
+
+\brief Table-driven parser of the IEEE802.15.4 payload Information Elements.
+
+The payload IE list of a received frame is walked once. Each IE (or MLME
+sub-IE) listed in the descriptor table is checked against its minimum length,
+and the offset and length of its content are recorded in an index. The
+consumers (ieee154e for EBs, sixtop for 6P) then read the IEs they need from
+the index, instead of walking the list again.
+*/
+
+#include "opendefs.h"
+
+//=========================== define ==========================================
+
+#define IEEE802154_IE_NOT_PRESENT    0xFF
+
+typedef enum {
+    IEEE802154_IE_SYNC = 0,
+    IEEE802154_IE_SLOTFRAME_LINK,
+    IEEE802154_IE_TIMESLOT,
+    IEEE802154_IE_CHANNELHOPPING,
+    IEEE802154_IE_6P,
+    IEEE802154_IE_MAX,
+} ieee802154_ie_id_t;
+
+typedef enum {
+    IEEE802154_IE_FORMAT_MLME_SHORT = 0,    // MLME sub-IE, short descriptor
+    IEEE802154_IE_FORMAT_MLME_LONG,         // MLME sub-IE, long descriptor
+    IEEE802154_IE_FORMAT_IETF,              // IETF IE, one byte subtype
+} ieee802154_ie_format_t;
+
+//=========================== typedef =========================================
+
+typedef struct {
+    uint8_t groupId;                        // group of the payload IE
+    uint8_t format;                         // one of ieee802154_ie_format_t
+    uint8_t subId;                          // sub-IE ID, or IETF subtype
+    uint8_t minLength;                      // shortest valid content, in bytes
+    uint8_t id;                             // entry in the index
+} ieee802154_ie_desc_t;
+
+typedef struct {
+    uint8_t offset[IEEE802154_IE_MAX];      // of the content in the payload, IEEE802154_IE_NOT_PRESENT if absent
+    uint8_t length[IEEE802154_IE_MAX];      // of the content
+    uint16_t totalLength;                   // of the IE list, including the termination IE
+} ieee802154_ie_index_t;
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+owerror_t ieee802154_ie_parse(uint8_t *buffer, uint16_t length, ieee802154_ie_index_t *index);
+
+bool ieee802154_ie_isPresent(ieee802154_ie_index_t *index, uint8_t id);
+
+/**
+\}
+\}
+*/
+
+#endif /* OPENWSN_IEEE802154_IE_H */
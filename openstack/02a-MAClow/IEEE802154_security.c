@@ -58,6 +58,14 @@ uint8_t IEEE802154_security_getDataKeyIndex(void) {
     return ieee802154_security_vars.k2.index;
 }
 
+void IEEE802154_security_getBeaconKey(uint8_t *value) {
+    memcpy(value, ieee802154_security_vars.k1.value, 16);
+}
+
+void IEEE802154_security_getDataKey(uint8_t *value) {
+    memcpy(value, ieee802154_security_vars.k2.value, 16);
+}
+
 void IEEE802154_security_setBeaconKey(uint8_t index, uint8_t *value) {
     ieee802154_security_vars.k1.index = index;
     memcpy(ieee802154_security_vars.k1.value, value, 16);
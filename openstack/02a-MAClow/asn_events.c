@@ -0,0 +1,180 @@
+#include "config.h"
+#include "opendefs.h"
+#include "asn_events.h"
+#include "asnfunctions.h"
+#include "scheduler.h"
+#include "openserial.h"
+
+//=========================== variables =======================================
+
+asn_events_vars_t asn_events_vars;
+
+//=========================== prototypes ======================================
+
+void asn_events_insert(asn_events_id_t id);
+
+void asn_events_remove(asn_events_id_t id);
+
+void asn_events_realign(asn_event_t *event, asn_t *now);
+
+//=========================== public ==========================================
+
+void asn_events_init(void) {
+    memset(&asn_events_vars, 0, sizeof(asn_events_vars_t));
+    asn_events_vars.head = ASN_EVENTS_NONE;
+}
+
+/**
+\brief Register a callback for an absolute slot number.
+
+\param[in] asn      The ASN of the first occurrence.
+\param[in] period   Number of slots between two occurrences, 0 for a one-time
+   event.
+\param[in] callback Pushed to the scheduler when the event is due.
+\param[in] prio     Priority of that task.
+
+\returns The id of the event, ASN_EVENTS_NONE if there is no room for it.
+*/
+asn_events_id_t asn_events_schedule(asn_t *asn, uint32_t period, task_cbt callback, task_prio_t prio) {
+    asn_events_id_t id;
+    INTERRUPT_DECLARATION();
+
+    DISABLE_INTERRUPTS();
+    for (id = 0; id < ASN_EVENTS_MAX; id++) {
+        if (asn_events_vars.events[id].isUsed == FALSE) {
+            break;
+        }
+    }
+    if (id == ASN_EVENTS_MAX) {
+        ENABLE_INTERRUPTS();
+        LOG_ERROR(COMPONENT_IEEE802154E, ERR_NO_FREE_TIMER_OR_QUEUE_ENTRY, (errorparameter_t) 2, (errorparameter_t) 0);
+        return ASN_EVENTS_NONE;
+    }
+
+    memcpy(&asn_events_vars.events[id].asn, asn, sizeof(asn_t));
+    asn_events_vars.events[id].period = period;
+    asn_events_vars.events[id].callback = callback;
+    asn_events_vars.events[id].prio = prio;
+    asn_events_vars.events[id].isUsed = TRUE;
+    asn_events_insert(id);
+    ENABLE_INTERRUPTS();
+
+    return id;
+}
+
+void asn_events_cancel(asn_events_id_t id) {
+    INTERRUPT_DECLARATION();
+
+    if (id >= ASN_EVENTS_MAX) {
+        return;
+    }
+
+    DISABLE_INTERRUPTS();
+    if (asn_events_vars.events[id].isUsed == TRUE) {
+        asn_events_remove(id);
+        asn_events_vars.events[id].isUsed = FALSE;
+    }
+    ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Dispatch the events due at the current slot.
+
+Called by the MAC at every slot, once the ASN is incremented, including once
+per slot it skips. The callbacks are pushed with scheduler_push_task_coalesce(),
+so a callback which is still pending is not pushed again: a periodic event
+which was missed several times is dispatched once.
+
+\param[in] asn The ASN of the current slot.
+*/
+void asn_events_indicateAsn(asn_t *asn) {
+    asn_events_id_t id;
+    asn_event_t *event;
+
+    while (
+            asn_events_vars.head != ASN_EVENTS_NONE &&
+            asnfunctions_compare(&asn_events_vars.events[asn_events_vars.head].asn, asn) <= 0
+            ) {
+        id = asn_events_vars.head;
+        event = &asn_events_vars.events[id];
+        asn_events_vars.head = event->next;
+
+        scheduler_push_task_coalesce(event->callback, event->prio);
+
+        if (event->period == 0) {
+            event->isUsed = FALSE;
+        } else {
+            asn_events_realign(event, asn);
+            asn_events_insert(id);
+        }
+    }
+}
+
+/**
+\brief Skip the events which are past, once the mote has synchronized.
+
+\param[in] asn The ASN the mote synchronized to.
+*/
+void asn_events_indicateSync(asn_t *asn) {
+    asn_events_id_t id;
+    asn_event_t *event;
+
+    while (
+            asn_events_vars.head != ASN_EVENTS_NONE &&
+            asnfunctions_compare(&asn_events_vars.events[asn_events_vars.head].asn, asn) <= 0
+            ) {
+        id = asn_events_vars.head;
+        event = &asn_events_vars.events[id];
+        asn_events_vars.head = event->next;
+
+        if (event->period == 0) {
+            event->isUsed = FALSE;
+        } else {
+            asn_events_realign(event, asn);
+            asn_events_insert(id);
+        }
+    }
+}
+
+//=========================== private =========================================
+
+/**
+\brief Insert an event in the list, after the events with the same ASN.
+*/
+void asn_events_insert(asn_events_id_t id) {
+    asn_events_id_t *link;
+
+    link = &asn_events_vars.head;
+    while (
+            *link != ASN_EVENTS_NONE &&
+            asnfunctions_compare(&asn_events_vars.events[*link].asn, &asn_events_vars.events[id].asn) <= 0
+            ) {
+        link = &asn_events_vars.events[*link].next;
+    }
+    asn_events_vars.events[id].next = *link;
+    *link = id;
+}
+
+void asn_events_remove(asn_events_id_t id) {
+    asn_events_id_t *link;
+
+    link = &asn_events_vars.head;
+    while (*link != ASN_EVENTS_NONE) {
+        if (*link == id) {
+            *link = asn_events_vars.events[id].next;
+            return;
+        }
+        link = &asn_events_vars.events[*link].next;
+    }
+}
+
+/**
+\brief Move a periodic event to its first occurrence after the current ASN.
+*/
+void asn_events_realign(asn_event_t *event, asn_t *now) {
+    uint32_t numPeriods;
+
+    // event->asn is not after now, the difference is not negative
+    numPeriods = (uint32_t) asnfunctions_diff(now, &event->asn) / event->period + 1;
+    asnfunctions_add(&event->asn, numPeriods * event->period);
+}
@@ -0,0 +1,71 @@
+#ifndef OPENWSN_ASN_EVENTS_H
+#define OPENWSN_ASN_EVENTS_H
+
+/**
+\addtogroup MAClow
+\{
+\addtogroup asn_events
+\{
+
+\brief Events triggered at a given Absolute Slot Number.
+
+A component registers a callback for an absolute ASN, optionally repeated every
+given number of slots. The events are kept sorted by ASN, so the MAC only
+compares the current ASN with the earliest event at every slot. When an event is
+due, its callback is pushed to the scheduler as a task, it never runs in the
+slot interrupt. A callback which is still pending is not pushed again.
+
+Events whose ASN is already past when the mote synchronizes are not dispatched:
+one-time events are dropped and periodic events move to their next occurrence.
+*/
+
+#include "opendefs.h"
+#include "scheduler.h"
+
+//=========================== define ==========================================
+
+#ifndef ASN_EVENTS_MAX
+#define ASN_EVENTS_MAX              8
+#endif
+
+#define ASN_EVENTS_NONE             0xFF
+
+//=========================== typedef =========================================
+
+typedef uint8_t asn_events_id_t;
+
+typedef struct {
+    asn_t asn;                      // of the next occurrence
+    uint32_t period;                // in slots, 0 for a one-time event
+    task_cbt callback;
+    task_prio_t prio;
+    bool isUsed;
+    asn_events_id_t next;           // next event in ASN order
+} asn_event_t;
+
+//=========================== module variables ================================
+
+typedef struct {
+    asn_event_t events[ASN_EVENTS_MAX];
+    asn_events_id_t head;           // earliest event, ASN_EVENTS_NONE if there is none
+} asn_events_vars_t;
+
+//=========================== prototypes ======================================
+
+void asn_events_init(void);
+
+asn_events_id_t asn_events_schedule(asn_t *asn, uint32_t period, task_cbt callback, task_prio_t prio);
+
+void asn_events_cancel(asn_events_id_t id);
+
+// from the MAC, in interrupt context
+void asn_events_indicateAsn(asn_t *asn);
+
+void asn_events_indicateSync(asn_t *asn);
+
+/**
+\}
+\}
+*/
+
+#endif /* OPENWSN_ASN_EVENTS_H */
@@ -71,11 +71,12 @@ void msf_init(void) {
 
     msf_vars.housekeepingTimerId = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_MSF);
     msf_vars.housekeepingPeriod = HOUSEKEEPING_PERIOD;
-    opentimers_scheduleIn(
+    opentimers_scheduleInWithSlack(
             msf_vars.housekeepingTimerId,
             openrandom_getRandomizePeriod(msf_vars.housekeepingPeriod, msf_vars.housekeepingPeriod),
             TIME_MS,
             TIMER_PERIODIC,
+            HOUSEKEEPING_SLACK,
             msf_timer_housekeeping_cb
     );
     msf_vars.waitretryTimerId = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_MSF);
@@ -89,6 +90,11 @@ void msf_updateCellsElapsed(open_addr_t *neighbor, cellType_t type) {
         return;
     }
 
+    // the cells to a parent in the static schedule are not adapted
+    if (schedule_hasStaticCellToNeighbor(neighbor, CELLTYPE_TX)) {
+        return;
+    }
+
     // update numcellselapsed
     switch (type) {
         case CELLTYPE_TX:
@@ -479,6 +485,11 @@ void msf_housekeeping(void) {
         return;
     }
 
+    if (schedule_hasStaticCellToNeighbor(&parentNeighbor, CELLTYPE_TX)) {
+        // the cells to the parent are in the static schedule, nothing to negotiate
+        return;
+    }
+
     if (schedule_getNumberOfNegotiatedCells(&parentNeighbor, CELLTYPE_TX) == 0) {
         msf_vars.needAddTx = TRUE;
         msf_trigger6pAdd();
@@ -88,7 +88,7 @@ conditions:
 */
 open_addr_t* neighbors_getKANeighbor(uint16_t kaPeriod) {
     uint8_t i;
-    uint16_t timeSinceHeard;
+    PORT_TIMER_WIDTH timeSinceHeard;
 
     // policy is not to KA to non-preferred parents so go strait to check if Preferred Parent is aging
     if (icmpv6rpl_getPreferredParentIndex(&i)) {      // we have a Parent
@@ -637,6 +637,80 @@ void neighbors_removeOld(void) {
     }
 }
 
+//===== snapshot
+
+/**
+\brief Copy a row of the neighbor table.
+
+\param[in] index    The index of the row.
+\param[out] row     Where to copy the row to.
+
+\returns TRUE if that row is in use, FALSE otherwise.
+*/
+bool neighbors_getNeighborRow(uint8_t index, neighborRow_t *row) {
+    memcpy(row, &neighbors_vars.neighbors[index], sizeof(neighborRow_t));
+    return neighbors_vars.neighbors[index].used;
+}
+
+/**
+\brief Restore a neighbor from a snapshot taken before a reset.
+
+If the neighbor was heard since the reset, its row is kept and only gets the
+6P sequence number and the link statistics of the snapshot, and its rank if it
+did not advertise one yet. Otherwise, the neighbor is added as if it was heard
+at asnTimestamp.
+
+\param[in] row            The neighbor, as in the snapshot.
+\param[in] asnTimestamp   ASN at which a new neighbor is considered heard.
+
+\returns TRUE if the neighbor is in the table, FALSE if the table is full.
+*/
+bool neighbors_restoreNeighborRow(neighborRow_t *row, asn_t *asnTimestamp) {
+    uint8_t i;
+    neighborRow_t *neighbor;
+
+    for (i = 0; i < MAXNUMNEIGHBORS; i++) {
+        if (isThisRowMatching(&row->addr_64b, i)) {
+            break;
+        }
+    }
+
+    if (i < MAXNUMNEIGHBORS) {
+        neighbor = &neighbors_vars.neighbors[i];
+        if (neighbor->DAGrank == DEFAULTDAGRANK) {
+            neighbor->DAGrank = row->DAGrank;
+        }
+    } else {
+        for (i = 0; i < MAXNUMNEIGHBORS; i++) {
+            if (neighbors_vars.neighbors[i].used == FALSE) {
+                break;
+            }
+        }
+        if (i == MAXNUMNEIGHBORS) {
+            return FALSE;
+        }
+        neighbor = &neighbors_vars.neighbors[i];
+        neighbor->used = TRUE;
+        neighbor->insecure = FALSE;
+        neighbor->stableNeighbor = TRUE;
+        neighbor->switchStabilityCounter = 0;
+        memcpy(&neighbor->addr_64b, &row->addr_64b, sizeof(open_addr_t));
+        neighbor->DAGrank = row->DAGrank;
+        neighbor->rssi = row->rssi;
+        neighbor->numRx = 0;
+        memcpy(&neighbor->asn, asnTimestamp, sizeof(asn_t));
+        neighbor->joinPrio = row->joinPrio;
+        neighbor->backoffExponenton = MINBE - 1;
+        neighbor->backoff = 0;
+    }
+    neighbor->sequenceNumber = row->sequenceNumber;
+    neighbor->numTx = row->numTx;
+    neighbor->numTxACK = row->numTxACK;
+    neighbor->numWraps = row->numWraps;
+
+    return TRUE;
+}
+
 //===== debug
 
 /**
@@ -139,6 +139,11 @@ void neighbors_resetBackoff(open_addr_t *address);
 // maintenance
 void neighbors_removeOld(void);
 
+// snapshot
+bool neighbors_getNeighborRow(uint8_t index, neighborRow_t *row);
+
+bool neighbors_restoreNeighborRow(neighborRow_t *row, asn_t *asnTimestamp);
+
 // debug
 bool debugPrint_neighbors(void);
 
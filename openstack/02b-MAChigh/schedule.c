@@ -7,9 +7,19 @@
 #include "idmanager.h"
 #include "msf.h"
 #include "IEEE802154E.h"
+#include "asnfunctions.h"
 #include "icmpv6rpl.h"
 #include "neighbors.h"
 
+#if STATIC_SCHEDULE
+// generated at build time, next to this file
+#include "schedule_static.h"
+
+#if SCHEDULE_STATIC_MAX_NODE_CELLS > NUMSLOTSOFF
+#error "a mote has more cells in the static schedule than NUMSLOTSOFF"
+#endif
+#endif
+
 //=========================== definition ======================================
 
 //=========================== variables =======================================
@@ -22,6 +32,40 @@ void schedule_resetEntry(scheduleEntry_t *pScheduleEntry);
 
 void schedule_resetBackupEntry(backupEntry_t *pBackupEntry);
 
+scheduleEntry_t *schedule_getEntry(slotOffset_t slotOffset);
+
+uint8_t schedule_getNeighborList(open_addr_t *neighbor);
+
+void schedule_linkNeighborCell(uint8_t entry);
+
+void schedule_unlinkNeighborCell(uint8_t entry);
+
+void schedule_setNextActiveSlot(slotOffset_t from, slotOffset_t to, slotOffset_t nextActiveSlot);
+
+uint8_t schedule_getSlotframe(uint8_t frameHandle);
+
+scheduleEntry_t *schedule_getFrameEntry(uint8_t slotframe, slotOffset_t slotOffset);
+
+scheduleEntry_t *schedule_getFreeEntry(void);
+
+owerror_t schedule_insertCell(scheduleEntry_t *slotContainer);
+
+void schedule_removeCell(scheduleEntry_t *slotContainer);
+
+void schedule_syncSlotframe(uint8_t slotframe, slotOffset_t slotOffset);
+
+slotOffset_t schedule_getAsnSlotOffset(frameLength_t frameLength);
+
+uint16_t schedule_getNumSlotsToNextActiveSlot(void);
+
+frameLength_t schedule_getCommonPeriod(frameLength_t frameLength1, frameLength_t frameLength2);
+
+#if STATIC_SCHEDULE
+
+void schedule_loadStaticSchedule(void);
+
+#endif
+
 //=========================== public ==========================================
 
 //=== admin
@@ -37,6 +81,8 @@ void schedule_init(void) {
 
     // reset local variables
     memset(&schedule_vars, 0, sizeof(schedule_vars_t));
+    memset(schedule_vars.slotIndex, SCHEDULE_NO_ENTRY, sizeof(schedule_vars.slotIndex));
+    memset(schedule_vars.neighborCells, SCHEDULE_NO_ENTRY, sizeof(schedule_vars.neighborCells));
     for (running_slotOffset = 0; running_slotOffset < MAXACTIVESLOTS; running_slotOffset++) {
         schedule_resetEntry(&schedule_vars.scheduleBuf[running_slotOffset]);
         for (i = 0; i < MAXBACKUPSLOTS; i++) {
@@ -49,6 +95,10 @@ void schedule_init(void) {
     if (idmanager_getIsDAGroot() == TRUE) {
         schedule_startDAGroot();
     }
+
+#if STATIC_SCHEDULE
+    schedule_loadStaticSchedule();
+#endif
 }
 
 /**
@@ -61,7 +111,7 @@ void schedule_startDAGroot(void) {
 
     start_slotOffset = SCHEDULE_MINIMAL_6TISCH_SLOTOFFSET;
     // set frame length, handle and number (default 1 by now)
-    if (schedule_vars.frameLength == 0) {
+    if (schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].length == 0) {
         // slotframe length is not set, set it to default length
         schedule_setFrameLength(SLOTFRAME_LENGTH);
     } else {
@@ -153,7 +203,7 @@ void schedule_setFrameLength(frameLength_t newFrameLength) {
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    schedule_vars.frameLength = newFrameLength;
+    schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].length = newFrameLength;
     if (newFrameLength <= MAXACTIVESLOTS) {
         schedule_vars.maxActiveSlots = newFrameLength;
     }
@@ -170,7 +220,7 @@ void schedule_setFrameHandle(uint8_t frameHandle) {
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    schedule_vars.frameHandle = frameHandle;
+    schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].handle = frameHandle;
 
     ENABLE_INTERRUPTS();
 }
@@ -190,6 +240,194 @@ void schedule_setFrameNumber(uint8_t frameNumber) {
     ENABLE_INTERRUPTS();
 }
 
+/**
+\brief Add a slotframe next to the default one.
+
+The slotframe starts at ASN 0, like all slotframes, and is synchronized to the
+ASN at the next active slot. Its cells are added with
+schedule_addActiveSlotToFrame(). They are not managed by 6top.
+
+\param frameHandle The handle of the new slotframe. When cells of several
+   slotframes fall in the same timeslot, the cell of the slotframe with the
+   lowest handle is used.
+\param frameLength The length of the new slotframe, in slots.
+
+\returns E_SUCCESS if the slotframe was added, E_FAIL if the handle is already
+   in use or if there is no room for another slotframe.
+*/
+owerror_t schedule_addSlotframe(uint8_t frameHandle, frameLength_t frameLength) {
+    uint8_t i;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    if (frameLength == 0 || schedule_getSlotframe(frameHandle) != SCHEDULE_NO_ENTRY) {
+        ENABLE_INTERRUPTS();
+        return E_FAIL;
+    }
+
+    for (i = SCHEDULE_DEFAULT_SLOTFRAME + 1; i < SCHEDULE_MAX_SLOTFRAMES; i++) {
+        if (schedule_vars.slotframes[i].length == 0) {
+            schedule_vars.slotframes[i].handle = frameHandle;
+            schedule_vars.slotframes[i].length = frameLength;
+            schedule_vars.slotframes[i].slotOffset = 0;
+            schedule_vars.slotframes[i].scheduleEntry = NULL;
+            schedule_vars.slotframes[i].needsSync = TRUE;
+            schedule_vars.numExtraSlotframes++;
+
+            ENABLE_INTERRUPTS();
+            return E_SUCCESS;
+        }
+    }
+
+    ENABLE_INTERRUPTS();
+    return E_FAIL;
+}
+
+/**
+\brief Remove a slotframe added with schedule_addSlotframe(), and all its cells.
+
+\param frameHandle The handle of the slotframe to remove.
+*/
+owerror_t schedule_removeSlotframe(uint8_t frameHandle) {
+    uint8_t slotframe;
+    uint8_t i;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    slotframe = schedule_getSlotframe(frameHandle);
+    if (slotframe == SCHEDULE_NO_ENTRY || slotframe == SCHEDULE_DEFAULT_SLOTFRAME) {
+        ENABLE_INTERRUPTS();
+        return E_FAIL;
+    }
+
+    for (i = 0; i < MAXACTIVESLOTS; i++) {
+        if (
+                schedule_vars.scheduleBuf[i].type != CELLTYPE_OFF &&
+                schedule_vars.scheduleBuf[i].slotframe == slotframe
+                ) {
+            schedule_removeCell(&schedule_vars.scheduleBuf[i]);
+        }
+    }
+
+    schedule_vars.slotframes[slotframe].length = 0;
+    schedule_vars.numExtraSlotframes--;
+
+    ENABLE_INTERRUPTS();
+    return E_SUCCESS;
+}
+
+/**
+\brief Add a new active slot into a slotframe.
+
+Cells of the default slotframe are added with schedule_addActiveSlot(), the
+other slotframes hold a single cell per slot offset.
+
+\param frameHandle      The handle of the slotframe
+\param slotOffset       The slotoffset of the new slot
+\param type             The type of the cell
+\param shared           Whether this cell is shared (TRUE) or not (FALSE).
+\param channelOffset    The channelOffset of the new slot
+\param neighbor         The neighbor associated with this cell (all 0's if
+   none)
+*/
+owerror_t schedule_addActiveSlotToFrame(
+        uint8_t frameHandle,
+        slotOffset_t slotOffset,
+        cellType_t type,
+        bool shared,
+        channelOffset_t channelOffset,
+        open_addr_t *neighbor
+) {
+    uint8_t asn[5];
+    uint8_t slotframe;
+    scheduleEntry_t *slotContainer;
+    owerror_t outcome;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    slotframe = schedule_getSlotframe(frameHandle);
+    if (slotframe == SCHEDULE_DEFAULT_SLOTFRAME) {
+        ENABLE_INTERRUPTS();
+        return schedule_addActiveSlot(slotOffset, type, shared, FALSE, channelOffset, neighbor);
+    }
+    if (slotframe == SCHEDULE_NO_ENTRY || slotOffset >= schedule_vars.slotframes[slotframe].length) {
+        ENABLE_INTERRUPTS();
+        return E_FAIL;
+    }
+
+    if (schedule_getFrameEntry(slotframe, slotOffset) != NULL) {
+        ENABLE_INTERRUPTS();
+        LOG_ERROR(COMPONENT_SCHEDULE, ERR_SCHEDULE_ADD_DUPLICATE_SLOT,
+                  (errorparameter_t) slotOffset,
+                  (errorparameter_t) frameHandle);
+        return E_FAIL;
+    }
+
+    slotContainer = schedule_getFreeEntry();
+    if (slotContainer == NULL) {
+        ENABLE_INTERRUPTS();
+        LOG_ERROR(COMPONENT_SCHEDULE, ERR_SCHEDULE_OVERFLOWN, (errorparameter_t) 0, (errorparameter_t) 0);
+        return E_FAIL;
+    }
+
+    // fill that schedule entry with parameters passed
+    slotContainer->slotOffset = slotOffset;
+    slotContainer->slotframe = slotframe;
+    slotContainer->type = type;
+    slotContainer->shared = shared;
+    slotContainer->channelOffset = channelOffset;
+    slotContainer->isAutoCell = FALSE;
+    memcpy(&(slotContainer->neighbor), neighbor, sizeof(open_addr_t));
+
+    // fill that schedule entry with current asn
+    ieee154e_getAsn(&(asn[0]));
+    asnfunctions_fromArray(&slotContainer->lastUsedAsn, asn);
+
+    outcome = schedule_insertCell(slotContainer);
+
+    ENABLE_INTERRUPTS();
+    return outcome;
+}
+
+/**
+\brief Remove the active slot at a slot offset of a slotframe.
+
+\param frameHandle      The handle of the slotframe
+\param slotOffset       The slotoffset of the slot to remove.
+*/
+owerror_t schedule_removeActiveSlotFromFrame(uint8_t frameHandle, slotOffset_t slotOffset) {
+    uint8_t slotframe;
+    scheduleEntry_t *slotContainer;
+    slotinfo_element_t info;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    slotframe = schedule_getSlotframe(frameHandle);
+    if (slotframe == SCHEDULE_DEFAULT_SLOTFRAME) {
+        ENABLE_INTERRUPTS();
+        schedule_getSlotInfo(slotOffset, &info);
+        return schedule_removeActiveSlot(slotOffset, info.link_type, info.shared, &info.address);
+    }
+    slotContainer = NULL;
+    if (slotframe != SCHEDULE_NO_ENTRY) {
+        slotContainer = schedule_getFrameEntry(slotframe, slotOffset);
+    }
+    if (slotContainer == NULL) {
+        ENABLE_INTERRUPTS();
+        LOG_CRITICAL(COMPONENT_SCHEDULE, ERR_FREEING_ERROR, (errorparameter_t) 0, (errorparameter_t) 0);
+        return E_FAIL;
+    }
+
+    schedule_removeCell(slotContainer);
+
+    ENABLE_INTERRUPTS();
+    return E_SUCCESS;
+}
+
 /**
 \brief Get the information of a specific slot.
 
@@ -200,21 +438,15 @@ void schedule_getSlotInfo(slotOffset_t slotOffset, slotinfo_element_t *info) {
 
     scheduleEntry_t *slotContainer;
 
-    // find an empty schedule entry container
-    slotContainer = &schedule_vars.scheduleBuf[0];
-    while (slotContainer <= &schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots - 1]) {
-        //check that this entry for that neighbour and timeslot is not already scheduled.
-        if (slotContainer->slotOffset == slotOffset) {
-            //it exists so this is an update.
-            info->link_type = slotContainer->type;
-            info->shared = slotContainer->shared;
-            info->slotOffset = slotOffset;
-            info->channelOffset = slotContainer->channelOffset;
-            info->isAutoCell = slotContainer->isAutoCell;
-            memcpy(&(info->address), &(slotContainer->neighbor), sizeof(open_addr_t));
-            return; //as this is an update. No need to re-insert as it is in the same position on the list.
-        }
-        slotContainer++;
+    slotContainer = schedule_getEntry(slotOffset);
+    if (slotContainer != NULL) {
+        info->link_type = slotContainer->type;
+        info->shared = slotContainer->shared;
+        info->slotOffset = slotOffset;
+        info->channelOffset = slotContainer->channelOffset;
+        info->isAutoCell = slotContainer->isAutoCell;
+        memcpy(&(info->address), &(slotContainer->neighbor), sizeof(open_addr_t));
+        return;
     }
     // return cell type off
     info->link_type = CELLTYPE_OFF;
@@ -244,54 +476,49 @@ owerror_t schedule_addActiveSlot(
 ) {
     uint8_t asn[5];
     scheduleEntry_t *slotContainer;
-    scheduleEntry_t *previousSlotWalker;
-    scheduleEntry_t *nextSlotWalker;
 
     backupEntry_t *backupEntry;
 
     uint8_t i;
-    bool entry_found;
+    uint8_t entry;
     bool inBackupEntries;
+    owerror_t outcome;
 
     bool needSwapEntries;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    // find an empty schedule entry container
-    entry_found = FALSE;
     inBackupEntries = FALSE;
-    slotContainer = &schedule_vars.scheduleBuf[0];
-    do {
-        if (slotContainer->type != CELLTYPE_OFF) {
-            if (slotContainer->slotOffset == slotOffset) {
-                // found one entry with same slotoffset in schedule, check if there is space in second entries
-
-                for (i = 0; i < MAXBACKUPSLOTS; i++) {
-                    if (slotContainer->backupEntries[i].type == CELLTYPE_OFF) {
-                        inBackupEntries = TRUE;
-                        backupEntry = &(slotContainer->backupEntries[i]);
-                        break;
-                    }
-                }
-                if (inBackupEntries) {
-                    entry_found = TRUE;
-                    break;
-                }
+    slotContainer = schedule_getEntry(slotOffset);
+    if (slotContainer != NULL) {
+        // found one entry with same slotoffset in schedule, check if there is space in second entries
+        for (i = 0; i < MAXBACKUPSLOTS; i++) {
+            if (slotContainer->backupEntries[i].type == CELLTYPE_OFF) {
+                inBackupEntries = TRUE;
+                backupEntry = &(slotContainer->backupEntries[i]);
+                break;
             }
-            slotContainer++;
-        } else {
-            entry_found = TRUE;
-            break;
         }
-    } while (slotContainer <= &schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots - 1]);
+        if (inBackupEntries == FALSE) {
+            ENABLE_INTERRUPTS();
+            LOG_ERROR(COMPONENT_SCHEDULE, ERR_SCHEDULE_ADD_DUPLICATE_SLOT,
+                      (errorparameter_t) slotOffset,
+                      (errorparameter_t) 0);
+            return E_FAIL;
+        }
+    } else {
+        // find an empty schedule entry container
+        slotContainer = schedule_getFreeEntry();
 
-    // abort it schedule overflow
-    if (entry_found == FALSE) {
-        ENABLE_INTERRUPTS();
-        LOG_ERROR(COMPONENT_SCHEDULE, ERR_SCHEDULE_OVERFLOWN, (errorparameter_t) 0, (errorparameter_t) 0);
-        return E_FAIL;
+        // abort it schedule overflow
+        if (slotContainer == NULL) {
+            ENABLE_INTERRUPTS();
+            LOG_ERROR(COMPONENT_SCHEDULE, ERR_SCHEDULE_OVERFLOWN, (errorparameter_t) 0, (errorparameter_t) 0);
+            return E_FAIL;
+        }
     }
+    entry = slotContainer - &schedule_vars.scheduleBuf[0];
 
     // assign the next slot pointer if it's allocated in backup entries
     if (inBackupEntries) {
@@ -316,6 +543,9 @@ owerror_t schedule_addActiveSlot(
 
         if (needSwapEntries) {
 
+            // the entry changes neighbor
+            schedule_unlinkNeighborCell(entry);
+
             // backup current entries
             backupEntry->type = slotContainer->type;
             backupEntry->shared = slotContainer->shared;
@@ -327,9 +557,7 @@ owerror_t schedule_addActiveSlot(
             backupEntry->numRx = slotContainer->numRx;
             backupEntry->numTx = slotContainer->numTx;
             backupEntry->numTxACK = slotContainer->numTxACK;
-            backupEntry->lastUsedAsn.byte4 = slotContainer->lastUsedAsn.byte4;
-            backupEntry->lastUsedAsn.bytes0and1 = slotContainer->lastUsedAsn.bytes0and1;
-            backupEntry->lastUsedAsn.bytes0and1 = slotContainer->lastUsedAsn.bytes0and1;
+            memcpy(&backupEntry->lastUsedAsn, &slotContainer->lastUsedAsn, sizeof(asn_t));
             backupEntry->next = slotContainer->next;
 
             // add cell to schedule
@@ -341,9 +569,9 @@ owerror_t schedule_addActiveSlot(
 
             // fill that schedule entry with current asn
             ieee154e_getAsn(&(asn[0]));
-            slotContainer->lastUsedAsn.bytes0and1 = 256 * asn[1] + asn[0];
-            slotContainer->lastUsedAsn.bytes2and3 = 256 * asn[3] + asn[2];
-            slotContainer->lastUsedAsn.byte4 = asn[4];
+            asnfunctions_fromArray(&slotContainer->lastUsedAsn, asn);
+
+            schedule_linkNeighborCell(entry);
         } else {
             // add cell to backup schedule
 
@@ -355,19 +583,19 @@ owerror_t schedule_addActiveSlot(
 
             // fill that schedule entry with current asn
             ieee154e_getAsn(&(asn[0]));
-            backupEntry->lastUsedAsn.bytes0and1 = 256 * asn[1] + asn[0];
-            backupEntry->lastUsedAsn.bytes2and3 = 256 * asn[3] + asn[2];
-            backupEntry->lastUsedAsn.byte4 = asn[4];
+            asnfunctions_fromArray(&backupEntry->lastUsedAsn, asn);
 
             // use the same next point in schedule
             backupEntry->next = slotContainer->next;
         }
+        schedule_vars.numBackupCells++;
         ENABLE_INTERRUPTS();
         return E_SUCCESS;
     }
 
     // fill that schedule entry with parameters passed
     slotContainer->slotOffset = slotOffset;
+    slotContainer->slotframe = SCHEDULE_DEFAULT_SLOTFRAME;
     slotContainer->type = type;
     slotContainer->shared = shared;
     slotContainer->channelOffset = channelOffset;
@@ -376,67 +604,12 @@ owerror_t schedule_addActiveSlot(
 
     // fill that schedule entry with current asn
     ieee154e_getAsn(&(asn[0]));
-    slotContainer->lastUsedAsn.bytes0and1 = 256 * asn[1] + asn[0];
-    slotContainer->lastUsedAsn.bytes2and3 = 256 * asn[3] + asn[2];
-    slotContainer->lastUsedAsn.byte4 = asn[4];
-
-    // insert in circular list
-    if (schedule_vars.currentScheduleEntry == NULL) {
-        // this is the first active slot added
-
-        // the next slot of this slot is this slot
-        slotContainer->next = slotContainer;
-
-        // current slot points to this slot
-        schedule_vars.currentScheduleEntry = slotContainer;
-    } else {
-        // this is NOT the first active slot added
+    asnfunctions_fromArray(&slotContainer->lastUsedAsn, asn);
 
-        // find position in schedule
-        previousSlotWalker = schedule_vars.currentScheduleEntry;
-        while (1) {
-            nextSlotWalker = previousSlotWalker->next;
-            if (
-                    (
-                            (previousSlotWalker->slotOffset < slotContainer->slotOffset) &&
-                            (slotContainer->slotOffset < nextSlotWalker->slotOffset)
-                    )
-                    ||
-                    (
-                            (previousSlotWalker->slotOffset < slotContainer->slotOffset) &&
-                            (nextSlotWalker->slotOffset <= previousSlotWalker->slotOffset)
-                    )
-                    ||
-                    (
-                            (slotContainer->slotOffset < nextSlotWalker->slotOffset) &&
-                            (nextSlotWalker->slotOffset <= previousSlotWalker->slotOffset)
-                    )
-                    ) {
-                break;
-            }
-            if (previousSlotWalker->slotOffset == slotContainer->slotOffset) {
-                // slot is already in schedule
-                LOG_ERROR(COMPONENT_SCHEDULE, ERR_SCHEDULE_ADD_DUPLICATE_SLOT,
-                          (errorparameter_t) slotContainer->slotOffset,
-                          (errorparameter_t) 0);
-                // reset the entry
-                slotContainer->slotOffset = 0;
-                slotContainer->type = CELLTYPE_OFF;
-                slotContainer->shared = FALSE;
-                slotContainer->channelOffset = 0;
-                memset(&slotContainer->neighbor, 0, sizeof(open_addr_t));
-                ENABLE_INTERRUPTS();
-                return E_FAIL;
-            }
-            previousSlotWalker = nextSlotWalker;
-        }
-        // insert between previousSlotWalker and nextSlotWalker
-        previousSlotWalker->next = slotContainer;
-        slotContainer->next = nextSlotWalker;
-    }
+    outcome = schedule_insertCell(slotContainer);
 
     ENABLE_INTERRUPTS();
-    return E_SUCCESS;
+    return outcome;
 }
 
 /**
@@ -454,9 +627,9 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, cellType_t type, bo
     bool isbackupEntry;
     backupEntry_t *backupEntry;
     uint8_t candidate_index;
+    uint8_t entry;
 
     scheduleEntry_t *slotContainer;
-    scheduleEntry_t *previousSlotWalker;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
@@ -464,31 +637,26 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, cellType_t type, bo
     // find the schedule entry
     entry_found = FALSE;
     isbackupEntry = FALSE;
-    slotContainer = &schedule_vars.scheduleBuf[0];
-    while (slotContainer <= &schedule_vars.scheduleBuf[schedule_vars.maxActiveSlots - 1]) {
-        if (slotContainer->slotOffset == slotOffset) {
-            if (packetfunctions_sameAddress(neighbor, &(slotContainer->neighbor))) {
-                entry_found = TRUE;
-                break;
-            } else {
-                for (i = 0; i < MAXBACKUPSLOTS; i++) {
-                    if (
-                            packetfunctions_sameAddress(neighbor, &(slotContainer->backupEntries[i].neighbor)) &&
-                            type == slotContainer->backupEntries[i].type &&
-                            isShared == slotContainer->backupEntries[i].shared
-                            ) {
-                        isbackupEntry = TRUE;
-                        backupEntry = &(slotContainer->backupEntries[i]);
-                        break;
-                    }
-                }
-                if (isbackupEntry) {
-                    entry_found = TRUE;
+    slotContainer = schedule_getEntry(slotOffset);
+    if (slotContainer != NULL) {
+        if (packetfunctions_sameAddress(neighbor, &(slotContainer->neighbor))) {
+            entry_found = TRUE;
+        } else {
+            for (i = 0; i < MAXBACKUPSLOTS; i++) {
+                if (
+                        packetfunctions_sameAddress(neighbor, &(slotContainer->backupEntries[i].neighbor)) &&
+                        type == slotContainer->backupEntries[i].type &&
+                        isShared == slotContainer->backupEntries[i].shared
+                        ) {
+                    isbackupEntry = TRUE;
+                    backupEntry = &(slotContainer->backupEntries[i]);
                     break;
                 }
             }
+            if (isbackupEntry) {
+                entry_found = TRUE;
+            }
         }
-        slotContainer++;
     }
 
     // abort it could not find
@@ -512,6 +680,7 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, cellType_t type, bo
         backupEntry->lastUsedAsn.bytes2and3 = 0;
         backupEntry->lastUsedAsn.byte4 = 0;
         backupEntry->next = NULL;
+        schedule_vars.numBackupCells--;
 
         ENABLE_INTERRUPTS();
         return E_SUCCESS;
@@ -530,8 +699,10 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, cellType_t type, bo
             }
         }
 
+        entry = slotContainer - &schedule_vars.scheduleBuf[0];
         if (candidate_index < MAXBACKUPSLOTS) {
-            // move the backup entry to the schedule
+            // move the backup entry to the schedule, the entry changes neighbor
+            schedule_unlinkNeighborCell(entry);
             slotContainer->type = slotContainer->backupEntries[candidate_index].type;
             slotContainer->shared = slotContainer->backupEntries[candidate_index].shared;
             slotContainer->channelOffset = slotContainer->backupEntries[candidate_index].channelOffset;
@@ -542,12 +713,13 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, cellType_t type, bo
             slotContainer->numTx = slotContainer->backupEntries[candidate_index].numTx;
             slotContainer->numRx = slotContainer->backupEntries[candidate_index].numRx;
             slotContainer->numTxACK = slotContainer->backupEntries[candidate_index].numTxACK;
-            slotContainer->lastUsedAsn.bytes0and1 = slotContainer->backupEntries[candidate_index].lastUsedAsn.bytes0and1;
-            slotContainer->lastUsedAsn.bytes2and3 = slotContainer->backupEntries[candidate_index].lastUsedAsn.bytes2and3;
-            slotContainer->lastUsedAsn.byte4 = slotContainer->backupEntries[candidate_index].lastUsedAsn.byte4;
+            memcpy(&slotContainer->lastUsedAsn, &slotContainer->backupEntries[candidate_index].lastUsedAsn, sizeof(asn_t));
 
             // reset the backup entry
             schedule_resetBackupEntry(&(slotContainer->backupEntries[candidate_index]));
+            schedule_vars.numBackupCells--;
+
+            schedule_linkNeighborCell(entry);
 
             ENABLE_INTERRUPTS();
             return E_SUCCESS;
@@ -556,81 +728,68 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, cellType_t type, bo
         }
     }
 
-    // remove from linked list
-    if (slotContainer->next == slotContainer) {
-        // this is the last active slot, the next slot of this slot is NULL
-        slotContainer->next = NULL;
-
-        // current slot points to this slot
-        schedule_vars.currentScheduleEntry = NULL;
-    } else {
-        // this is NOT the last active slot, find the previous in the schedule
-        previousSlotWalker = schedule_vars.currentScheduleEntry;
-
-        while (1) {
-            if (previousSlotWalker->next == slotContainer) {
-                break;
-            }
-            previousSlotWalker = previousSlotWalker->next;
-        }
-
-        // remove this element from the linked list, i.e. have the previous slot "jump" to slotContainer's next
-        previousSlotWalker->next = slotContainer->next;
-
-        // update current slot if points to slot I just removed
-        if (schedule_vars.currentScheduleEntry == slotContainer) {
-            /**
-                attention: this should only happen at the end of slot. It's dangerous to remove current schedule entry
-                in the middle of the slot. The item access of currentScheduleEntry could be from unexpected entry.
-
-                In case the entry is removed at endSlot(), the currentScheduleEntry should be the previous entry. This
-                is because when the next active slot arrives, currentScheduleEntry will be assigned as
-                currentScheduleEntry->next
-            */
-            schedule_vars.currentScheduleEntry = previousSlotWalker;
-        }
-    }
-
-    // reset removed schedule entry
-    schedule_resetEntry(slotContainer);
+    schedule_removeCell(slotContainer);
 
     ENABLE_INTERRUPTS();
 
     return E_SUCCESS;
 }
 
-bool schedule_isSlotOffsetAvailable(uint16_t slotOffset) {
+/**
+\brief Check whether a slot offset of the default slotframe is free for a new
+   negotiated cell.
 
-    scheduleEntry_t *scheduleWalker;
+The slot offset is not free if it holds a cell, or if it falls, in some cycle,
+in the same timeslot as a cell of another slotframe, such as the static
+schedule.
+*/
+bool schedule_isSlotOffsetAvailable(uint16_t slotOffset) {
+    bool returnVal;
+    uint8_t i;
+    frameLength_t period;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    if (slotOffset >= schedule_vars.frameLength) {
+    if (slotOffset >= schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].length) {
         ENABLE_INTERRUPTS();
         return FALSE;
     }
 
-    scheduleWalker = schedule_vars.currentScheduleEntry;
-    do {
-        if (slotOffset == scheduleWalker->slotOffset) {
-            ENABLE_INTERRUPTS();
-            return FALSE;
+    returnVal = (schedule_getEntry(slotOffset) == NULL);
+
+    for (i = 0; i < MAXACTIVESLOTS && returnVal && schedule_vars.numExtraSlotframes > 0; i++) {
+        if (
+                schedule_vars.scheduleBuf[i].type != CELLTYPE_OFF &&
+                schedule_vars.scheduleBuf[i].slotframe != SCHEDULE_DEFAULT_SLOTFRAME
+                ) {
+            period = schedule_getCommonPeriod(
+                    schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].length,
+                    schedule_vars.slotframes[schedule_vars.scheduleBuf[i].slotframe].length
+            );
+            if (slotOffset % period == schedule_vars.scheduleBuf[i].slotOffset % period) {
+                returnVal = FALSE;
+            }
         }
-        scheduleWalker = scheduleWalker->next;
-    } while (scheduleWalker != schedule_vars.currentScheduleEntry);
+    }
 
     ENABLE_INTERRUPTS();
 
-    return TRUE;
+    return returnVal;
 }
 
 void schedule_removeAllNegotiatedCellsToNeighbor(uint8_t slotframeID, open_addr_t *neighbor) {
     uint8_t i;
-
-    // remove all entries in schedule with previousHop address
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
+    uint8_t next;
+
+    // remove all entries in schedule with previousHop address, the cells of
+    // the other slotframes are not negotiated
+    i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+    while (i != SCHEDULE_NO_ENTRY) {
+        // removing a cell can move a backup cell into its entry
+        next = schedule_vars.scheduleBuf[i].nextNeighborCell;
         if (
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
                 packetfunctions_sameAddress(&(schedule_vars.scheduleBuf[i].neighbor), neighbor) &&
                 (
                         schedule_vars.scheduleBuf[i].type == CELLTYPE_TX ||
@@ -644,6 +803,7 @@ void schedule_removeAllNegotiatedCellsToNeighbor(uint8_t slotframeID, open_addr_
                     neighbor
             );
         }
+        i = next;
     }
 }
 
@@ -674,13 +834,29 @@ uint8_t schedule_getNumberOfNegotiatedCells(open_addr_t *neighbor, cellType_t ce
     DISABLE_INTERRUPTS();
 
     counter = 0;
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
         if (
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
                 schedule_vars.scheduleBuf[i].shared == FALSE &&
                 schedule_vars.scheduleBuf[i].type == cell_type &&
                 packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE
                 ) {
             counter++;
+        }
+    }
+
+    // negotiated cells can also be behind autonomous cells, in backup entries
+    for (i = 0; i < MAXACTIVESLOTS && schedule_vars.numBackupCells > 0; i++) {
+        if (
+                schedule_vars.scheduleBuf[i].shared == FALSE &&
+                schedule_vars.scheduleBuf[i].type == cell_type &&
+                packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE
+                ) {
+            // already counted
         } else {
             if (schedule_vars.scheduleBuf[i].isAutoCell) {
                 for (j = 0; j < MAXBACKUPSLOTS; j++) {
@@ -704,6 +880,59 @@ uint8_t schedule_getNumberOfNegotiatedCells(open_addr_t *neighbor, cellType_t ce
     return counter;
 }
 
+/**
+\brief Get one of the negotiated cells of the default slotframe.
+
+Looking up every index from 0 to SCHEDULE_NUM_CELLS-1 returns all the negotiated
+cells, including those behind autonomous cells, in backup entries.
+
+\param[in] index    The index of the cell in the schedule.
+\param[out] info    The negotiated cell at that index.
+
+\returns TRUE if there is a negotiated cell at that index, FALSE otherwise.
+*/
+bool schedule_getNegotiatedCell(uint8_t index, slotinfo_element_t *info) {
+    scheduleEntry_t *entry;
+    backupEntry_t *backupEntry;
+    bool found;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    found = FALSE;
+    entry = &schedule_vars.scheduleBuf[index / (1 + MAXBACKUPSLOTS)];
+    if (entry->type != CELLTYPE_OFF && entry->slotframe == SCHEDULE_DEFAULT_SLOTFRAME) {
+        if (index % (1 + MAXBACKUPSLOTS) == 0) {
+            if (entry->isAutoCell == FALSE && entry->neighbor.type == ADDR_64B) {
+                info->link_type = entry->type;
+                info->shared = entry->shared;
+                info->channelOffset = entry->channelOffset;
+                memcpy(&(info->address), &(entry->neighbor), sizeof(open_addr_t));
+                found = TRUE;
+            }
+        } else {
+            backupEntry = &entry->backupEntries[index % (1 + MAXBACKUPSLOTS) - 1];
+            if (
+                    backupEntry->type != CELLTYPE_OFF &&
+                    backupEntry->isAutoCell == FALSE &&
+                    backupEntry->neighbor.type == ADDR_64B
+                    ) {
+                info->link_type = backupEntry->type;
+                info->shared = backupEntry->shared;
+                info->channelOffset = backupEntry->channelOffset;
+                memcpy(&(info->address), &(backupEntry->neighbor), sizeof(open_addr_t));
+                found = TRUE;
+            }
+        }
+        info->slotOffset = entry->slotOffset;
+        info->isAutoCell = FALSE;
+    }
+
+    ENABLE_INTERRUPTS();
+
+    return found;
+}
+
 bool schedule_isNumTxWrapped(open_addr_t *neighbor) {
     uint8_t i;
     bool returnVal;
@@ -712,8 +941,15 @@ bool schedule_isNumTxWrapped(open_addr_t *neighbor) {
     DISABLE_INTERRUPTS();
 
     returnVal = FALSE;
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
-        if (packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE) {
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
+        if (
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
+                packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE
+                ) {
             if (schedule_vars.scheduleBuf[i].numTx > 0xFF / 2) {
                 returnVal = TRUE;
             }
@@ -735,8 +971,15 @@ bool schedule_getCellsToBeRelocated(open_addr_t *neighbor, cellInfo_ht *celllist
     DISABLE_INTERRUPTS();
 
     // found the cell with higest PDR
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
-        if (packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE) {
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
+        if (
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
+                packetfunctions_sameAddress(&schedule_vars.scheduleBuf[i].neighbor, neighbor) == TRUE
+                ) {
             if (schedule_vars.scheduleBuf[i].numTx > MINIMAL_NUM_TX) {
                 cellPDR = 100 * schedule_vars.scheduleBuf[i].numTxACK / schedule_vars.scheduleBuf[i].numTx;
                 if (cellPDR < RELOCATE_PDRTHRES) {
@@ -761,8 +1004,13 @@ bool schedule_hasAutonomousTxRxCellUnicast(open_addr_t *neighbor) {
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
         if (
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
                 schedule_vars.scheduleBuf[i].type == CELLTYPE_TXRX &&
                 schedule_vars.scheduleBuf[i].shared &&
                 schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B &&
@@ -783,8 +1031,13 @@ bool schedule_getAutonomousTxRxCellUnicastNeighbor(open_addr_t *neighbor) {
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
         if (
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
                 schedule_vars.scheduleBuf[i].type == CELLTYPE_TXRX &&
                 schedule_vars.scheduleBuf[i].shared &&
                 schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B &&
@@ -806,8 +1059,13 @@ bool schedule_hasAutoTxCellToNeighbor(open_addr_t *neighbor) {
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
         if (
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
                 schedule_vars.scheduleBuf[i].shared == TRUE &&
                 schedule_vars.scheduleBuf[i].type == CELLTYPE_TX &&
                 schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B &&
@@ -828,7 +1086,11 @@ bool schedule_hasNegotiatedCellToNeighbor(open_addr_t *neighbor, cellType_t cell
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
         if (
                 schedule_vars.scheduleBuf[i].shared == FALSE &&
                 schedule_vars.scheduleBuf[i].type == cell_type &&
@@ -860,6 +1122,7 @@ bool schedule_hasNegotiatedTxCellToNonParent(open_addr_t *parentNeighbor, open_a
     for (i = 0; i < MAXACTIVESLOTS; i++) {
         if (
                 schedule_vars.scheduleBuf[i].type == CELLTYPE_TX &&
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
                 schedule_vars.scheduleBuf[i].shared == FALSE &&
                 schedule_vars.scheduleBuf[i].neighbor.type == ADDR_64B &&
                 packetfunctions_sameAddress(parentNeighbor, &schedule_vars.scheduleBuf[i].neighbor) == FALSE
@@ -874,14 +1137,55 @@ bool schedule_hasNegotiatedTxCellToNonParent(open_addr_t *parentNeighbor, open_a
     return FALSE;
 }
 
+/**
+\brief Check whether there is a cell to a neighbor in a slotframe other than
+   the default one, such as the static schedule.
+
+Those cells are not negotiated, MSF leaves the neighbor alone.
+
+\param neighbor     The neighbor address.
+\param cell_type    The type of cell.
+*/
+bool schedule_hasStaticCellToNeighbor(open_addr_t *neighbor, cellType_t cell_type) {
+    uint8_t i;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(neighbor)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
+        if (
+                schedule_vars.scheduleBuf[i].slotframe != SCHEDULE_DEFAULT_SLOTFRAME &&
+                schedule_vars.scheduleBuf[i].type == cell_type &&
+                packetfunctions_sameAddress(neighbor, &schedule_vars.scheduleBuf[i].neighbor)
+                ) {
+            ENABLE_INTERRUPTS();
+            return TRUE;
+        }
+    }
+
+    ENABLE_INTERRUPTS();
+    return FALSE;
+}
+
 bool schedule_getAutonomousTxRxCellAnycast(uint16_t *slotoffset) {
     uint8_t i;
+    open_addr_t anycast;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for (i = 0; i < MAXACTIVESLOTS; i++) {
+    anycast.type = ADDR_ANYCAST;
+    for (
+            i = schedule_vars.neighborCells[schedule_getNeighborList(&anycast)];
+            i != SCHEDULE_NO_ENTRY;
+            i = schedule_vars.scheduleBuf[i].nextNeighborCell
+            ) {
         if (
+                schedule_vars.scheduleBuf[i].slotframe == SCHEDULE_DEFAULT_SLOTFRAME &&
                 schedule_vars.scheduleBuf[i].type == CELLTYPE_TXRX &&
                 schedule_vars.scheduleBuf[i].shared == FALSE &&
                 schedule_vars.scheduleBuf[i].neighbor.type == ADDR_ANYCAST
@@ -898,13 +1202,33 @@ bool schedule_getAutonomousTxRxCellAnycast(uint16_t *slotoffset) {
 
 //=== from IEEE802154E: reading the schedule and updating statistics
 
+/**
+\brief Synchronize the schedule to the current slot.
+
+\param targetSlotOffset The slot offset of the current slot in the default
+   slotframe. The slot offsets in the other slotframes are derived from the
+   ASN.
+*/
 void schedule_syncSlotOffset(slotOffset_t targetSlotOffset) {
+    scheduleEntry_t *slotContainer;
+    uint8_t i;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    while (schedule_vars.currentScheduleEntry->slotOffset != targetSlotOffset) {
-        schedule_advanceSlot();
+    slotContainer = schedule_getEntry(targetSlotOffset);
+    if (slotContainer != NULL) {
+        schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].slotOffset = targetSlotOffset;
+        schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].scheduleEntry = slotContainer;
+    } else {
+        schedule_syncSlotframe(SCHEDULE_DEFAULT_SLOTFRAME, targetSlotOffset);
+    }
+    schedule_vars.currentScheduleEntry = schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].scheduleEntry;
+
+    for (i = SCHEDULE_DEFAULT_SLOTFRAME + 1; i < SCHEDULE_MAX_SLOTFRAMES; i++) {
+        if (schedule_vars.slotframes[i].length > 0) {
+            schedule_syncSlotframe(i, schedule_getAsnSlotOffset(schedule_vars.slotframes[i].length));
+        }
     }
 
     ENABLE_INTERRUPTS();
@@ -912,26 +1236,90 @@ void schedule_syncSlotOffset(slotOffset_t targetSlotOffset) {
 
 /**
 \brief advance to next active slot
+
+With several slotframes, all of them advance to the next active slot, and the
+cell of the slotframe with the lowest handle becomes the current one. The slot
+offset of each slotframe is the ASN modulo its length, so a slotframe which
+missed an advance, because its slot was aborted before, catches up here.
 */
 void schedule_advanceSlot(void) {
+    uint16_t numSlots;
+    slotOffset_t asnSlotOffset;
+    slotframe_t *slotframe;
+    scheduleEntry_t *nextSlot;
+    uint8_t i;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
-    schedule_vars.currentScheduleEntry = schedule_vars.currentScheduleEntry->next;
+
+    if (schedule_vars.numExtraSlotframes == 0) {
+        schedule_vars.currentScheduleEntry = schedule_vars.currentScheduleEntry->next;
+        schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].scheduleEntry = schedule_vars.currentScheduleEntry;
+        schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].slotOffset = schedule_vars.currentScheduleEntry->slotOffset;
+
+        ENABLE_INTERRUPTS();
+        return;
+    }
+
+    numSlots = schedule_getNumSlotsToNextActiveSlot();
+    nextSlot = NULL;
+    for (i = 0; i < SCHEDULE_MAX_SLOTFRAMES; i++) {
+        slotframe = &schedule_vars.slotframes[i];
+        if (slotframe->length == 0) {
+            continue;
+        }
+        // the ASN is the one of the slot starting
+        asnSlotOffset = schedule_getAsnSlotOffset(slotframe->length);
+        if (slotframe->needsSync || (slotframe->slotOffset + numSlots) % slotframe->length != asnSlotOffset) {
+            schedule_syncSlotframe(i, asnSlotOffset);
+        } else {
+            slotframe->slotOffset = asnSlotOffset;
+            if (
+                    slotframe->scheduleEntry != NULL &&
+                    ((scheduleEntry_t *) (slotframe->scheduleEntry->next))->slotOffset == slotframe->slotOffset
+                    ) {
+                slotframe->scheduleEntry = slotframe->scheduleEntry->next;
+            }
+        }
+        if (
+                slotframe->scheduleEntry != NULL &&
+                slotframe->scheduleEntry->slotOffset == slotframe->slotOffset &&
+                (
+                        nextSlot == NULL ||
+                        slotframe->handle < schedule_vars.slotframes[nextSlot->slotframe].handle
+                )
+                ) {
+            nextSlot = slotframe->scheduleEntry;
+        }
+    }
+    if (nextSlot != NULL) {
+        schedule_vars.currentScheduleEntry = nextSlot;
+    }
 
     ENABLE_INTERRUPTS();
 }
 
 /**
 \brief return slotOffset of next active slot
+
+With several slotframes, this is the slot offset in the default slotframe of
+the next slot active in any of the slotframes.
 */
 slotOffset_t schedule_getNextActiveSlotOffset(void) {
     slotOffset_t res;
+    slotframe_t *slotframe;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    res = ((scheduleEntry_t *) (schedule_vars.currentScheduleEntry->next))->slotOffset;
+    slotframe = &schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME];
+    if (schedule_vars.numExtraSlotframes > 0 && slotframe->length > 0) {
+        res = (slotframe->slotOffset + schedule_getNumSlotsToNextActiveSlot()) % slotframe->length;
+    } else if (schedule_vars.currentScheduleEntry->slotOffset < SCHEDULE_INDEX_LENGTH) {
+        res = schedule_vars.nextActiveSlot[schedule_vars.currentScheduleEntry->slotOffset];
+    } else {
+        res = ((scheduleEntry_t *) (schedule_vars.currentScheduleEntry->next))->slotOffset;
+    }
 
     ENABLE_INTERRUPTS();
 
@@ -949,7 +1337,7 @@ frameLength_t schedule_getFrameLength(void) {
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    returnVal = schedule_vars.frameLength;
+    returnVal = schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].length;
 
     ENABLE_INTERRUPTS();
 
@@ -1013,6 +1401,26 @@ bool schedule_getIsAutoCell(void) {
     return returnVal;
 }
 
+/**
+\brief Check whether the current schedule entry is in the default slotframe.
+
+Only the cells of the default slotframe are managed by 6top.
+
+\returns TRUE if the current schedule entry is in the default slotframe.
+*/
+bool schedule_getIsDefaultSlotframe(void) {
+    bool returnVal;
+
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    returnVal = (schedule_vars.currentScheduleEntry->slotframe == SCHEDULE_DEFAULT_SLOTFRAME);
+
+    ENABLE_INTERRUPTS();
+
+    return returnVal;
+}
+
 /**
 \brief Get the neighbor associated wit the current schedule entry.
 
@@ -1216,16 +1624,24 @@ bool schedule_getOneCellAfterOffset(uint8_t metadata, uint8_t offset, open_addr_
     }
 
     returnVal = FALSE;
-    scheduleWalker = &schedule_vars.scheduleBuf[0]; // fisrt entry record slotoffset 0
+    scheduleWalker = schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].scheduleEntry;
+    if (scheduleWalker == NULL) {
+        ENABLE_INTERRUPTS();
+        return FALSE;
+    }
+    // the first cell after the offset in the default slotframe
     do {
-        if (type == scheduleWalker->type && scheduleWalker->slotOffset >= offset) {
+        if (
+                type == scheduleWalker->type &&
+                scheduleWalker->slotOffset >= offset &&
+                (returnVal == FALSE || scheduleWalker->slotOffset < *slotoffset)
+                ) {
             *slotoffset = scheduleWalker->slotOffset;
             *channeloffset = scheduleWalker->channelOffset;
             returnVal = TRUE;
-            break;
         }
         scheduleWalker = scheduleWalker->next;
-    } while (scheduleWalker != &schedule_vars.scheduleBuf[0]);
+    } while (scheduleWalker != schedule_vars.slotframes[SCHEDULE_DEFAULT_SLOTFRAME].scheduleEntry);
 
     ENABLE_INTERRUPTS();
 
@@ -1255,6 +1671,8 @@ void schedule_resetEntry(scheduleEntry_t *e) {
     e->lastUsedAsn.bytes2and3 = 0;
     e->lastUsedAsn.byte4 = 0;
     e->next = NULL;
+    e->nextNeighborCell = SCHEDULE_NO_ENTRY;
+    e->slotframe = SCHEDULE_DEFAULT_SLOTFRAME;
 }
 
 void schedule_resetBackupEntry(backupEntry_t *e) {
@@ -1275,3 +1693,505 @@ void schedule_resetBackupEntry(backupEntry_t *e) {
     e->next = NULL;
 }
 
+/**
+\brief Find the cell at a slot offset of the default slotframe.
+
+\pre This function assumes interrupts are already disabled.
+
+\returns The schedule entry of the cell, NULL if the slot is not active.
+*/
+scheduleEntry_t *schedule_getEntry(slotOffset_t slotOffset) {
+    if (slotOffset < SCHEDULE_INDEX_LENGTH) {
+        if (schedule_vars.slotIndex[slotOffset] == SCHEDULE_NO_ENTRY) {
+            return NULL;
+        }
+        return &schedule_vars.scheduleBuf[schedule_vars.slotIndex[slotOffset]];
+    }
+
+    // beyond the index, walk the schedule
+    return schedule_getFrameEntry(SCHEDULE_DEFAULT_SLOTFRAME, slotOffset);
+}
+
+/**
+\brief Select the per-neighbor cell list of a neighbor.
+
+64-bit addresses are hashed over their bytes, all the other addresses of a
+type share a list.
+*/
+uint8_t schedule_getNeighborList(open_addr_t *neighbor) {
+    uint8_t i;
+    uint8_t hash;
+
+    hash = neighbor->type;
+    if (neighbor->type == ADDR_64B) {
+        for (i = 0; i < LENGTH_ADDR64b; i++) {
+            hash ^= neighbor->addr_64b[i];
+        }
+    }
+    return hash & (SCHEDULE_NUM_NEIGHBOR_LISTS - 1);
+}
+
+/**
+\brief Insert an entry in the cell list of its neighbor.
+
+The list is kept in the order of the schedule table, so that walking it finds
+the cells in the same order as walking the table.
+
+\pre This function assumes interrupts are already disabled.
+*/
+void schedule_linkNeighborCell(uint8_t entry) {
+    uint8_t *link;
+
+    link = &schedule_vars.neighborCells[schedule_getNeighborList(&schedule_vars.scheduleBuf[entry].neighbor)];
+    while (*link != SCHEDULE_NO_ENTRY && *link < entry) {
+        link = &schedule_vars.scheduleBuf[*link].nextNeighborCell;
+    }
+    schedule_vars.scheduleBuf[entry].nextNeighborCell = *link;
+    *link = entry;
+}
+
+/**
+\brief Remove an entry from the cell list of its neighbor.
+
+\pre This function assumes interrupts are already disabled.
+*/
+void schedule_unlinkNeighborCell(uint8_t entry) {
+    uint8_t *link;
+
+    link = &schedule_vars.neighborCells[schedule_getNeighborList(&schedule_vars.scheduleBuf[entry].neighbor)];
+    while (*link != SCHEDULE_NO_ENTRY) {
+        if (*link == entry) {
+            *link = schedule_vars.scheduleBuf[entry].nextNeighborCell;
+            break;
+        }
+        link = &schedule_vars.scheduleBuf[*link].nextNeighborCell;
+    }
+    schedule_vars.scheduleBuf[entry].nextNeighborCell = SCHEDULE_NO_ENTRY;
+}
+
+/**
+\brief Set the next active slot offset of a range of slot offsets.
+
+The range starts at from and ends before to, wrapping around the end of the
+slotframe if to is not greater than from. Slot offsets beyond the index are
+skipped.
+
+\pre This function assumes interrupts are already disabled.
+*/
+void schedule_setNextActiveSlot(slotOffset_t from, slotOffset_t to, slotOffset_t nextActiveSlot) {
+    slotOffset_t slotOffset;
+
+    if (from < to) {
+        for (slotOffset = from; slotOffset < to && slotOffset < SCHEDULE_INDEX_LENGTH; slotOffset++) {
+            schedule_vars.nextActiveSlot[slotOffset] = nextActiveSlot;
+        }
+    } else {
+        for (slotOffset = from; slotOffset < SCHEDULE_INDEX_LENGTH; slotOffset++) {
+            schedule_vars.nextActiveSlot[slotOffset] = nextActiveSlot;
+        }
+        for (slotOffset = 0; slotOffset < to && slotOffset < SCHEDULE_INDEX_LENGTH; slotOffset++) {
+            schedule_vars.nextActiveSlot[slotOffset] = nextActiveSlot;
+        }
+    }
+}
+
+/**
+\brief Find the slotframe with a handle.
+
+\pre This function assumes interrupts are already disabled.
+
+\returns The index of the slotframe, SCHEDULE_NO_ENTRY if no slotframe in use
+   has this handle.
+*/
+uint8_t schedule_getSlotframe(uint8_t frameHandle) {
+    uint8_t i;
+
+    for (i = 0; i < SCHEDULE_MAX_SLOTFRAMES; i++) {
+        if (
+                (i == SCHEDULE_DEFAULT_SLOTFRAME || schedule_vars.slotframes[i].length > 0) &&
+                schedule_vars.slotframes[i].handle == frameHandle
+                ) {
+            return i;
+        }
+    }
+    return SCHEDULE_NO_ENTRY;
+}
+
+/**
+\brief Find the cell at a slot offset of a slotframe, by walking the schedule.
+
+\pre This function assumes interrupts are already disabled.
+
+\returns The schedule entry of the cell, NULL if the slot is not active.
+*/
+scheduleEntry_t *schedule_getFrameEntry(uint8_t slotframe, slotOffset_t slotOffset) {
+    uint8_t i;
+
+    for (i = 0; i < schedule_vars.maxActiveSlots; i++) {
+        if (
+                schedule_vars.scheduleBuf[i].type != CELLTYPE_OFF &&
+                schedule_vars.scheduleBuf[i].slotframe == slotframe &&
+                schedule_vars.scheduleBuf[i].slotOffset == slotOffset
+                ) {
+            return &schedule_vars.scheduleBuf[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+\brief Find an empty schedule entry.
+
+\pre This function assumes interrupts are already disabled.
+
+\returns The empty schedule entry, NULL if the schedule is full.
+*/
+scheduleEntry_t *schedule_getFreeEntry(void) {
+    uint8_t i;
+
+    for (i = 0; i < schedule_vars.maxActiveSlots; i++) {
+        if (schedule_vars.scheduleBuf[i].type == CELLTYPE_OFF) {
+            return &schedule_vars.scheduleBuf[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+\brief Insert a filled schedule entry in the cells of its slotframe.
+
+The cells of each slotframe form a circular list ordered by slot offset. The
+cells of the default slotframe are also indexed by slot offset and by neighbor.
+
+\pre This function assumes interrupts are already disabled.
+*/
+owerror_t schedule_insertCell(scheduleEntry_t *slotContainer) {
+    slotframe_t *slotframe;
+    scheduleEntry_t *previousSlotWalker;
+    scheduleEntry_t *nextSlotWalker;
+    slotOffset_t previousSlotOffset;
+    uint8_t entry;
+
+    slotframe = &schedule_vars.slotframes[slotContainer->slotframe];
+    entry = slotContainer - &schedule_vars.scheduleBuf[0];
+
+    // insert in circular list
+    if (slotframe->scheduleEntry == NULL) {
+        // this is the first active slot added
+
+        // the next slot of this slot is this slot
+        slotContainer->next = slotContainer;
+        previousSlotOffset = slotContainer->slotOffset;
+
+        // the slotframe points to this slot
+        slotframe->scheduleEntry = slotContainer;
+    } else {
+        // this is NOT the first active slot added
+
+        // find position in schedule
+        previousSlotWalker = slotframe->scheduleEntry;
+        while (1) {
+            nextSlotWalker = previousSlotWalker->next;
+            if (
+                    (
+                            (previousSlotWalker->slotOffset < slotContainer->slotOffset) &&
+                            (slotContainer->slotOffset < nextSlotWalker->slotOffset)
+                    )
+                    ||
+                    (
+                            (previousSlotWalker->slotOffset < slotContainer->slotOffset) &&
+                            (nextSlotWalker->slotOffset <= previousSlotWalker->slotOffset)
+                    )
+                    ||
+                    (
+                            (slotContainer->slotOffset < nextSlotWalker->slotOffset) &&
+                            (nextSlotWalker->slotOffset <= previousSlotWalker->slotOffset)
+                    )
+                    ) {
+                break;
+            }
+            if (previousSlotWalker->slotOffset == slotContainer->slotOffset) {
+                // slot is already in schedule
+                LOG_ERROR(COMPONENT_SCHEDULE, ERR_SCHEDULE_ADD_DUPLICATE_SLOT,
+                          (errorparameter_t) slotContainer->slotOffset,
+                          (errorparameter_t) 0);
+                // reset the entry
+                slotContainer->slotOffset = 0;
+                slotContainer->type = CELLTYPE_OFF;
+                slotContainer->shared = FALSE;
+                slotContainer->channelOffset = 0;
+                memset(&slotContainer->neighbor, 0, sizeof(open_addr_t));
+                return E_FAIL;
+            }
+            previousSlotWalker = nextSlotWalker;
+        }
+        // insert between previousSlotWalker and nextSlotWalker
+        previousSlotWalker->next = slotContainer;
+        slotContainer->next = nextSlotWalker;
+        previousSlotOffset = previousSlotWalker->slotOffset;
+
+        // a cell between the last cell reached and the current slot becomes the last cell reached
+        if (
+                slotframe->length > 0 &&
+                (slotContainer->slotOffset + slotframe->length - slotframe->scheduleEntry->slotOffset) % slotframe->length <=
+                (slotframe->slotOffset + slotframe->length - slotframe->scheduleEntry->slotOffset) % slotframe->length
+                ) {
+            if (schedule_vars.currentScheduleEntry == slotframe->scheduleEntry) {
+                schedule_vars.currentScheduleEntry = slotContainer;
+            }
+            slotframe->scheduleEntry = slotContainer;
+        }
+    }
+
+    // current slot points to this slot if there was none
+    if (schedule_vars.currentScheduleEntry == NULL) {
+        schedule_vars.currentScheduleEntry = slotContainer;
+    }
+
+    if (slotContainer->slotframe == SCHEDULE_DEFAULT_SLOTFRAME) {
+        // index the new cell, the slots from the previous active slot on now lead to it
+        if (slotContainer->slotOffset < SCHEDULE_INDEX_LENGTH) {
+            schedule_vars.slotIndex[slotContainer->slotOffset] = entry;
+        }
+        schedule_setNextActiveSlot(previousSlotOffset, slotContainer->slotOffset, slotContainer->slotOffset);
+    }
+    schedule_linkNeighborCell(entry);
+
+    return E_SUCCESS;
+}
+
+/**
+\brief Remove a schedule entry from the cells of its slotframe, and reset it.
+
+\pre This function assumes interrupts are already disabled.
+*/
+void schedule_removeCell(scheduleEntry_t *slotContainer) {
+    slotframe_t *slotframe;
+    scheduleEntry_t *previousSlotWalker;
+    uint8_t i;
+
+    slotframe = &schedule_vars.slotframes[slotContainer->slotframe];
+
+    // remove from linked list
+    if (slotContainer->next == slotContainer) {
+        // this is the last active slot of the slotframe, the next slot of this slot is NULL
+        slotContainer->next = NULL;
+        previousSlotWalker = NULL;
+
+        slotframe->scheduleEntry = NULL;
+    } else {
+        // this is NOT the last active slot, find the previous in the slotframe
+        previousSlotWalker = slotframe->scheduleEntry;
+
+        while (1) {
+            if (previousSlotWalker->next == slotContainer) {
+                break;
+            }
+            previousSlotWalker = previousSlotWalker->next;
+        }
+
+        // remove this element from the linked list, i.e. have the previous slot "jump" to slotContainer's next
+        previousSlotWalker->next = slotContainer->next;
+
+        if (slotContainer->slotframe == SCHEDULE_DEFAULT_SLOTFRAME) {
+            // the slots from the previous active slot up to this one now lead to the next active slot
+            schedule_setNextActiveSlot(
+                    previousSlotWalker->slotOffset,
+                    slotContainer->slotOffset + 1,
+                    ((scheduleEntry_t *) (slotContainer->next))->slotOffset
+            );
+        }
+
+        if (slotframe->scheduleEntry == slotContainer) {
+            slotframe->scheduleEntry = previousSlotWalker;
+        }
+    }
+
+    // update current slot if points to slot I just removed
+    if (schedule_vars.currentScheduleEntry == slotContainer) {
+        /**
+            attention: this should only happen at the end of slot. It's dangerous to remove current schedule entry
+            in the middle of the slot. The item access of currentScheduleEntry could be from unexpected entry.
+
+            In case the entry is removed at endSlot(), the currentScheduleEntry should be the previous entry. This
+            is because when the next active slot arrives, the next active slot is found after the previous entry.
+        */
+        schedule_vars.currentScheduleEntry = previousSlotWalker;
+        for (i = 0; i < SCHEDULE_MAX_SLOTFRAMES && schedule_vars.currentScheduleEntry == NULL; i++) {
+            schedule_vars.currentScheduleEntry = schedule_vars.slotframes[i].scheduleEntry;
+        }
+    }
+
+    if (slotContainer->slotframe == SCHEDULE_DEFAULT_SLOTFRAME) {
+        // remove the entry from the indexes
+        if (slotContainer->slotOffset < SCHEDULE_INDEX_LENGTH) {
+            schedule_vars.slotIndex[slotContainer->slotOffset] = SCHEDULE_NO_ENTRY;
+        }
+    }
+    schedule_unlinkNeighborCell(slotContainer - &schedule_vars.scheduleBuf[0]);
+
+    // reset removed schedule entry
+    schedule_resetEntry(slotContainer);
+}
+
+/**
+\brief Set the slot offset of the current slot in a slotframe.
+
+The last cell reached in the slotframe becomes the last cell at or before that
+slot offset.
+
+\pre This function assumes interrupts are already disabled.
+*/
+void schedule_syncSlotframe(uint8_t slotframe, slotOffset_t slotOffset) {
+    slotframe_t *frame;
+    scheduleEntry_t *slotWalker;
+    scheduleEntry_t *lastSlot;
+
+    frame = &schedule_vars.slotframes[slotframe];
+    frame->slotOffset = slotOffset;
+    frame->needsSync = FALSE;
+    if (frame->scheduleEntry == NULL || frame->length == 0) {
+        return;
+    }
+
+    lastSlot = frame->scheduleEntry;
+    slotWalker = lastSlot->next;
+    while (slotWalker != frame->scheduleEntry) {
+        if (
+                (slotOffset + frame->length - slotWalker->slotOffset) % frame->length <
+                (slotOffset + frame->length - lastSlot->slotOffset) % frame->length
+                ) {
+            lastSlot = slotWalker;
+        }
+        slotWalker = slotWalker->next;
+    }
+    frame->scheduleEntry = lastSlot;
+}
+
+/**
+\brief Compute the slot offset of the current ASN in a slotframe.
+
+\returns The ASN modulo the slotframe length.
+*/
+slotOffset_t schedule_getAsnSlotOffset(frameLength_t frameLength) {
+    uint8_t asn[5];
+    uint32_t slotOffset;
+
+    ieee154e_getAsn(&(asn[0]));
+
+    slotOffset = asn[4] % frameLength;
+    slotOffset = ((slotOffset << 16) + 256 * asn[3] + asn[2]) % frameLength;
+    slotOffset = ((slotOffset << 16) + 256 * asn[1] + asn[0]) % frameLength;
+
+    return (slotOffset_t) slotOffset;
+}
+
+/**
+\brief Count the slots from the current slot to the next active slot of any
+   slotframe.
+
+Slotframes waiting to be synchronized to the ASN are not taken into account.
+
+\pre This function assumes interrupts are already disabled.
+
+\returns The number of slots, 0 if no slotframe has cells.
+*/
+uint16_t schedule_getNumSlotsToNextActiveSlot(void) {
+    uint16_t numSlots;
+    uint16_t frameSlots;
+    slotOffset_t nextSlotOffset;
+    slotframe_t *slotframe;
+    uint8_t i;
+
+    numSlots = 0;
+    for (i = 0; i < SCHEDULE_MAX_SLOTFRAMES; i++) {
+        slotframe = &schedule_vars.slotframes[i];
+        if (slotframe->length == 0 || slotframe->scheduleEntry == NULL || slotframe->needsSync) {
+            continue;
+        }
+        if (i == SCHEDULE_DEFAULT_SLOTFRAME && slotframe->slotOffset < SCHEDULE_INDEX_LENGTH) {
+            nextSlotOffset = schedule_vars.nextActiveSlot[slotframe->slotOffset];
+        } else {
+            nextSlotOffset = ((scheduleEntry_t *) (slotframe->scheduleEntry->next))->slotOffset;
+        }
+        // a full slotframe if the next active slot is the current one
+        frameSlots = (nextSlotOffset + slotframe->length - slotframe->slotOffset - 1) % slotframe->length + 1;
+        if (numSlots == 0 || frameSlots < numSlots) {
+            numSlots = frameSlots;
+        }
+    }
+    return numSlots;
+}
+
+/**
+\brief Compute the period, in slots, at which the slot offsets of two
+   slotframes line up.
+
+Slot offset o1 of the first slotframe falls in the same timeslot as slot offset
+o2 of the second one, in some cycle, iff o1 and o2 are equal modulo this
+period.
+
+\returns The greatest common divisor of both lengths.
+*/
+frameLength_t schedule_getCommonPeriod(frameLength_t frameLength1, frameLength_t frameLength2) {
+    frameLength_t remainder;
+
+    while (frameLength2 != 0) {
+        remainder = frameLength1 % frameLength2;
+        frameLength1 = frameLength2;
+        frameLength2 = remainder;
+    }
+    return frameLength1;
+}
+
+#if STATIC_SCHEDULE
+
+/**
+\brief Add the cells of this mote from the static schedule.
+
+The static schedule is generated at build time from a description of the
+deployment, see site_scons/staticSchedule.py. The cells are added to a
+slotframe of their own, which is not managed by 6top. A mote which is not part
+of the deployment has no static cells.
+*/
+void schedule_loadStaticSchedule(void) {
+    open_addr_t *myId;
+    open_addr_t neighbor;
+    const staticScheduleNode_t *node;
+    const staticScheduleCell_t *cell;
+    uint16_t i;
+    uint8_t j;
+
+    myId = idmanager_getMyID(ADDR_64B);
+    node = NULL;
+    for (i = 0; i < SCHEDULE_STATIC_NUM_NODES; i++) {
+        if (memcmp(schedule_static_nodes[i].eui64, myId->addr_64b, 8) == 0) {
+            node = &schedule_static_nodes[i];
+            break;
+        }
+    }
+    if (node == NULL) {
+        return;
+    }
+
+    if (schedule_addSlotframe(SCHEDULE_STATIC_FRAME_HANDLE, SCHEDULE_STATIC_FRAME_LENGTH) != E_SUCCESS) {
+        return;
+    }
+
+    memset(&neighbor, 0, sizeof(open_addr_t));
+    neighbor.type = ADDR_64B;
+    for (j = 0; j < node->numCells; j++) {
+        cell = &schedule_static_cells[node->firstCell + j];
+        memcpy(neighbor.addr_64b, cell->neighbor, sizeof(neighbor.addr_64b));
+        schedule_addActiveSlotToFrame(
+                SCHEDULE_STATIC_FRAME_HANDLE,   // slotframe handle
+                cell->slotOffset,               // slot offset
+                cell->type,                     // type of slot
+                cell->shared,                   // shared?
+                cell->channelOffset,            // channel offset
+                &neighbor                       // neighbor
+        );
+    }
+}
+
+#endif
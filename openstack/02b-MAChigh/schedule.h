@@ -72,6 +72,50 @@ those slots's next pointer is pointing to the same entries.
 #define MAXBACKUPSLOTS   2
 #endif
 
+/**
+\brief Number of cells the schedule can hold, counting those in backup entries.
+*/
+#define SCHEDULE_NUM_CELLS      (MAXACTIVESLOTS*(1+MAXBACKUPSLOTS))
+
+/**
+\brief Number of slot offsets covered by the slot-indexed tables of the schedule.
+
+For each slot offset below this value, the schedule keeps the entry of the cell
+at that offset and the next active slot offset, so that looking them up does
+not walk the schedule. Cells at higher slot offsets, only possible with a
+slotframe longer than SLOTFRAME_LENGTH, are still found by walking the
+schedule.
+*/
+#ifndef SCHEDULE_INDEX_LENGTH
+#define SCHEDULE_INDEX_LENGTH   SLOTFRAME_LENGTH
+#endif
+
+/**
+\brief Number of per-neighbor cell lists, must be a power of 2.
+
+Neighbors are hashed onto the lists, each list holds the cells of its
+neighbors in the order of the schedule table.
+*/
+#ifndef SCHEDULE_NUM_NEIGHBOR_LISTS
+#define SCHEDULE_NUM_NEIGHBOR_LISTS  8
+#endif
+
+#define SCHEDULE_NO_ENTRY       0xff
+
+/**
+\brief Maximum number of slotframes running at the same time.
+
+The default slotframe, the one advertised in EBs and managed by 6top, is always
+the first one. The other slotframes are added with schedule_addSlotframe().
+When cells of several slotframes fall in the same timeslot, the cell of the
+slotframe with the lowest handle is used.
+*/
+#ifndef SCHEDULE_MAX_SLOTFRAMES
+#define SCHEDULE_MAX_SLOTFRAMES 2
+#endif
+
+#define SCHEDULE_DEFAULT_SLOTFRAME  0 // index of the default slotframe
+
 /**
 \brief Minimum backoff exponent.
 
@@ -140,8 +184,18 @@ typedef struct {
     asn_t lastUsedAsn;
     backupEntry_t backupEntries[MAXBACKUPSLOTS];
     void *next;
+    uint8_t nextNeighborCell;   // next entry in the per-neighbor cell list, SCHEDULE_NO_ENTRY if last
+    uint8_t slotframe;          // index of the slotframe of this cell
 } scheduleEntry_t;
 
+typedef struct {
+    uint8_t handle;                     // slotframe handle, lower handles take precedence
+    frameLength_t length;               // length in slots, 0 if the slotframe is not in use
+    slotOffset_t slotOffset;            // slot offset of the current slot in this slotframe
+    scheduleEntry_t *scheduleEntry;     // last cell reached in this slotframe, NULL if it has no cells
+    bool needsSync;                     // the slot offset is to be set from the ASN at the next active slot
+} slotframe_t;
+
 BEGIN_PACK
 typedef struct {
     uint8_t row;
@@ -166,14 +220,33 @@ typedef struct {
     bool isAutoCell;
 } slotinfo_element_t;
 
+// tables of the static schedule, generated at build time (STATIC_SCHEDULE)
+typedef struct {
+    uint8_t eui64[8];
+    uint16_t firstCell;         // index of the first cell of this mote in schedule_static_cells
+    uint8_t numCells;
+} staticScheduleNode_t;
+
+typedef struct {
+    slotOffset_t slotOffset;
+    channelOffset_t channelOffset;
+    cellType_t type;
+    bool shared;
+    uint8_t neighbor[8];
+} staticScheduleCell_t;
+
 //=========================== variables =======================================
 
 typedef struct {
     scheduleEntry_t scheduleBuf[MAXACTIVESLOTS];
     scheduleEntry_t *currentScheduleEntry;
-    frameLength_t frameLength;
+    uint8_t slotIndex[SCHEDULE_INDEX_LENGTH];            // entry of the cell at each slot offset, SCHEDULE_NO_ENTRY if none
+    slotOffset_t nextActiveSlot[SCHEDULE_INDEX_LENGTH];  // next active slot offset after each slot offset
+    uint8_t neighborCells[SCHEDULE_NUM_NEIGHBOR_LISTS];  // first entry of each per-neighbor cell list
+    uint8_t numBackupCells;                              // number of cells in backup entries
+    slotframe_t slotframes[SCHEDULE_MAX_SLOTFRAMES];     // the default slotframe first
+    uint8_t numExtraSlotframes;                          // number of slotframes in use besides the default one
     frameLength_t maxActiveSlots;
-    uint8_t frameHandle;
     uint8_t frameNumber;
     uint8_t backoffExponenton;
     uint8_t backoff;
@@ -198,6 +271,21 @@ void schedule_setFrameHandle(uint8_t frameHandle);
 
 void schedule_setFrameNumber(uint8_t frameNumber);
 
+owerror_t schedule_addSlotframe(uint8_t frameHandle, frameLength_t frameLength);
+
+owerror_t schedule_removeSlotframe(uint8_t frameHandle);
+
+owerror_t schedule_addActiveSlotToFrame(
+        uint8_t frameHandle,
+        slotOffset_t slotOffset,
+        cellType_t type,
+        bool shared,
+        uint8_t channelOffset,
+        open_addr_t *neighbor
+);
+
+owerror_t schedule_removeActiveSlotFromFrame(uint8_t frameHandle, slotOffset_t slotOffset);
+
 owerror_t schedule_addActiveSlot(
         slotOffset_t slotOffset,
         cellType_t type,
@@ -229,6 +317,8 @@ uint8_t schedule_getNumberOfFreeEntries(void);
 
 uint8_t schedule_getNumberOfNegotiatedCells(open_addr_t *neighbor, cellType_t cell_type);
 
+bool schedule_getNegotiatedCell(uint8_t index, slotinfo_element_t *info);
+
 bool schedule_isNumTxWrapped(open_addr_t *neighbor);
 
 bool schedule_getCellsToBeRelocated(open_addr_t *neighbor, cellInfo_ht *celllist);
@@ -249,6 +339,8 @@ void schedule_hasNegotiatedTxCell(open_addr_t *address);
 
 bool schedule_hasNegotiatedTxCellToNonParent(open_addr_t *parentNeighbor, open_addr_t *nonParentNeighbor);
 
+bool schedule_hasStaticCellToNeighbor(open_addr_t *neighbor, cellType_t cell_type);
+
 // from IEEE802154E
 void schedule_syncSlotOffset(slotOffset_t targetSlotOffset);
 
@@ -264,6 +356,8 @@ bool schedule_getShared(void);
 
 bool schedule_getIsAutoCell(void);
 
+bool schedule_getIsDefaultSlotframe(void);
+
 void schedule_getNeighbor(open_addr_t *addrToWrite);
 
 slotOffset_t schedule_getSlottOffset(void);
@@ -14,6 +14,7 @@
 #include "debugpins.h"
 #include "IEEE802154.h"
 #include "IEEE802154_security.h"
+#include "IEEE802154_ie.h"
 #include "idmanager.h"
 #include "schedule.h"
 #include "msf.h"
@@ -129,11 +130,12 @@ void sixtop_init(void) {
     );
 
     sixtop_vars.maintenanceTimerId = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_SIXTOP);
-    opentimers_scheduleIn(
+    opentimers_scheduleInWithSlack(
             sixtop_vars.maintenanceTimerId,
             sixtop_vars.periodMaintenance,
             TIME_MS,
             TIMER_PERIODIC,
+            SLOTDURATION,   // may be one slot late, to share a wakeup
             sixtop_maintenance_timer_cb
     );
 
@@ -401,8 +403,10 @@ void task_sixtopNotifSendDone(void) {
     // take ownership
     msg->owner = COMPONENT_SIXTOP;
 
-    // update neighbor statistics
-    if (msg->l2_sendDoneError == E_SUCCESS) {
+    // update neighbor statistics, unless the packet was dropped before any transmission attempt
+    if (msg->l2_numTxAttempts == 0) {
+        // nothing to account for
+    } else if (msg->l2_sendDoneError == E_SUCCESS) {
         neighbors_indicateTx(
                 &(msg->l2_nextORpreviousHop),
                 msg->l2_numTxAttempts,
@@ -601,7 +605,7 @@ owerror_t sixtop_send_internal(
         return E_FAIL;
     }
     // change owner to IEEE802154E fetches it from queue
-    msg->owner = COMPONENT_SIXTOP_TO_IEEE802154E;
+    openqueue_sixtopEnqueuePacket(msg);
 
     if (
             packetfunctions_isBroadcastMulticast(&(msg->l2_nextORpreviousHop)) == FALSE &&
@@ -762,6 +766,8 @@ port_INLINE void sixtop_sendEB(void) {
         temp16b = eb_len | IEEE802154E_PAYLOAD_DESC_GROUP_ID_MLME | IEEE802154E_PAYLOAD_DESC_TYPE_MLME;
         eb->payload[0] = (uint8_t)(temp16b & 0x00ff);
         eb->payload[1] = (uint8_t)((temp16b & 0xff00) >> 8);
+        // and the length of the slotframe and link IE
+        eb->payload[EB_SLOTFRAME_IE_LEN_OFFSET] += 5 * (ebIEsBytestream[EB_SLOTFRAME_NUMLINK_OFFSET] - 1);
     }
 
     eb->payload[EB_SLOTFRAME_LEN_OFFSET] = (uint8_t)(0x00FF & (schedule_getFrameLength()));
@@ -890,6 +896,7 @@ void timer_sixtop_six2six_timeout_fired(void) {
 }
 
 void sixtop_six2six_sendDone(OpenQueueEntry_t *msg, owerror_t error) {
+    openqueue_sixtopCellLists_t *cellLists;
 
     msg->owner = COMPONENT_SIXTOP_RES;
 
@@ -950,34 +957,36 @@ void sixtop_six2six_sendDone(OpenQueueEntry_t *msg, owerror_t error) {
             neighbors_updateSequenceNumber(&(msg->l2_nextORpreviousHop));
             // in case a response is sent out, check the return code
             if (msg->l2_sixtop_returnCode == IANA_6TOP_RC_SUCCESS) {
-                if (msg->l2_sixtop_command == IANA_6TOP_CMD_ADD) {
+                cellLists = openqueue_sixtopGetCellLists(msg);
+
+                if (msg->l2_sixtop_command == IANA_6TOP_CMD_ADD && cellLists != NULL) {
                     sixtop_addCells(
                             msg->l2_sixtop_frameID,
-                            msg->l2_sixtop_celllist_add,
+                            cellLists->celllist_add,
                             &(msg->l2_nextORpreviousHop),
                             msg->l2_sixtop_cellOptions
                     );
                 }
 
-                if (msg->l2_sixtop_command == IANA_6TOP_CMD_DELETE) {
+                if (msg->l2_sixtop_command == IANA_6TOP_CMD_DELETE && cellLists != NULL) {
                     sixtop_removeCells(
                             msg->l2_sixtop_frameID,
-                            msg->l2_sixtop_celllist_delete,
+                            cellLists->celllist_delete,
                             &(msg->l2_nextORpreviousHop),
                             msg->l2_sixtop_cellOptions
                     );
                 }
 
-                if (msg->l2_sixtop_command == IANA_6TOP_CMD_RELOCATE) {
+                if (msg->l2_sixtop_command == IANA_6TOP_CMD_RELOCATE && cellLists != NULL) {
                     sixtop_removeCells(
                             msg->l2_sixtop_frameID,
-                            msg->l2_sixtop_celllist_delete,
+                            cellLists->celllist_delete,
                             &(msg->l2_nextORpreviousHop),
                             msg->l2_sixtop_cellOptions
                     );
                     sixtop_addCells(
                             msg->l2_sixtop_frameID,
-                            msg->l2_sixtop_celllist_add,
+                            cellLists->celllist_add,
                             &(msg->l2_nextORpreviousHop),
                             msg->l2_sixtop_cellOptions
                     );
@@ -1009,38 +1018,23 @@ void sixtop_six2six_sendDone(OpenQueueEntry_t *msg, owerror_t error) {
 }
 
 port_INLINE bool sixtop_processIEs(OpenQueueEntry_t* pkt, uint16_t* lenIE) {
+    ieee802154_ie_index_t ieIndex;
     uint8_t ptr;
     uint8_t temp_8b;
-    uint8_t subtypeid,code,sfid,version,type,seqNum;
-    uint16_t temp_16b,len,headerlen;
-
-    ptr = 0;
-    headerlen = 0;
+    uint8_t code,sfid,version,type,seqNum;
 
-    // candidate IE header  if type ==0 header IE if type==1 payload IE
-    temp_8b = *((uint8_t*)(pkt->payload)+ptr);
-    ptr++;
-    temp_16b = temp_8b + ((*((uint8_t*)(pkt->payload)+ptr))<<8);
-    ptr++;
-    *lenIE += 2;
-    // check ietf ie group id, type
-    if ((temp_16b & IEEE802154E_DESC_LEN_PAYLOAD_ID_TYPE_MASK) != (IANA_IETF_IE_GROUP_ID | IANA_IETF_IE_TYPE)){
-        // wrong IE ID or type, record and drop the packet
+    if (ieee802154_ie_parse(pkt->payload, pkt->length, &ieIndex) != E_SUCCESS) {
+        // malformed IE list, record and drop the packet
         LOG_ERROR(COMPONENT_SIXTOP, ERR_UNSUPPORTED_FORMAT, (errorparameter_t)0, (errorparameter_t)0);
         return FALSE;
     }
-    len = temp_16b & IEEE802154E_DESC_LEN_PAYLOAD_IE_MASK;
-    *lenIE += len;
-
-    // check 6p subtype Id
-    subtypeid = *((uint8_t*)(pkt->payload)+ptr);
-    ptr += 1;
-    if (subtypeid != IANA_6TOP_SUBIE_ID){
-        // wrong subtypeID, record and drop the packet
+    if (ieee802154_ie_isPresent(&ieIndex, IEEE802154_IE_6P) == FALSE){
+        // no 6P IE, record and drop the packet
         LOG_ERROR(COMPONENT_SIXTOP, ERR_UNSUPPORTED_FORMAT, (errorparameter_t) 1, (errorparameter_t) 0);
         return FALSE;
     }
-    headerlen += 1;
+    // the 6P IE starts after its subtype ID
+    ptr = ieIndex.offset[IEEE802154_IE_6P];
 
     // check 6p version
     temp_8b = *((uint8_t*)(pkt->payload)+ptr);
@@ -1053,24 +1047,29 @@ port_INLINE bool sixtop_processIEs(OpenQueueEntry_t* pkt, uint16_t* lenIE) {
     }
     version = temp_8b & IANA_6TOP_VESION_MASK;
     type = temp_8b >> IANA_6TOP_TYPE_SHIFT;
-    headerlen += 1;
 
     // get 6p code
     code = *((uint8_t*)(pkt->payload)+ptr);
     ptr += 1;
-    headerlen += 1;
     // get 6p sfid
     sfid = *((uint8_t*)(pkt->payload)+ptr);
     ptr += 1;
-    headerlen += 1;
     // get 6p seqNum and GEN
     seqNum = *((uint8_t*)(pkt->payload)+ptr) & 0xff;
     ptr += 1;
-    headerlen += 1;
 
     // give six2six to process
-    sixtop_six2six_notifyReceive(version, type, code, sfid, seqNum, ptr, len-headerlen, pkt);
-    *lenIE = len+2;
+    sixtop_six2six_notifyReceive(
+            version,
+            type,
+            code,
+            sfid,
+            seqNum,
+            ptr,
+            ieIndex.length[IEEE802154_IE_6P] - (ptr - ieIndex.offset[IEEE802154_IE_6P]),
+            pkt
+    );
+    *lenIE = ieIndex.totalLength;
     return TRUE;
 }
 
@@ -1101,6 +1100,9 @@ void sixtop_six2six_notifyReceive(
     uint8_t pktLen = length;
     uint8_t response_pktLen = 0;
     cellInfo_ht celllist_list[CELLLIST_MAX_LEN];
+    cellInfo_ht celllist_add[CELLLIST_MAX_LEN];
+    cellInfo_ht celllist_delete[CELLLIST_MAX_LEN];
+    openqueue_sixtopCellLists_t *cellLists;
 
     if (type == SIXTOP_CELL_REQUEST) {
         // if this is a 6p request message
@@ -1264,6 +1266,15 @@ void sixtop_six2six_notifyReceive(
             ptr += 1;
             pktLen -= 1;
 
+            // the cells to add or remove are recorded until the response is sent
+            if (code == IANA_6TOP_CMD_ADD || code == IANA_6TOP_CMD_DELETE || code == IANA_6TOP_CMD_RELOCATE) {
+                cellLists = openqueue_sixtopAllocateCellLists(response_pkt);
+                if (cellLists == NULL) {
+                    returnCode = IANA_6TOP_RC_BUSY;
+                    break;
+                }
+            }
+
             // add command
             if (code == IANA_6TOP_CMD_ADD) {
                 if (schedule_getNumberOfFreeEntries() < numCells) {
@@ -1272,31 +1283,31 @@ void sixtop_six2six_notifyReceive(
                 }
                 // retrieve cell list
                 i = 0;
-                memset(response_pkt->l2_sixtop_celllist_add, 0, sizeof(response_pkt->l2_sixtop_celllist_add));
+                memset(cellLists->celllist_add, 0, sizeof(cellLists->celllist_add));
                 while (pktLen > 0) {
-                    response_pkt->l2_sixtop_celllist_add[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
-                    response_pkt->l2_sixtop_celllist_add[i].slotoffset |=
+                    cellLists->celllist_add[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
+                    cellLists->celllist_add[i].slotoffset |=
                             (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-                    response_pkt->l2_sixtop_celllist_add[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
-                    response_pkt->l2_sixtop_celllist_add[i].channeloffset |=
+                    cellLists->celllist_add[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
+                    cellLists->celllist_add[i].channeloffset |=
                             (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
-                    response_pkt->l2_sixtop_celllist_add[i].isUsed = TRUE;
+                    cellLists->celllist_add[i].isUsed = TRUE;
                     ptr += 4;
                     pktLen -= 4;
                     i++;
                 }
-                if (sixtop_areAvailableCellsToBeScheduled(metadata, numCells, response_pkt->l2_sixtop_celllist_add)) {
+                if (sixtop_areAvailableCellsToBeScheduled(metadata, numCells, cellLists->celllist_add)) {
                     for (i = 0; i < CELLLIST_MAX_LEN; i++) {
-                        if (response_pkt->l2_sixtop_celllist_add[i].isUsed) {
+                        if (cellLists->celllist_add[i].isUsed) {
                             packetfunctions_reserveHeader(&response_pkt, 4);
                             response_pkt->payload[0] = (uint8_t)(
-                                    response_pkt->l2_sixtop_celllist_add[i].slotoffset & 0x00FF);
+                                    cellLists->celllist_add[i].slotoffset & 0x00FF);
                             response_pkt->payload[1] = (uint8_t)(
-                                    (response_pkt->l2_sixtop_celllist_add[i].slotoffset & 0xFF00) >> 8);
+                                    (cellLists->celllist_add[i].slotoffset & 0xFF00) >> 8);
                             response_pkt->payload[2] = (uint8_t)(
-                                    response_pkt->l2_sixtop_celllist_add[i].channeloffset & 0x00FF);
+                                    cellLists->celllist_add[i].channeloffset & 0x00FF);
                             response_pkt->payload[3] = (uint8_t)(
-                                    (response_pkt->l2_sixtop_celllist_add[i].channeloffset & 0xFF00) >> 8);
+                                    (cellLists->celllist_add[i].channeloffset & 0xFF00) >> 8);
                             response_pktLen += 4;
                         }
                     }
@@ -1308,15 +1319,15 @@ void sixtop_six2six_notifyReceive(
             // delete command
             if (code == IANA_6TOP_CMD_DELETE) {
                 i = 0;
-                memset(response_pkt->l2_sixtop_celllist_delete, 0, sizeof(response_pkt->l2_sixtop_celllist_delete));
+                memset(cellLists->celllist_delete, 0, sizeof(cellLists->celllist_delete));
                 while (pktLen > 0) {
-                    response_pkt->l2_sixtop_celllist_delete[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
-                    response_pkt->l2_sixtop_celllist_delete[i].slotoffset |=
+                    cellLists->celllist_delete[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
+                    cellLists->celllist_delete[i].slotoffset |=
                             (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-                    response_pkt->l2_sixtop_celllist_delete[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
-                    response_pkt->l2_sixtop_celllist_delete[i].channeloffset |=
+                    cellLists->celllist_delete[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
+                    cellLists->celllist_delete[i].channeloffset |=
                             (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
-                    response_pkt->l2_sixtop_celllist_delete[i].isUsed = TRUE;
+                    cellLists->celllist_delete[i].isUsed = TRUE;
                     ptr += 4;
                     pktLen -= 4;
                     i++;
@@ -1326,20 +1337,20 @@ void sixtop_six2six_notifyReceive(
                 } else {
                     cellOptions_transformed = cellOptions;
                 }
-                if (sixtop_areAvailableCellsToBeRemoved(metadata, numCells, response_pkt->l2_sixtop_celllist_delete,
+                if (sixtop_areAvailableCellsToBeRemoved(metadata, numCells, cellLists->celllist_delete,
                                                         &(pkt->l2_nextORpreviousHop), cellOptions_transformed)) {
                     returnCode = IANA_6TOP_RC_SUCCESS;
                     for (i = 0; i < CELLLIST_MAX_LEN; i++) {
-                        if (response_pkt->l2_sixtop_celllist_delete[i].isUsed) {
+                        if (cellLists->celllist_delete[i].isUsed) {
                             packetfunctions_reserveHeader(&response_pkt, 4);
                             response_pkt->payload[0] = (uint8_t)(
-                                    response_pkt->l2_sixtop_celllist_delete[i].slotoffset & 0x00FF);
+                                    cellLists->celllist_delete[i].slotoffset & 0x00FF);
                             response_pkt->payload[1] = (uint8_t)(
-                                    (response_pkt->l2_sixtop_celllist_delete[i].slotoffset & 0xFF00) >> 8);
+                                    (cellLists->celllist_delete[i].slotoffset & 0xFF00) >> 8);
                             response_pkt->payload[2] = (uint8_t)(
-                                    response_pkt->l2_sixtop_celllist_delete[i].channeloffset & 0x00FF);
+                                    cellLists->celllist_delete[i].channeloffset & 0x00FF);
                             response_pkt->payload[3] = (uint8_t)(
-                                    (response_pkt->l2_sixtop_celllist_delete[i].channeloffset & 0xFF00) >> 8);
+                                    (cellLists->celllist_delete[i].channeloffset & 0xFF00) >> 8);
                             response_pktLen += 4;
                         }
                     }
@@ -1353,16 +1364,16 @@ void sixtop_six2six_notifyReceive(
             if (code == IANA_6TOP_CMD_RELOCATE) {
                 // retrieve cell list to be relocated
                 i = 0;
-                memset(response_pkt->l2_sixtop_celllist_delete, 0, sizeof(response_pkt->l2_sixtop_celllist_delete));
+                memset(cellLists->celllist_delete, 0, sizeof(cellLists->celllist_delete));
                 temp16 = numCells;
                 while (temp16 > 0) {
-                    response_pkt->l2_sixtop_celllist_delete[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
-                    response_pkt->l2_sixtop_celllist_delete[i].slotoffset |=
+                    cellLists->celllist_delete[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
+                    cellLists->celllist_delete[i].slotoffset |=
                             (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-                    response_pkt->l2_sixtop_celllist_delete[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
-                    response_pkt->l2_sixtop_celllist_delete[i].channeloffset |=
+                    cellLists->celllist_delete[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
+                    cellLists->celllist_delete[i].channeloffset |=
                             (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
-                    response_pkt->l2_sixtop_celllist_delete[i].isUsed = TRUE;
+                    cellLists->celllist_delete[i].isUsed = TRUE;
                     ptr += 4;
                     pktLen -= 4;
                     temp16--;
@@ -1373,7 +1384,7 @@ void sixtop_six2six_notifyReceive(
                 } else {
                     cellOptions_transformed = cellOptions;
                 }
-                if (sixtop_areAvailableCellsToBeRemoved(metadata, numCells, response_pkt->l2_sixtop_celllist_delete,
+                if (sixtop_areAvailableCellsToBeRemoved(metadata, numCells, cellLists->celllist_delete,
                                                         &(pkt->l2_nextORpreviousHop), cellOptions_transformed) ==
                     FALSE) {
                     returnCode = IANA_6TOP_RC_CELLLIST_ERR;
@@ -1381,31 +1392,31 @@ void sixtop_six2six_notifyReceive(
                 }
                 // retrieve cell list to be relocated
                 i = 0;
-                memset(response_pkt->l2_sixtop_celllist_add, 0, sizeof(response_pkt->l2_sixtop_celllist_add));
+                memset(cellLists->celllist_add, 0, sizeof(cellLists->celllist_add));
                 while (pktLen > 0) {
-                    response_pkt->l2_sixtop_celllist_add[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
-                    response_pkt->l2_sixtop_celllist_add[i].slotoffset |=
+                    cellLists->celllist_add[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
+                    cellLists->celllist_add[i].slotoffset |=
                             (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-                    response_pkt->l2_sixtop_celllist_add[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
-                    response_pkt->l2_sixtop_celllist_add[i].channeloffset |=
+                    cellLists->celllist_add[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
+                    cellLists->celllist_add[i].channeloffset |=
                             (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
-                    response_pkt->l2_sixtop_celllist_add[i].isUsed = TRUE;
+                    cellLists->celllist_add[i].isUsed = TRUE;
                     ptr += 4;
                     pktLen -= 4;
                     i++;
                 }
-                if (sixtop_areAvailableCellsToBeScheduled(metadata, numCells, response_pkt->l2_sixtop_celllist_add)) {
+                if (sixtop_areAvailableCellsToBeScheduled(metadata, numCells, cellLists->celllist_add)) {
                     for (i = 0; i < CELLLIST_MAX_LEN; i++) {
-                        if (response_pkt->l2_sixtop_celllist_add[i].isUsed) {
+                        if (cellLists->celllist_add[i].isUsed) {
                             packetfunctions_reserveHeader(&response_pkt, 4);
                             response_pkt->payload[0] = (uint8_t)(
-                                    response_pkt->l2_sixtop_celllist_add[i].slotoffset & 0x00FF);
+                                    cellLists->celllist_add[i].slotoffset & 0x00FF);
                             response_pkt->payload[1] = (uint8_t)(
-                                    (response_pkt->l2_sixtop_celllist_add[i].slotoffset & 0xFF00) >> 8);
+                                    (cellLists->celllist_add[i].slotoffset & 0xFF00) >> 8);
                             response_pkt->payload[2] = (uint8_t)(
-                                    response_pkt->l2_sixtop_celllist_add[i].channeloffset & 0x00FF);
+                                    cellLists->celllist_add[i].channeloffset & 0x00FF);
                             response_pkt->payload[3] = (uint8_t)(
-                                    (response_pkt->l2_sixtop_celllist_add[i].channeloffset & 0xFF00) >> 8);
+                                    (cellLists->celllist_add[i].channeloffset & 0xFF00) >> 8);
                             response_pktLen += 4;
                         }
                     }
@@ -1474,20 +1485,20 @@ void sixtop_six2six_notifyReceive(
             switch (sixtop_vars.six2six_state) {
                 case SIX_STATE_WAIT_ADDRESPONSE:
                     i = 0;
-                    memset(pkt->l2_sixtop_celllist_add, 0, sizeof(pkt->l2_sixtop_celllist_add));
+                    memset(celllist_add, 0, sizeof(celllist_add));
                     while (pktLen > 0) {
-                        pkt->l2_sixtop_celllist_add[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
-                        pkt->l2_sixtop_celllist_add[i].slotoffset |= (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-                        pkt->l2_sixtop_celllist_add[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
-                        pkt->l2_sixtop_celllist_add[i].channeloffset |= (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
-                        pkt->l2_sixtop_celllist_add[i].isUsed = TRUE;
+                        celllist_add[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
+                        celllist_add[i].slotoffset |= (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
+                        celllist_add[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
+                        celllist_add[i].channeloffset |= (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
+                        celllist_add[i].isUsed = TRUE;
                         ptr += 4;
                         pktLen -= 4;
                         i++;
                     }
                     sixtop_addCells(
                             sixtop_vars.cb_sf_getMetadata(),     // frame id
-                            pkt->l2_sixtop_celllist_add,  // celllist to be added
+                            celllist_add,  // celllist to be added
                             &(pkt->l2_nextORpreviousHop), // neighbor that cells to be added to
                             sixtop_vars.cellOptions       // cell options
                     );
@@ -1495,21 +1506,21 @@ void sixtop_six2six_notifyReceive(
                     break;
                 case SIX_STATE_WAIT_DELETERESPONSE:
                     i = 0;
-                    memset(pkt->l2_sixtop_celllist_delete, 0, sizeof(pkt->l2_sixtop_celllist_delete));
+                    memset(celllist_delete, 0, sizeof(celllist_delete));
                     while (pktLen > 0) {
-                        pkt->l2_sixtop_celllist_delete[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
-                        pkt->l2_sixtop_celllist_delete[i].slotoffset |= (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-                        pkt->l2_sixtop_celllist_delete[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
-                        pkt->l2_sixtop_celllist_delete[i].channeloffset |=
+                        celllist_delete[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
+                        celllist_delete[i].slotoffset |= (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
+                        celllist_delete[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
+                        celllist_delete[i].channeloffset |=
                                 (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
-                        pkt->l2_sixtop_celllist_delete[i].isUsed = TRUE;
+                        celllist_delete[i].isUsed = TRUE;
                         ptr += 4;
                         pktLen -= 4;
                         i++;
                     }
                     sixtop_removeCells(
                             sixtop_vars.cb_sf_getMetadata(),
-                            pkt->l2_sixtop_celllist_delete,
+                            celllist_delete,
                             &(pkt->l2_nextORpreviousHop),
                             sixtop_vars.cellOptions
                     );
@@ -1517,13 +1528,13 @@ void sixtop_six2six_notifyReceive(
                     break;
                 case SIX_STATE_WAIT_RELOCATERESPONSE:
                     i = 0;
-                    memset(pkt->l2_sixtop_celllist_add, 0, sizeof(pkt->l2_sixtop_celllist_add));
+                    memset(celllist_add, 0, sizeof(celllist_add));
                     while (pktLen > 0) {
-                        pkt->l2_sixtop_celllist_add[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
-                        pkt->l2_sixtop_celllist_add[i].slotoffset |= (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
-                        pkt->l2_sixtop_celllist_add[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
-                        pkt->l2_sixtop_celllist_add[i].channeloffset |= (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
-                        pkt->l2_sixtop_celllist_add[i].isUsed = TRUE;
+                        celllist_add[i].slotoffset = *((uint8_t * )(pkt->payload) + ptr);
+                        celllist_add[i].slotoffset |= (*((uint8_t * )(pkt->payload) + ptr + 1)) << 8;
+                        celllist_add[i].channeloffset = *((uint8_t * )(pkt->payload) + ptr + 2);
+                        celllist_add[i].channeloffset |= (*((uint8_t * )(pkt->payload) + ptr + 3)) << 8;
+                        celllist_add[i].isUsed = TRUE;
                         ptr += 4;
                         pktLen -= 4;
                         i++;
@@ -1536,7 +1547,7 @@ void sixtop_six2six_notifyReceive(
                     );
                     sixtop_addCells(
                             sixtop_vars.cb_sf_getMetadata(),     // frame id
-                            pkt->l2_sixtop_celllist_add,  // celllist to be added
+                            celllist_add,  // celllist to be added
                             &(pkt->l2_nextORpreviousHop), // neighbor that cells to be added to
                             sixtop_vars.cellOptions       // cell options
                     );
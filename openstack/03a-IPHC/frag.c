@@ -80,6 +80,9 @@ void frag_init() {
 
     // unspecified start value, wraps around at 65535     
     frag_vars.global_tag = openrandom_get16b() & 0x7FF;
+
+    // timers are created per datagram, make sure the applications don't take them all
+    opentimers_reserve(COMPONENT_FRAG, NUM_OF_CONCURRENT_TIMERS);
 }
 
 owerror_t frag_fragment6LoPacket(OpenQueueEntry_t *msg) {
@@ -90,8 +93,11 @@ owerror_t frag_fragment6LoPacket(OpenQueueEntry_t *msg) {
     uint8_t fragment_offset;
     int8_t bpos;
 
-    // check if fragmentation is necessary
-    if (!msg->l3_isFragment && msg->length > (MAX_FRAGMENT_SIZE + FRAGN_HEADER_SIZE)) {
+    // check if fragmentation is necessary, a split packet can only be sent in fragments
+    if (
+            !msg->l3_isFragment &&
+            (msg->length > (MAX_FRAGMENT_SIZE + FRAGN_HEADER_SIZE) || openqueue_getNextSegment(msg) != NULL)
+            ) {
 
         LOG_VERBOSE(COMPONENT_FRAG, ERR_FRAG_FRAGMENTING,
                     (errorparameter_t) msg->length,
@@ -118,7 +124,7 @@ owerror_t frag_fragment6LoPacket(OpenQueueEntry_t *msg) {
 
             lowpan_fragment->l3_isFragment = TRUE;
             lowpan_fragment->owner = COMPONENT_FRAG;
-            lowpan_fragment->creator = msg->creator;
+            openqueue_setCreator(lowpan_fragment, msg->creator);
 
             if (remaining_bytes > MAX_FRAGMENT_SIZE)
                 fragment_length = MAX_FRAGMENT_SIZE;
@@ -153,7 +159,7 @@ owerror_t frag_fragment6LoPacket(OpenQueueEntry_t *msg) {
             if (packetfunctions_reserveHeader(&lowpan_fragment, fragment_length) == E_FAIL) {
                 return E_FAIL;
             }
-            memcpy(lowpan_fragment->payload, msg->payload + (fragment_offset * OFFSET_MULTIPLE), fragment_length);
+            packetfunctions_readBytes(msg, fragment_offset * OFFSET_MULTIPLE, lowpan_fragment->payload, fragment_length);
 
             // copy address information
             lowpan_fragment->l3_destinationAdd = msg->l3_destinationAdd;
@@ -333,7 +339,7 @@ void frag_receive(OpenQueueEntry_t *msg) {
                 store_fragment(msg, size, tag, offset);
             } else {
                 // fast forwarding / source routing
-                msg->creator = COMPONENT_FRAG;
+                openqueue_setCreator(msg, COMPONENT_FRAG);
                 allocate_vrb(msg, size, tag);
                 iphc_receive(msg);
             }
@@ -368,7 +374,7 @@ void frag_receive(OpenQueueEntry_t *msg) {
             if (i < NUM_OF_VRBS) {
                 // we have found a corresponding VRB for this subsequent fragment, update the fragment's next hop
                 msg->l3_useSourceRouting = TRUE;
-                msg->creator = COMPONENT_FRAG;
+                openqueue_setCreator(msg, COMPONENT_FRAG);
 
                 memcpy(&msg->l2_nextORpreviousHop, &frag_vars.vrbs[i].nexthop, sizeof(open_addr_t));
 
@@ -456,7 +462,7 @@ static void store_fragment(OpenQueueEntry_t *msg, uint16_t size, uint16_t tag, u
             frag_vars.fragmentBuf[i].pOriginalMsg = NULL;
 
             if (!has_timer) {
-                frag_vars.fragmentBuf[i].reassembly_timer = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_FRAG);
+                frag_vars.fragmentBuf[i].reassembly_timer = opentimers_createReserved(COMPONENT_FRAG, TASKPRIO_FRAG);
 
                 // get a timer for the fragment reassembly and add it to the timer queue
                 if ((frag_vars.fragmentBuf[i].reassembly_timer == ERROR_NO_AVAILABLE_ENTRIES) ||
@@ -584,7 +590,7 @@ static owerror_t allocate_vrb(OpenQueueEntry_t *frag1, uint16_t size, uint16_t t
             frag_vars.vrbs[i].left = (size - MAX_FRAGMENT_SIZE);
             frag_vars.vrbs[i].frag1 = frag1;
 
-            frag_vars.vrbs[i].forward_timer = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_FRAG);
+            frag_vars.vrbs[i].forward_timer = opentimers_createReserved(COMPONENT_FRAG, TASKPRIO_FRAG);
 
             // get a timer for the fragment forwarding and add it to the timer queue
             if ((frag_vars.vrbs[i].forward_timer == ERROR_NO_AVAILABLE_ENTRIES) ||
@@ -622,7 +628,7 @@ static void fast_forward_frags(uint16_t tag, uint16_t size, uint8_t vrb_pos) {
             frag_vars.fragmentBuf[i].datagram_tag == tag &&
             frag_vars.fragmentBuf[i].datagram_offset != 0) {
 
-            frag_vars.fragmentBuf[i].pFragment->creator = COMPONENT_FRAG;
+            openqueue_setCreator(frag_vars.fragmentBuf[i].pFragment, COMPONENT_FRAG);
             frag_vars.fragmentBuf[i].pFragment->l3_useSourceRouting = TRUE;
 
             // provide the stored fragment with the right next hop address
@@ -31,7 +31,6 @@
 #define MAX_FRAGMENT_SIZE           80
 
 #define FRAGMENT_BUFFER_SIZE        (((IPV6_PACKET_SIZE / MAX_FRAGMENT_SIZE) + 1) * BIGQUEUELENGTH)
-#define NUM_OF_VRBS                 2
 #define NUM_OF_CONCURRENT_TIMERS    (NUM_OF_VRBS + BIGQUEUELENGTH)
 
 #define FRAG1_HEADER_SIZE           4
@@ -10,6 +10,8 @@
 #include "neighbors.h"
 #include "openbridge.h"
 #include "icmpv6rpl.h"
+#include "openqueue.h"
+#include "asnfunctions.h"
 
 //=========================== variables =======================================
 
@@ -1098,7 +1100,7 @@ owerror_t iphc_prependIPv6DeadlineHeader(OpenQueueEntry_t **msg) {
         asn_len = iphc_getAsnLen(asn_array);
 
         if (packetfunctions_reserveHeader(msg, asn_len) == E_FAIL) {
-            return E_FAIL
+            return E_FAIL;
         }
         memcpy(&((*msg)->payload[0]), &asn_array, asn_len * sizeof(uint8_t));
         temp_len += asn_len;
@@ -1111,7 +1113,9 @@ owerror_t iphc_prependIPv6DeadlineHeader(OpenQueueEntry_t **msg) {
     }
 
     // Expiration Time (ET)
-    ieee154e_calculateExpTime((*msg)->max_delay, asn_array);
+    ieee154e_calculateExpTime((*msg)->max_delay, &(*msg)->expiration_asn);
+    asnfunctions_toArray(&(*msg)->expiration_asn, asn_array);
+    (*msg)->has_expiration_asn = TRUE;
     asn_len = iphc_getAsnLen(asn_array);
     if (packetfunctions_reserveHeader(msg, asn_len) == E_FAIL) {
         return E_FAIL;
@@ -1229,8 +1233,9 @@ void iphc_retrieveIPv6DeadlineHeader(
         deadline_option_ht *deadline_option
 ) {
     uint8_t temp_8b, type, i, length = 0;
-    asn_t exp_asn, my_asn;
+    asn_t exp_asn, my_asn, org_asn;
     uint8_t my_asn_array[5];
+    int32_t numSlots;
 
     temp_8b = *((uint8_t *) deadline_msg_ptr);
     length++;
@@ -1262,16 +1267,25 @@ void iphc_retrieveIPv6DeadlineHeader(
             deadline_option->et_val[i] = *((uint8_t * )(deadline_msg_ptr) + length);
             length++;
         }
-        ieee154e_orderToASNStructure(deadline_option->et_val, &exp_asn);
+        asnfunctions_fromArray(&exp_asn, deadline_option->et_val);
+
+        // openqueue sends the packets which expire first first, and drops them once expired if allowed
+        memcpy(&msg->expiration_asn, &exp_asn, sizeof(asn_t));
+        msg->has_expiration_asn = TRUE;
+        msg->drop_flag = deadline_option->d_flag;
 
         // Calculate delay experienced by packet
         ieee154e_getAsn(my_asn_array);
-        ieee154e_orderToASNStructure(my_asn_array, &my_asn);
-        deadline_option->time_left = ieee154e_computeAsnDiff(&exp_asn, &my_asn);
-        if (deadline_option->time_left < 0) {
-            deadline_option->time_left = 0;
+        asnfunctions_fromArray(&my_asn, my_asn_array);
+        numSlots = asnfunctions_diff(&exp_asn, &my_asn);
+        if (numSlots < 0) {
+            numSlots = 0;
             LOG_ERROR(COMPONENT_IPHC, ERR_6LORH_DEADLINE_EXPIRED, (errorparameter_t) 0, (errorparameter_t) 0);
+        } else if (numSlots > INT16_MAX) {
+            // far in the future
+            numSlots = INT16_MAX;
         }
+        deadline_option->time_left = (int16_t) numSlots;
         monitor_expiration_vars.time_left = deadline_option->time_left;
 
         // Origination Time
@@ -1280,8 +1294,14 @@ void iphc_retrieveIPv6DeadlineHeader(
                 deadline_option->ot_val[i] = *((uint8_t * )(deadline_msg_ptr) + length);
                 length++;
             }
-            ieee154e_orderToASNStructure(deadline_option->ot_val, &my_asn);
-            monitor_expiration_vars.time_elapsed = ieee154e_asnDiff(&my_asn);
+            asnfunctions_fromArray(&org_asn, deadline_option->ot_val);
+            numSlots = asnfunctions_diff(&my_asn, &org_asn);
+            if (numSlots < 0) {
+                numSlots = 0;
+            } else if (numSlots > UINT16_MAX) {
+                numSlots = UINT16_MAX;
+            }
+            monitor_expiration_vars.time_elapsed = (uint16_t) numSlots;
         }
 
     } else {
@@ -1293,6 +1313,7 @@ void iphc_retrieveIPv6DeadlineHeader(
 void iphc_getDeadlineInfo(monitor_expiration_vars_t *stats) {
     stats->time_left = monitor_expiration_vars.time_left;
     stats->time_elapsed = monitor_expiration_vars.time_elapsed;
+    openqueue_getDeadlineStats(&stats->num_met, &stats->num_missed, &stats->num_failed, &stats->num_dropped);
     memset(&(monitor_expiration_vars), 0, sizeof(monitor_expiration_vars_t));
 }
 
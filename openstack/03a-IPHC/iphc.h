@@ -144,7 +144,7 @@ enum TYPE_6LORH_enums {
     RH3_6LOTH_TYPE_4 = 0x04,
     RPI_6LOTH_TYPE = 0x05,
     IPECAP_6LOTH_TYPE = 0x06,
-#if OPENWSN_DEADLINE_OPTION
+#if DEADLINE_OPTION
     DEADLINE_6LOTH_TYPE = 0x07,
 #endif
 };
@@ -168,7 +168,7 @@ typedef struct {
     uint8_t next_header;
     uint8_t *routing_header[MAXNUM_RH3];
     uint8_t *hopByhop_option;
-#if OPENWSN_DEADLINE_OPTION
+#if DEADLINE_OPTION
     uint8_t* deadline_option;
 #endif
     uint8_t hop_limit;
@@ -220,7 +220,7 @@ typedef struct {
 } rpl_option_ht;
 END_PACK
 
-#if OPENWSN_DEADLINE_OPTION
+#if DEADLINE_OPTION
 BEGIN_PACK
 typedef struct {
    uint8_t optionType;
@@ -241,6 +241,10 @@ END_PACK
 typedef struct {
     int16_t time_left;
     uint16_t time_elapsed;
+    uint16_t num_met;       ///< packets sent before their expiration time
+    uint16_t num_missed;    ///< packets sent after their expiration time
+    uint16_t num_failed;    ///< packets not acknowledged after the last retry
+    uint16_t num_dropped;   ///< packets dropped by openqueue after their expiration time
 } monitor_expiration_vars_t;
 
 //=========================== variables =======================================
@@ -254,7 +258,7 @@ owerror_t iphc_sendFromForwarding(
         ipv6_header_iht *ipv6_outer_header,
         ipv6_header_iht *ipv6_inner_header,
         rpl_option_ht *rpl_option,
-#if OPENWSN_DEADLINE_OPTION
+#if DEADLINE_OPTION
         deadline_option_ht*	deadline_option,
 #endif
         uint32_t *flow_label,
@@ -304,7 +308,7 @@ owerror_t iphc_retrieveIPv6Header(OpenQueueEntry_t *msg,
                                   uint8_t *page_length
 );
 
-#if OPENWSN_DEADLINE_OPTION
+#if DEADLINE_OPTION
 void iphc_retrieveIPv6DeadlineHeader(
    OpenQueueEntry_t* msg,
    uint8_t* deadline_msg_ptr,
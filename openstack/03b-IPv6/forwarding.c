@@ -335,7 +335,7 @@ void forwarding_receive(
         // this packet is not for me: relay
 
         // change the creator of the packet
-        msg->creator = COMPONENT_FORWARDING;
+        openqueue_setCreator(msg, COMPONENT_FORWARDING);
 
 #if DEADLINE_OPTION
         if (deadline_option != NULL) {
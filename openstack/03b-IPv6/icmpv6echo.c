@@ -100,6 +100,9 @@ void icmpv6echo_sendDone(OpenQueueEntry_t *msg, owerror_t error) {
 
 void icmpv6echo_receive(OpenQueueEntry_t *msg) {
     OpenQueueEntry_t *reply;
+    open_addr_t requestDestination;
+    open_addr_t replySource;
+    uint8_t requestType;
     msg->owner = COMPONENT_ICMPv6ECHO;
     switch (msg->l4_sourcePortORicmpv6Type) {
         case IANA_ICMPv6_ECHO_REQUEST:
@@ -128,6 +131,7 @@ void icmpv6echo_receive(OpenQueueEntry_t *msg) {
 
             // copy source of msg in destination of reply
             memcpy(&(reply->l3_destinationAdd), &(msg->l3_sourceAdd), sizeof(open_addr_t));
+            memcpy(&requestDestination, &(msg->l3_destinationAdd), sizeof(open_addr_t));
 
             // free up msg
             openqueue_freePacketBuffer(msg);
@@ -136,8 +140,27 @@ void icmpv6echo_receive(OpenQueueEntry_t *msg) {
             // administrative information for reply
             reply->l4_protocol = IANA_ICMPv6;
             reply->l4_sourcePortORicmpv6Type = IANA_ICMPv6_ECHO_REPLY;
+            requestType = ((ICMPv6_ht *) (reply->payload))->type;
             ((ICMPv6_ht *) (reply->payload))->type = reply->l4_sourcePortORicmpv6Type;
-            packetfunctions_calculateChecksum(reply, (uint8_t * ) & (((ICMPv6_ht *) (reply->payload))->checksum));
+            if (requestDestination.type == ADDR_128B && reply->l3_destinationAdd.type == ADDR_128B) {
+                // the reply carries the request with the addresses swapped, only the type and the source address
+                // of the pseudo header change, so adjust the checksum of the request instead of summing the payload
+                packetfunctions_getChecksumSource(&(reply->l3_destinationAdd), &replySource);
+                packetfunctions_updateChecksum(
+                        (uint8_t * ) & (((ICMPv6_ht *) (reply->payload))->checksum),
+                        requestDestination.addr_128b,
+                        replySource.addr_128b,
+                        LENGTH_ADDR128b
+                );
+                packetfunctions_updateChecksum(
+                        (uint8_t * ) & (((ICMPv6_ht *) (reply->payload))->checksum),
+                        &requestType,
+                        &(((ICMPv6_ht *) (reply->payload))->type),
+                        1
+                );
+            } else {
+                packetfunctions_calculateChecksum(reply, (uint8_t * ) & (((ICMPv6_ht *) (reply->payload))->checksum));
+            }
 
             icmpv6echo_vars.busySending = TRUE;
 
@@ -131,11 +131,12 @@ void icmpv6rpl_init(void) {
     icmpv6rpl_vars.conf.defLifetime = 0xff; //infinite - limit for DAO period  -> 0xff
     icmpv6rpl_vars.conf.lifetimeUnit = 0xffff; // 0xffff
 
-    opentimers_scheduleIn(
+    opentimers_scheduleInWithSlack(
             icmpv6rpl_vars.timerIdDIO,
             SLOTFRAME_LENGTH * SLOTDURATION,
             TIME_MS,
             TIMER_PERIODIC,
+            SLOTDURATION,   // may be one slot late, to share a wakeup
             icmpv6rpl_timer_DIO_cb
     );
 
@@ -176,11 +177,12 @@ void icmpv6rpl_init(void) {
 
     icmpv6rpl_vars.daoPeriod = DAO_PERIOD;
     icmpv6rpl_vars.timerIdDAO = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_RPL);
-    opentimers_scheduleIn(
+    opentimers_scheduleInWithSlack(
             icmpv6rpl_vars.timerIdDAO,
             SLOTFRAME_LENGTH * SLOTDURATION,
             TIME_MS,
             TIMER_PERIODIC,
+            SLOTDURATION,   // may be one slot late, to share a wakeup
             icmpv6rpl_timer_DAO_cb
     );
 }
@@ -0,0 +1,137 @@
+#include "opendefs.h"
+#include "asnfunctions.h"
+#include "IEEE802154E.h"
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+//======= conversion
+
+/**
+\brief Read an ASN from the byte array format of ieee154e_getAsn, LSB first.
+*/
+void asnfunctions_fromArray(asn_t *asn, uint8_t *array) {
+    asn->bytes0and1 = ((uint16_t) array[1] << 8) | array[0];
+    asn->bytes2and3 = ((uint16_t) array[3] << 8) | array[2];
+    asn->byte4 = array[4];
+}
+
+void asnfunctions_toArray(asn_t *asn, uint8_t *array) {
+    array[0] = (uint8_t)(asn->bytes0and1 & 0xFF);
+    array[1] = (uint8_t)(asn->bytes0and1 >> 8);
+    array[2] = (uint8_t)(asn->bytes2and3 & 0xFF);
+    array[3] = (uint8_t)(asn->bytes2and3 >> 8);
+    array[4] = asn->byte4;
+}
+
+uint64_t asnfunctions_toUint64(asn_t *asn) {
+    return ((uint64_t) asn->byte4 << 32) |
+           ((uint64_t) asn->bytes2and3 << 16) |
+           (uint64_t) asn->bytes0and1;
+}
+
+/**
+\brief Write an ASN from an integer, the bits above the 40th are ignored.
+*/
+void asnfunctions_fromUint64(asn_t *asn, uint64_t value) {
+    asn->bytes0and1 = (uint16_t)(value & 0xFFFF);
+    asn->bytes2and3 = (uint16_t)((value >> 16) & 0xFFFF);
+    asn->byte4 = (uint8_t)((value >> 32) & 0xFF);
+}
+
+//======= arithmetic
+
+void asnfunctions_add(asn_t *asn, uint32_t numSlots) {
+    uint32_t low;
+    uint32_t sum;
+
+    low = ((uint32_t) asn->bytes2and3 << 16) | asn->bytes0and1;
+    sum = low + numSlots;
+    if (sum < low) {
+        asn->byte4++;
+    }
+    asn->bytes2and3 = (uint16_t)(sum >> 16);
+    asn->bytes0and1 = (uint16_t)(sum & 0xFFFF);
+}
+
+/**
+\brief Number of slots from reference to asn.
+
+\returns asn - reference, negative if asn is before reference, saturated to
+   ASNFUNCTIONS_DIFF_MIN and ASNFUNCTIONS_DIFF_MAX.
+*/
+int32_t asnfunctions_diff(asn_t *asn, asn_t *reference) {
+    uint32_t low_asn;
+    uint32_t low_reference;
+    uint32_t low;
+    int16_t high;
+
+    low_asn = ((uint32_t) asn->bytes2and3 << 16) | asn->bytes0and1;
+    low_reference = ((uint32_t) reference->bytes2and3 << 16) | reference->bytes0and1;
+    low = low_asn - low_reference;
+    high = (int16_t) asn->byte4 - (int16_t) reference->byte4 - (low_asn < low_reference ? 1 : 0);
+
+    // the 40-bit difference is high * 2^32 + low
+    if (high == 0) {
+        return low > (uint32_t) ASNFUNCTIONS_DIFF_MAX ? ASNFUNCTIONS_DIFF_MAX : (int32_t) low;
+    }
+    if (high == -1) {
+        return low < (uint32_t) ASNFUNCTIONS_DIFF_MIN ? ASNFUNCTIONS_DIFF_MIN : (int32_t) low;
+    }
+    return high > 0 ? ASNFUNCTIONS_DIFF_MAX : ASNFUNCTIONS_DIFF_MIN;
+}
+
+/**
+\returns -1 if asn is before reference, 0 if they are equal, 1 if it is after.
+*/
+int8_t asnfunctions_compare(asn_t *asn, asn_t *reference) {
+    if (asn->byte4 != reference->byte4) {
+        return asn->byte4 > reference->byte4 ? 1 : -1;
+    }
+    if (asn->bytes2and3 != reference->bytes2and3) {
+        return asn->bytes2and3 > reference->bytes2and3 ? 1 : -1;
+    }
+    if (asn->bytes0and1 != reference->bytes0and1) {
+        return asn->bytes0and1 > reference->bytes0and1 ? 1 : -1;
+    }
+    return 0;
+}
+
+//======= time
+
+/**
+\brief Duration of a number of slots, in ms.
+
+Uses the slot duration the MAC currently runs with. The result saturates at
+0xFFFFFFFF ms, about 49 days.
+*/
+uint32_t asnfunctions_slotsToMs(uint32_t numSlots) {
+    uint64_t ms;
+
+    ms = (uint64_t) numSlots * ieee154e_getSlotDuration() / PORT_TICS_PER_MS;
+    if (ms > 0xFFFFFFFF) {
+        return 0xFFFFFFFF;
+    }
+    return (uint32_t) ms;
+}
+
+/**
+\brief Number of whole slots in a duration.
+
+Uses the slot duration the MAC currently runs with.
+*/
+uint32_t asnfunctions_msToSlots(uint32_t ms) {
+    uint16_t slotDuration;
+
+    slotDuration = ieee154e_getSlotDuration();
+    if (slotDuration == 0) {
+        // the MAC is not initialized yet
+        return 0;
+    }
+    return (uint32_t) ((uint64_t) ms * PORT_TICS_PER_MS / slotDuration);
+}
+
+//=========================== private =========================================
@@ -0,0 +1,56 @@
+#ifndef OPENWSN_ASNFUNCTIONS_H
+#define OPENWSN_ASNFUNCTIONS_H
+
+/**
+\addtogroup cross-layers
+\{
+\addtogroup ASNFunctions
+\{
+
+\brief Arithmetic on the 40-bit Absolute Slot Number.
+
+The ASN is handled as its lower 32 bits plus byte4, so that adding and
+subtracting only needs 32-bit operations. Differences are saturated to the
+int32_t range, about 500 days with 10 ms slots, instead of wrapping around.
+*/
+
+#include "opendefs.h"
+
+//=========================== define ==========================================
+
+#define ASNFUNCTIONS_DIFF_MAX        ((int32_t) 0x7FFFFFFF)
+#define ASNFUNCTIONS_DIFF_MIN        ((int32_t) 0x80000000)
+
+//=========================== typedef =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+// conversion
+void asnfunctions_fromArray(asn_t *asn, uint8_t *array);
+
+void asnfunctions_toArray(asn_t *asn, uint8_t *array);
+
+uint64_t asnfunctions_toUint64(asn_t *asn);
+
+void asnfunctions_fromUint64(asn_t *asn, uint64_t value);
+
+// arithmetic
+void asnfunctions_add(asn_t *asn, uint32_t numSlots);
+
+int32_t asnfunctions_diff(asn_t *asn, asn_t *reference);
+
+int8_t asnfunctions_compare(asn_t *asn, asn_t *reference);
+
+// time
+uint32_t asnfunctions_slotsToMs(uint32_t numSlots);
+
+uint32_t asnfunctions_msToSlots(uint32_t ms);
+
+/**
+\}
+\}
+*/
+
+#endif /* OPENWSN_ASNFUNCTIONS_H */
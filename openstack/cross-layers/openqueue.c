@@ -4,9 +4,11 @@
 #include "openserial.h"
 #include "packetfunctions.h"
 #include "IEEE802154E.h"
+#include "asnfunctions.h"
 #include "radio.h"
 #include "IEEE802154_security.h"
 #include "sixtop.h"
+#include "scheduler.h"
 
 //=========================== defination =====================================
 
@@ -18,6 +20,38 @@ openqueue_vars_t openqueue_vars;
 
 //=========================== prototypes ======================================
 
+void openqueue_release(uint8_t i);
+
+uint8_t openqueue_getIndex(OpenQueueEntry_t *pkt);
+
+OpenQueueEntry_t* openqueue_getEntry(uint8_t i);
+
+uint8_t openqueue_getTxNeighborList(open_addr_t *neighbor);
+
+uint8_t openqueue_allocateTxList(OpenQueueEntry_t *pkt);
+
+void openqueue_txLink(uint8_t i, uint8_t list);
+
+void openqueue_txUnlink(uint8_t i);
+
+OpenQueueEntry_t* openqueue_getFirstTxPacket(uint8_t list);
+
+#if OPENQUEUE_AQM
+void openqueue_aqmDrop(uint8_t i);
+#endif
+
+#if DEADLINE_OPTION
+uint8_t openqueue_edfGetPacket(uint8_t list, open_addr_t *toNeighbor);
+
+bool openqueue_isExpired(OpenQueueEntry_t *pkt);
+#endif
+
+#if OPENQUEUE_AQM || DEADLINE_OPTION
+void openqueue_dropTxPacket(uint8_t i);
+
+void openqueue_getAsn(asn_t *asn);
+#endif
+
 void openqueue_reset_entry(OpenQueueEntry_t *entry);
 
 #if OPENWSN_6LO_FRAGMENTATION_C
@@ -35,13 +69,46 @@ void openqueue_init() {
     uint8_t i;
     for (i = 0; i < QUEUELENGTH; i++) {
         openqueue_reset_entry(&(openqueue_vars.queue[i]));
+        openqueue_vars.isLowPriority[i] = FALSE;
+        openqueue_vars.nextFree[i] = (i + 1 < QUEUELENGTH) ? (i + 1) : OPENQUEUE_NO_ENTRY;
     }
+    openqueue_vars.freeList = 0;
+    openqueue_vars.numFree = QUEUELENGTH;
+    openqueue_vars.numLowPriority = 0;
 
 #if OPENWSN_6LO_FRAGMENTATION_C
     for (i = 0; i < BIGQUEUELENGTH; i++) {
         openqueue_reset_big_entry(&(openqueue_vars.big_queue[i]));
     }
 #endif
+
+    for (i = 0; i < OPENQUEUE_NUM_ENTRIES; i++) {
+        openqueue_vars.txList[i] = OPENQUEUE_NO_ENTRY;
+    }
+    for (i = 0; i < OPENQUEUE_NUM_TXLISTS; i++) {
+        openqueue_vars.txLists[i].head = OPENQUEUE_NO_ENTRY;
+        openqueue_vars.txLists[i].tail = OPENQUEUE_NO_ENTRY;
+        openqueue_vars.txLists[i].numPackets = 0;
+    }
+    for (i = 0; i < OPENQUEUE_TX_NEIGHBORS; i++) {
+        openqueue_vars.txNeighbors[i].type = ADDR_NONE;
+    }
+    for (i = 0; i < OPENQUEUE_NUM_SIXTOP_CELLLISTS; i++) {
+        openqueue_vars.sixtopCellListsUsed[i] = FALSE;
+    }
+#if OPENQUEUE_AQM
+    memset(&openqueue_vars.aqm[0], 0, sizeof(openqueue_vars.aqm));
+    for (i = 0; i < OPENQUEUE_AQM_NUM_CREATORS; i++) {
+        openqueue_vars.aqmDrops[i].creator = COMPONENT_NULL;
+        openqueue_vars.aqmDrops[i].numDrops = 0;
+    }
+#endif
+#if DEADLINE_OPTION
+    openqueue_vars.numDeadlineMet = 0;
+    openqueue_vars.numDeadlineMissed = 0;
+    openqueue_vars.numDeadlineFailed = 0;
+    openqueue_vars.numDeadlineDropped = 0;
+#endif
 }
 
 /**
@@ -96,17 +163,24 @@ OpenQueueEntry_t* openqueue_getFreePacketBuffer(uint8_t creator) {
         return NULL;
     }
 
-    // walk through queue and find free entry
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (openqueue_vars.queue[i].owner == COMPONENT_NULL) {
-            openqueue_vars.queue[i].creator = creator;
-            openqueue_vars.queue[i].owner = COMPONENT_OPENQUEUE;
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
-        }
+    // take the first entry of the free list
+    i = openqueue_vars.freeList;
+    if (i == OPENQUEUE_NO_ENTRY) {
+        ENABLE_INTERRUPTS();
+        return NULL;
+    }
+    openqueue_vars.freeList = openqueue_vars.nextFree[i];
+    openqueue_vars.numFree--;
+
+    openqueue_vars.queue[i].creator = creator;
+    openqueue_vars.queue[i].owner = COMPONENT_OPENQUEUE;
+    if (creator > COMPONENT_SIXTOP_RES) {
+        openqueue_vars.isLowPriority[i] = TRUE;
+        openqueue_vars.numLowPriority++;
     }
+
     ENABLE_INTERRUPTS();
-    return NULL;
+    return &openqueue_vars.queue[i];
 }
 
 /**
@@ -132,6 +206,7 @@ owerror_t openqueue_freePacketBuffer(OpenQueueEntry_t *pkt) {
                     LOG_CRITICAL(COMPONENT_OPENQUEUE, ERR_FREEING_UNUSED,(errorparameter_t) 0,(errorparameter_t) 0);
                 }
 
+                openqueue_txUnlink(QUEUELENGTH + i);
                 openqueue_reset_big_entry((OpenQueueBigEntry_t *) pkt);
                 ENABLE_INTERRUPTS();
                 return E_SUCCESS;
@@ -139,16 +214,18 @@ owerror_t openqueue_freePacketBuffer(OpenQueueEntry_t *pkt) {
         }
     } else {
 #endif
-        for (i = 0; i < QUEUELENGTH; i++) {
-            if (&openqueue_vars.queue[i] == pkt) {
-                if (openqueue_vars.queue[i].owner == COMPONENT_NULL) {
-                    // log the error
-                    LOG_CRITICAL(COMPONENT_OPENQUEUE, ERR_FREEING_UNUSED, (errorparameter_t) 0, (errorparameter_t) 0);
-                }
-                openqueue_reset_entry(&(openqueue_vars.queue[i]));
-                ENABLE_INTERRUPTS();
-                return E_SUCCESS;
+        if (pkt >= &openqueue_vars.queue[0] && pkt < &openqueue_vars.queue[QUEUELENGTH]) {
+            i = (uint8_t) (pkt - &openqueue_vars.queue[0]);
+            if (openqueue_vars.queue[i].owner == COMPONENT_NULL) {
+                // log the error
+                LOG_CRITICAL(COMPONENT_OPENQUEUE, ERR_FREEING_UNUSED, (errorparameter_t) 0, (errorparameter_t) 0);
+                // already in the free list, don't insert it twice
+                openqueue_reset_entry(pkt);
+            } else {
+                openqueue_release(i);
             }
+            ENABLE_INTERRUPTS();
+            return E_SUCCESS;
         }
 #if OPENWSN_6LO_FRAGMENTATION_C
     }
@@ -202,16 +279,22 @@ void openqueue_removeAllCreatedBy(uint8_t creator) {
     DISABLE_INTERRUPTS();
     for (i = 0; i < QUEUELENGTH; i++) {
         if (
+                openqueue_vars.queue[i].owner != COMPONENT_NULL &&
                 openqueue_vars.queue[i].creator == creator &&
                 openqueue_vars.queue[i].owner != COMPONENT_IEEE802154E
+#if OPENWSN_6LO_FRAGMENTATION_C
+                // segments are released with the first segment of their packet
+                && openqueue_vars.queue[i].owner != COMPONENT_PACKETFUNCTIONS
+#endif
                 ) {
-            openqueue_reset_entry(&(openqueue_vars.queue[i]));
+            openqueue_release(i);
         }
     }
 
 #if OPENWSN_6LO_FRAGMENTATION_C
     for (i = 0; i < BIGQUEUELENGTH; i++) {
         if (openqueue_vars.big_queue[i].standard_entry.creator == creator) {
+            openqueue_txUnlink(QUEUELENGTH + i);
             openqueue_reset_big_entry(&(openqueue_vars.big_queue[i]));
         }
     }
@@ -220,8 +303,110 @@ void openqueue_removeAllCreatedBy(uint8_t creator) {
     ENABLE_INTERRUPTS();
 }
 
+/**
+\brief Change the creator of an allocated packet buffer.
+
+Components taking over a packet created by another component, e.g. when
+relaying a received packet, must use this function rather than writing the
+creator field, so the high priority reserve accounting stays correct.
+
+\param pkt     A pointer to the allocated packet buffer.
+\param creator The identifier of the new creator, taken in COMPONENT_*.
+*/
+void openqueue_setCreator(OpenQueueEntry_t *pkt, uint8_t creator) {
+    uint8_t i;
+    bool isLowPriority;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    pkt->creator = creator;
+
+    if (pkt >= &openqueue_vars.queue[0] && pkt < &openqueue_vars.queue[QUEUELENGTH]) {
+        i = (uint8_t) (pkt - &openqueue_vars.queue[0]);
+        isLowPriority = (creator > COMPONENT_SIXTOP_RES);
+        if (isLowPriority != openqueue_vars.isLowPriority[i]) {
+            if (isLowPriority) {
+                openqueue_vars.numLowPriority++;
+            } else {
+                openqueue_vars.numLowPriority--;
+            }
+            openqueue_vars.isLowPriority[i] = isLowPriority;
+        }
+    }
+
+    ENABLE_INTERRUPTS();
+}
+
 //======= called by RES
 
+/**
+\brief Hand a packet over to IEEE802154E.
+
+The packet is assigned to the virtual component COMPONENT_SIXTOP_TO_IEEE802154E
+and appended to the transmit list IEEE802154E looks into for the kind of cell
+the packet is sent on.
+
+\param pkt A pointer to the packet, with its IEEE802.15.4 header.
+*/
+void openqueue_sixtopEnqueuePacket(OpenQueueEntry_t *pkt) {
+    uint8_t i;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    pkt->owner = COMPONENT_SIXTOP_TO_IEEE802154E;
+
+    i = openqueue_getIndex(pkt);
+    if (i != OPENQUEUE_NO_ENTRY) {
+        openqueue_txUnlink(i);
+        openqueue_txLink(i, openqueue_allocateTxList(pkt));
+#if OPENQUEUE_AQM
+        openqueue_getAsn(&openqueue_vars.enqueueAsn[i]);
+#endif
+    }
+
+    ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Get cell lists for a 6P response.
+
+The cell lists are released together with the packet.
+
+\param pkt A pointer to the 6P response.
+
+\returns A pointer to the cleared cell lists, or NULL if none is free.
+*/
+openqueue_sixtopCellLists_t* openqueue_sixtopAllocateCellLists(OpenQueueEntry_t *pkt) {
+    uint8_t i;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    for (i = 0; i < OPENQUEUE_NUM_SIXTOP_CELLLISTS; i++) {
+        if (openqueue_vars.sixtopCellListsUsed[i] == FALSE) {
+            openqueue_vars.sixtopCellListsUsed[i] = TRUE;
+            pkt->l2_sixtop_cellListsHandle = i;
+            memset(&openqueue_vars.sixtopCellLists[i], 0, sizeof(openqueue_sixtopCellLists_t));
+            ENABLE_INTERRUPTS();
+            return &openqueue_vars.sixtopCellLists[i];
+        }
+    }
+
+    ENABLE_INTERRUPTS();
+    return NULL;
+}
+
+/**
+\brief Get the cell lists previously allocated for a 6P response.
+
+\returns A pointer to the cell lists, or NULL if the packet has none.
+*/
+openqueue_sixtopCellLists_t* openqueue_sixtopGetCellLists(OpenQueueEntry_t *pkt) {
+    if (pkt->l2_sixtop_cellListsHandle >= OPENQUEUE_NUM_SIXTOP_CELLLISTS) {
+        return NULL;
+    }
+    return &openqueue_vars.sixtopCellLists[pkt->l2_sixtop_cellListsHandle];
+}
+
 OpenQueueEntry_t* openqueue_sixtopGetSentPacket() {
     uint8_t i;
     INTERRUPT_DECLARATION();
@@ -266,21 +451,25 @@ OpenQueueEntry_t* openqueue_sixtopGetReceivedPacket() {
 uint8_t openqueue_getNum6PReq(open_addr_t *neighbor) {
 
     uint8_t i;
+    uint8_t list;
     uint8_t num6Prequest;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
     num6Prequest = 0;
-    for (i = 0; i < QUEUELENGTH; i++) {
+    list = openqueue_getTxNeighborList(neighbor);
+    i = openqueue_vars.txLists[list].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
         if (
-                openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-                openqueue_vars.queue[i].creator == COMPONENT_SIXTOP_RES &&
-                openqueue_vars.queue[i].l2_sixtop_messageType == SIXTOP_CELL_REQUEST &&
-                packetfunctions_sameAddress(neighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
+                openqueue_getEntry(i)->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                openqueue_getEntry(i)->creator == COMPONENT_SIXTOP_RES &&
+                openqueue_getEntry(i)->l2_sixtop_messageType == SIXTOP_CELL_REQUEST &&
+                packetfunctions_sameAddress(neighbor, &openqueue_getEntry(i)->l2_nextORpreviousHop)
                 ) {
             num6Prequest += 1;
         }
+        i = openqueue_vars.txNext[i];
     }
     ENABLE_INTERRUPTS();
     return num6Prequest;
@@ -295,14 +484,12 @@ uint8_t openqueue_getNum6PResp() {
     DISABLE_INTERRUPTS();
 
     num6Presponse = 0;
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (
-                openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-                openqueue_vars.queue[i].creator == COMPONENT_SIXTOP_RES &&
-                openqueue_vars.queue[i].l2_sixtop_messageType == SIXTOP_CELL_RESPONSE
-                ) {
+    i = openqueue_vars.txLists[OPENQUEUE_TXLIST_6PRESPONSE].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
+        if (openqueue_getEntry(i)->owner == COMPONENT_SIXTOP_TO_IEEE802154E) {
             num6Presponse += 1;
         }
+        i = openqueue_vars.txNext[i];
     }
     ENABLE_INTERRUPTS();
     return num6Presponse;
@@ -311,95 +498,99 @@ uint8_t openqueue_getNum6PResp() {
 void openqueue_remove6PrequestToNeighbor(open_addr_t *neighbor) {
 
     uint8_t i;
+    uint8_t next;
 
     INTERRUPT_DECLARATION();
     DISABLE_INTERRUPTS();
 
-    for (i = 0; i < QUEUELENGTH; i++) {
+    i = openqueue_vars.txLists[openqueue_getTxNeighborList(neighbor)].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
+        next = openqueue_vars.txNext[i];
         if (
+                i < QUEUELENGTH &&
                 openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
                 openqueue_vars.queue[i].creator == COMPONENT_SIXTOP_RES &&
                 openqueue_vars.queue[i].l2_sixtop_messageType == SIXTOP_CELL_REQUEST &&
                 packetfunctions_sameAddress(neighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
                 ) {
-            openqueue_reset_entry(&(openqueue_vars.queue[i]));
+            openqueue_release(i);
         }
+        i = next;
     }
     ENABLE_INTERRUPTS();
 }
 
 //======= called by IEEE80215E
 
-bool openqueue_isHighPriorityEntryEnough() {
-    uint8_t i;
-    uint8_t numberOfEntry;
-    INTERRUPT_DECLARATION();
-    DISABLE_INTERRUPTS();
+#if OPENWSN_6LO_FRAGMENTATION_C
+/**
+\brief Get the entry holding the rest of a split packet.
 
-    numberOfEntry = 0;
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (openqueue_vars.queue[i].creator > COMPONENT_SIXTOP_RES) {
-            numberOfEntry++;
-        }
+When a header does not fit in front of a packet, packetfunctions_reserveHeader()
+puts it in a new entry which becomes the first segment of the packet, instead of
+copying the packet to a big entry. The segments are owned by
+COMPONENT_PACKETFUNCTIONS and freed with the first segment.
+
+\param pkt A pointer to a segment of the packet.
+
+\returns The following segment, or NULL if pkt is the last one.
+*/
+OpenQueueEntry_t* openqueue_getNextSegment(OpenQueueEntry_t *pkt) {
+    if (pkt->l3_nextSegment == OPENQUEUE_NO_ENTRY) {
+        return NULL;
     }
+    return &openqueue_vars.queue[pkt->l3_nextSegment];
+}
 
-    if (numberOfEntry > QUEUELENGTH - HIGH_PRIORITY_QUEUE_ENTRY) {
-        ENABLE_INTERRUPTS();
-        return FALSE;
+/**
+\brief Chain an entry after a segment of a split packet.
+
+\param pkt     A pointer to a segment of the packet.
+\param segment The entry holding the following bytes, or NULL.
+*/
+void openqueue_setNextSegment(OpenQueueEntry_t *pkt, OpenQueueEntry_t *segment) {
+    if (segment == NULL) {
+        pkt->l3_nextSegment = OPENQUEUE_NO_ENTRY;
     } else {
-        ENABLE_INTERRUPTS();
-        return TRUE;
+        pkt->l3_nextSegment = openqueue_getIndex(segment);
     }
 }
+#endif
+
+bool openqueue_isHighPriorityEntryEnough() {
+    return (openqueue_vars.numLowPriority > QUEUELENGTH - HIGH_PRIORITY_QUEUE_ENTRY) ? FALSE : TRUE;
+}
 
 OpenQueueEntry_t* openqueue_macGetEBPacket() {
-   uint8_t i;
-   INTERRUPT_DECLARATION();
-   DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-          openqueue_vars.queue[i].creator==COMPONENT_SIXTOP              &&
-          packetfunctions_isBroadcastMulticast(&(openqueue_vars.queue[i].l2_nextORpreviousHop))) {
-         ENABLE_INTERRUPTS();
-         return &openqueue_vars.queue[i];
-      }
-   }
-   ENABLE_INTERRUPTS();
-   return NULL;
+    return openqueue_getFirstTxPacket(OPENQUEUE_TXLIST_EB);
 }
 
 OpenQueueEntry_t* openqueue_macGetKaPacket(open_addr_t* toNeighbor) {
     uint8_t i;
     INTERRUPT_DECLARATION();
+
+    if (toNeighbor->type != ADDR_64B) {
+        return NULL;
+    }
+
     DISABLE_INTERRUPTS();
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-            openqueue_vars.queue[i].creator == COMPONENT_SIXTOP &&
-            toNeighbor->type == ADDR_64B &&
-            packetfunctions_sameAddress(toNeighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
+    i = openqueue_vars.txLists[openqueue_getTxNeighborList(toNeighbor)].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
+        if (openqueue_getEntry(i)->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+            openqueue_getEntry(i)->creator == COMPONENT_SIXTOP &&
+            packetfunctions_sameAddress(toNeighbor, &openqueue_getEntry(i)->l2_nextORpreviousHop)
                 ) {
             ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+            return openqueue_getEntry(i);
         }
+        i = openqueue_vars.txNext[i];
     }
     ENABLE_INTERRUPTS();
     return NULL;
 }
 
 OpenQueueEntry_t*  openqueue_macGetDIOPacket(){
-    uint8_t i;
-    INTERRUPT_DECLARATION();
-    DISABLE_INTERRUPTS();
-    for (i = 0; i < QUEUELENGTH; i++) {
-        if (openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-            openqueue_vars.queue[i].creator == COMPONENT_ICMPv6RPL &&
-            packetfunctions_isBroadcastMulticast(&(openqueue_vars.queue[i].l2_nextORpreviousHop))) {
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
-        }
-    }
-    ENABLE_INTERRUPTS();
-    return NULL;
+    return openqueue_getFirstTxPacket(OPENQUEUE_TXLIST_DIO);
 }
 
 /**
@@ -428,6 +619,9 @@ void openqueue_updateNextHopPayload(open_addr_t *newNextHop) {
                 for (j = 0; j < 8; j++) {
                     *((uint8_t *) openqueue_vars.queue[i].l2_nextHop_payload + j) = newNextHop->addr_64b[j];
                 }
+                // move the packet to the list of its new next hop
+                openqueue_txUnlink(i);
+                openqueue_txLink(i, openqueue_allocateTxList(&openqueue_vars.queue[i]));
             }
         }
     }
@@ -453,60 +647,604 @@ OpenQueueEntry_t*  openqueue_getPacketByComponent(uint8_t component) {
 
 OpenQueueEntry_t*  openqueue_macGetUnicastPacket(open_addr_t* toNeighbor){
     uint8_t i;
+    uint8_t list;
     INTERRUPT_DECLARATION();
+
+    if (toNeighbor->type != ADDR_64B) {
+        return NULL;
+    }
+
     DISABLE_INTERRUPTS();
 
     // first to look the sixtop RES packet
-    for (i = 0; i < QUEUELENGTH; i++) {
+    i = openqueue_vars.txLists[OPENQUEUE_TXLIST_6PRESPONSE].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
         if (
-                openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
-                openqueue_vars.queue[i].creator == COMPONENT_SIXTOP_RES &&
-                (
-                        toNeighbor->type == ADDR_64B &&
-                        packetfunctions_sameAddress(toNeighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
-                ) &&
-                openqueue_vars.queue[i].l2_sixtop_messageType == SIXTOP_CELL_RESPONSE
+                openqueue_getEntry(i)->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                packetfunctions_sameAddress(toNeighbor, &openqueue_getEntry(i)->l2_nextORpreviousHop)
                 ) {
             ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+            return openqueue_getEntry(i);
         }
+        i = openqueue_vars.txNext[i];
     }
 
     // if reach here, then looking for other unicast packets
-    for (i = 0; i < QUEUELENGTH; i++) {
+    list = openqueue_getTxNeighborList(toNeighbor);
+#if DEADLINE_OPTION
+    i = openqueue_edfGetPacket(list, toNeighbor);
+    ENABLE_INTERRUPTS();
+    return (i == OPENQUEUE_NO_ENTRY) ? NULL : openqueue_getEntry(i);
+#else
+    i = openqueue_vars.txLists[list].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
         if (
-                openqueue_vars.queue[i].owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                openqueue_getEntry(i)->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
                 (
-                        toNeighbor->type == ADDR_64B &&
-                        packetfunctions_sameAddress(toNeighbor, &openqueue_vars.queue[i].l2_nextORpreviousHop)
+                        list != OPENQUEUE_TXLIST_UNICAST ||
+                        packetfunctions_sameAddress(toNeighbor, &openqueue_getEntry(i)->l2_nextORpreviousHop)
                 )
                 ) {
             ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+            return openqueue_getEntry(i);
         }
+        i = openqueue_vars.txNext[i];
     }
 
-#if OPENWSN_6LO_FRAGMENTATION_C
-    for (i = 0; i < BIGQUEUELENGTH; i++) {
+    ENABLE_INTERRUPTS();
+    return NULL;
+#endif
+}
+
+/**
+\brief Remove a packet from the transmit lists once IEEE802154E is done with it.
+
+\param pkt A pointer to the packet which was sent, or dropped after its last
+    retry.
+*/
+void openqueue_macTxDone(OpenQueueEntry_t *pkt) {
+    uint8_t i;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    i = openqueue_getIndex(pkt);
+    if (i != OPENQUEUE_NO_ENTRY) {
+        openqueue_txUnlink(i);
+    }
+
+#if DEADLINE_OPTION
+    if (pkt->has_expiration_asn) {
+        if (pkt->l2_sendDoneError != E_SUCCESS) {
+            openqueue_vars.numDeadlineFailed++;
+        } else if (openqueue_isExpired(pkt)) {
+            openqueue_vars.numDeadlineMissed++;
+        } else {
+            openqueue_vars.numDeadlineMet++;
+        }
+    }
+#endif
+
+    ENABLE_INTERRUPTS();
+}
+
+#if DEADLINE_OPTION
+/**
+\brief Outcome of the packets with an expiration time handed to IEEE802154E.
+
+\param[out] numMet     Packets transmitted before their expiration time.
+\param[out] numMissed  Packets transmitted after their expiration time.
+\param[out] numFailed  Packets whose transmission failed after the last retry.
+\param[out] numDropped Packets dropped because they expired in the queue.
+*/
+void openqueue_getDeadlineStats(
+        uint16_t *numMet,
+        uint16_t *numMissed,
+        uint16_t *numFailed,
+        uint16_t *numDropped
+) {
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    *numMet = openqueue_vars.numDeadlineMet;
+    *numMissed = openqueue_vars.numDeadlineMissed;
+    *numFailed = openqueue_vars.numDeadlineFailed;
+    *numDropped = openqueue_vars.numDeadlineDropped;
+
+    ENABLE_INTERRUPTS();
+}
+#endif
+
+#if OPENQUEUE_AQM
+/**
+\brief Drop the first data packet to a neighbor if packets wait too long.
+
+IEEE802154E calls this function before picking a unicast packet. As in CoDel,
+the sojourn time of the first data packet to the neighbor is compared to
+OPENQUEUE_AQM_TARGET. Once it stayed above target for OPENQUEUE_AQM_INTERVAL
+slots, that packet is dropped, then the next ones at intervals shrinking with
+the square root of the number of drops, until the sojourn time goes back below
+target.
+
+Dropped packets are returned to their creator as failed transmissions. At most
+one packet is dropped per call. 6P, EB and keep-alive packets are never dropped.
+
+\param toNeighbor The 64-bit address of the neighbor.
+*/
+void openqueue_macAqmCheck(open_addr_t *toNeighbor) {
+    uint8_t i;
+    uint8_t list;
+    uint32_t sojourn;
+    uint32_t sinceLastDrop;
+    openqueue_aqm_t *aqm;
+    INTERRUPT_DECLARATION();
+
+    if (toNeighbor->type != ADDR_64B) {
+        return;
+    }
+
+    DISABLE_INTERRUPTS();
+
+    list = openqueue_getTxNeighborList(toNeighbor);
+    aqm = &openqueue_vars.aqm[list];
+
+    // find the first data packet to this neighbor
+    i = openqueue_vars.txLists[list].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
         if (
-                ((OpenQueueEntry_t*)&openqueue_vars.big_queue[i])->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                openqueue_getEntry(i)->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                openqueue_getEntry(i)->creator > COMPONENT_SIXTOP_RES &&
                 (
-                        toNeighbor->type == ADDR_64B &&
-                        packetfunctions_sameAddress(toNeighbor, &((OpenQueueEntry_t*)&openqueue_vars.big_queue[i])->l2_nextORpreviousHop)
+                        list != OPENQUEUE_TXLIST_UNICAST ||
+                        packetfunctions_sameAddress(toNeighbor, &openqueue_getEntry(i)->l2_nextORpreviousHop)
                 )
                 ) {
-            ENABLE_INTERRUPTS();
-            return (OpenQueueEntry_t*)&openqueue_vars.big_queue[i];
+            break;
         }
+        i = openqueue_vars.txNext[i];
     }
+
+    if (i == OPENQUEUE_NO_ENTRY) {
+        aqm->isAboveTarget = FALSE;
+        aqm->isDropping = FALSE;
+        ENABLE_INTERRUPTS();
+        return;
+    }
+
+    sojourn = ieee154e_asnDiff(&openqueue_vars.enqueueAsn[i]);
+
+    if (sojourn < OPENQUEUE_AQM_TARGET) {
+        // no standing queue
+        aqm->isAboveTarget = FALSE;
+        aqm->isDropping = FALSE;
+    } else if (aqm->isAboveTarget == FALSE) {
+        aqm->isAboveTarget = TRUE;
+        openqueue_getAsn(&aqm->aboveTargetSince);
+    } else if (aqm->isDropping == FALSE) {
+        if (ieee154e_asnDiff(&aqm->aboveTargetSince) >= OPENQUEUE_AQM_INTERVAL) {
+            aqm->isDropping = TRUE;
+            aqm->numDrops = 1;
+            openqueue_getAsn(&aqm->lastDrop);
+            openqueue_aqmDrop(i);
+        }
+    } else {
+        // the next drop is due OPENQUEUE_AQM_INTERVAL/sqrt(numDrops) slots after the last one
+        sinceLastDrop = ieee154e_asnDiff(&aqm->lastDrop);
+        if (
+                sinceLastDrop >= OPENQUEUE_AQM_INTERVAL ||
+                sinceLastDrop * sinceLastDrop >=
+                ((uint32_t) OPENQUEUE_AQM_INTERVAL * OPENQUEUE_AQM_INTERVAL) / aqm->numDrops
+                ) {
+            if (aqm->numDrops < 0xff) {
+                aqm->numDrops++;
+            }
+            openqueue_getAsn(&aqm->lastDrop);
+            openqueue_aqmDrop(i);
+        }
+    }
+
+    ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Number of packets of a creator dropped by the active queue management.
+
+\param creator The identifier of the creator, taken in COMPONENT_*.
+
+\returns The number of drops, which includes the drops of other creators once
+    all the OPENQUEUE_AQM_NUM_CREATORS counters are in use.
+*/
+uint16_t openqueue_getNumAqmDrops(uint8_t creator) {
+    uint8_t i;
+
+    for (i = 0; i < OPENQUEUE_AQM_NUM_CREATORS - 1; i++) {
+        if (openqueue_vars.aqmDrops[i].creator == creator) {
+            return openqueue_vars.aqmDrops[i].numDrops;
+        }
+        if (openqueue_vars.aqmDrops[i].creator == COMPONENT_NULL) {
+            return 0;
+        }
+    }
+    return openqueue_vars.aqmDrops[OPENQUEUE_AQM_NUM_CREATORS - 1].numDrops;
+}
 #endif
+
+//======= called by MSF and neighbors
+
+/**
+\brief Number of unicast packets waiting to be sent to a neighbor.
+
+The packet IEEE802154E is currently transmitting is counted, 6P responses are
+not.
+
+\param toNeighbor The 64-bit address of the neighbor.
+
+\returns The number of packets in the transmit list of the neighbor.
+*/
+uint8_t openqueue_getNumTxPackets(open_addr_t *toNeighbor) {
+    uint8_t i;
+    uint8_t list;
+    uint8_t numPackets;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    list = openqueue_getTxNeighborList(toNeighbor);
+    if (list != OPENQUEUE_TXLIST_UNICAST) {
+        numPackets = openqueue_vars.txLists[list].numPackets;
+    } else {
+        numPackets = 0;
+        i = openqueue_vars.txLists[list].head;
+        while (i != OPENQUEUE_NO_ENTRY) {
+            if (packetfunctions_sameAddress(toNeighbor, &openqueue_getEntry(i)->l2_nextORpreviousHop)) {
+                numPackets++;
+            }
+            i = openqueue_vars.txNext[i];
+        }
+    }
+
     ENABLE_INTERRUPTS();
-    return NULL;
+    return numPackets;
 }
 
 
 //=========================== private =========================================
 
+/**
+\brief Reset an allocated entry and put it back at the head of the free list.
+
+The following segments of a split packet are released as well.
+
+\note Must be called with interrupts disabled.
+*/
+void openqueue_release(uint8_t i) {
+    uint8_t next;
+
+    while (i != OPENQUEUE_NO_ENTRY) {
+#if OPENWSN_6LO_FRAGMENTATION_C
+        next = openqueue_vars.queue[i].l3_nextSegment;
+#else
+        next = OPENQUEUE_NO_ENTRY;
+#endif
+        if (openqueue_vars.isLowPriority[i]) {
+            openqueue_vars.isLowPriority[i] = FALSE;
+            openqueue_vars.numLowPriority--;
+        }
+        openqueue_txUnlink(i);
+        openqueue_reset_entry(&(openqueue_vars.queue[i]));
+        openqueue_vars.nextFree[i] = openqueue_vars.freeList;
+        openqueue_vars.freeList = i;
+        openqueue_vars.numFree++;
+
+        // stop if the segment was already released
+        if (next != OPENQUEUE_NO_ENTRY && openqueue_vars.queue[next].owner != COMPONENT_PACKETFUNCTIONS) {
+            next = OPENQUEUE_NO_ENTRY;
+        }
+        i = next;
+    }
+}
+
+/**
+\brief Index of an entry, big_queue entries come after queue entries.
+
+\returns The index, or OPENQUEUE_NO_ENTRY if pkt is not a queue entry.
+*/
+uint8_t openqueue_getIndex(OpenQueueEntry_t *pkt) {
+    if (pkt >= &openqueue_vars.queue[0] && pkt < &openqueue_vars.queue[QUEUELENGTH]) {
+        return (uint8_t) (pkt - &openqueue_vars.queue[0]);
+    }
+#if OPENWSN_6LO_FRAGMENTATION_C
+    if (
+            (OpenQueueBigEntry_t *) pkt >= &openqueue_vars.big_queue[0] &&
+            (OpenQueueBigEntry_t *) pkt < &openqueue_vars.big_queue[BIGQUEUELENGTH]
+            ) {
+        return (uint8_t) (QUEUELENGTH + ((OpenQueueBigEntry_t *) pkt - &openqueue_vars.big_queue[0]));
+    }
+#endif
+    return OPENQUEUE_NO_ENTRY;
+}
+
+OpenQueueEntry_t* openqueue_getEntry(uint8_t i) {
+#if OPENWSN_6LO_FRAGMENTATION_C
+    if (i >= QUEUELENGTH) {
+        return &openqueue_vars.big_queue[i - QUEUELENGTH].standard_entry;
+    }
+#endif
+    return &openqueue_vars.queue[i];
+}
+
+/**
+\brief Transmit list holding the unicast packets to a neighbor.
+
+\returns The per-neighbor list, or OPENQUEUE_TXLIST_UNICAST if the neighbor
+    has none.
+*/
+uint8_t openqueue_getTxNeighborList(open_addr_t *neighbor) {
+    uint8_t i;
+
+    for (i = 0; i < OPENQUEUE_TX_NEIGHBORS; i++) {
+        if (
+                openqueue_vars.txNeighbors[i].type != ADDR_NONE &&
+                packetfunctions_sameAddress(neighbor, &openqueue_vars.txNeighbors[i])
+                ) {
+            return OPENQUEUE_TXLIST_NEIGHBOR + i;
+        }
+    }
+    return OPENQUEUE_TXLIST_UNICAST;
+}
+
+/**
+\brief Select the transmit list of a packet, claiming a per-neighbor list if
+    its next hop has none yet.
+
+Packets to the same next hop waiting in OPENQUEUE_TXLIST_UNICAST are moved to
+a newly claimed list, so they keep being sent first.
+*/
+uint8_t openqueue_allocateTxList(OpenQueueEntry_t *pkt) {
+    uint8_t i;
+    uint8_t j;
+    uint8_t next;
+    uint8_t list;
+
+    if (packetfunctions_isBroadcastMulticast(&(pkt->l2_nextORpreviousHop))) {
+        if (pkt->creator == COMPONENT_SIXTOP) {
+            return OPENQUEUE_TXLIST_EB;
+        }
+        if (pkt->creator == COMPONENT_ICMPv6RPL) {
+            return OPENQUEUE_TXLIST_DIO;
+        }
+        return OPENQUEUE_TXLIST_BROADCAST;
+    }
+
+    if (pkt->creator == COMPONENT_SIXTOP_RES && pkt->l2_sixtop_messageType == SIXTOP_CELL_RESPONSE) {
+        return OPENQUEUE_TXLIST_6PRESPONSE;
+    }
+
+    if (pkt->l2_nextORpreviousHop.type != ADDR_64B) {
+        return OPENQUEUE_TXLIST_UNICAST;
+    }
+
+    list = openqueue_getTxNeighborList(&(pkt->l2_nextORpreviousHop));
+    if (list != OPENQUEUE_TXLIST_UNICAST) {
+        return list;
+    }
+    for (i = 0; i < OPENQUEUE_TX_NEIGHBORS; i++) {
+        if (openqueue_vars.txNeighbors[i].type == ADDR_NONE) {
+            memcpy(&openqueue_vars.txNeighbors[i], &(pkt->l2_nextORpreviousHop), sizeof(open_addr_t));
+            list = OPENQUEUE_TXLIST_NEIGHBOR + i;
+            j = openqueue_vars.txLists[OPENQUEUE_TXLIST_UNICAST].head;
+            while (j != OPENQUEUE_NO_ENTRY) {
+                next = openqueue_vars.txNext[j];
+                if (packetfunctions_sameAddress(&(pkt->l2_nextORpreviousHop), &openqueue_getEntry(j)->l2_nextORpreviousHop)) {
+                    openqueue_txUnlink(j);
+                    openqueue_txLink(j, list);
+                }
+                j = next;
+            }
+            return list;
+        }
+    }
+    return OPENQUEUE_TXLIST_UNICAST;
+}
+
+/**
+\brief Append an entry at the end of a transmit list.
+
+\note Must be called with interrupts disabled.
+*/
+void openqueue_txLink(uint8_t i, uint8_t list) {
+    openqueue_txList_t *txList;
+
+    txList = &openqueue_vars.txLists[list];
+    openqueue_vars.txList[i] = list;
+    openqueue_vars.txNext[i] = OPENQUEUE_NO_ENTRY;
+    openqueue_vars.txPrev[i] = txList->tail;
+    if (txList->tail == OPENQUEUE_NO_ENTRY) {
+        txList->head = i;
+    } else {
+        openqueue_vars.txNext[txList->tail] = i;
+    }
+    txList->tail = i;
+    txList->numPackets++;
+}
+
+/**
+\brief Remove an entry from its transmit list, if any. An emptied per-neighbor
+    list is released.
+
+\note Must be called with interrupts disabled.
+*/
+void openqueue_txUnlink(uint8_t i) {
+    uint8_t list;
+    openqueue_txList_t *txList;
+
+    list = openqueue_vars.txList[i];
+    if (list == OPENQUEUE_NO_ENTRY) {
+        return;
+    }
+    txList = &openqueue_vars.txLists[list];
+
+    if (openqueue_vars.txPrev[i] == OPENQUEUE_NO_ENTRY) {
+        txList->head = openqueue_vars.txNext[i];
+    } else {
+        openqueue_vars.txNext[openqueue_vars.txPrev[i]] = openqueue_vars.txNext[i];
+    }
+    if (openqueue_vars.txNext[i] == OPENQUEUE_NO_ENTRY) {
+        txList->tail = openqueue_vars.txPrev[i];
+    } else {
+        openqueue_vars.txPrev[openqueue_vars.txNext[i]] = openqueue_vars.txPrev[i];
+    }
+    txList->numPackets--;
+    openqueue_vars.txList[i] = OPENQUEUE_NO_ENTRY;
+
+    if (list >= OPENQUEUE_TXLIST_NEIGHBOR && txList->numPackets == 0) {
+        openqueue_vars.txNeighbors[list - OPENQUEUE_TXLIST_NEIGHBOR].type = ADDR_NONE;
+    }
+}
+
+/**
+\brief Oldest packet of a transmit list which IEEE802154E is not already
+    transmitting.
+*/
+OpenQueueEntry_t* openqueue_getFirstTxPacket(uint8_t list) {
+    uint8_t i;
+    INTERRUPT_DECLARATION();
+    DISABLE_INTERRUPTS();
+
+    i = openqueue_vars.txLists[list].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
+        if (openqueue_getEntry(i)->owner == COMPONENT_SIXTOP_TO_IEEE802154E) {
+            ENABLE_INTERRUPTS();
+            return openqueue_getEntry(i);
+        }
+        i = openqueue_vars.txNext[i];
+    }
+
+    ENABLE_INTERRUPTS();
+    return NULL;
+}
+
+#if OPENQUEUE_AQM
+/**
+\brief Drop a packet of an overloaded transmit list, counting it against its creator.
+
+\note Must be called with interrupts disabled.
+*/
+void openqueue_aqmDrop(uint8_t i) {
+    uint8_t j;
+    OpenQueueEntry_t *pkt;
+
+    pkt = openqueue_getEntry(i);
+
+    // the last counter is shared by the creators which did not get one
+    for (j = 0; j < OPENQUEUE_AQM_NUM_CREATORS - 1; j++) {
+        if (openqueue_vars.aqmDrops[j].creator == COMPONENT_NULL) {
+            openqueue_vars.aqmDrops[j].creator = pkt->creator;
+        }
+        if (openqueue_vars.aqmDrops[j].creator == pkt->creator) {
+            break;
+        }
+    }
+    openqueue_vars.aqmDrops[j].numDrops++;
+
+    LOG_INFO(COMPONENT_OPENQUEUE, ERR_AQM_DROP,
+             (errorparameter_t) pkt->creator,
+             (errorparameter_t) openqueue_vars.aqmDrops[j].numDrops);
+
+    openqueue_dropTxPacket(i);
+}
+#endif
+
+#if DEADLINE_OPTION
+/**
+\brief Pick the unicast packet of a transmit list which expires first.
+
+Packets without an expiration time come after the others, packets expiring at
+the same time in the order they were handed to IEEE802154E. Expired packets
+whose drop flag is set are dropped.
+
+\note Must be called with interrupts disabled.
+
+\returns The index of the packet, or OPENQUEUE_NO_ENTRY.
+*/
+uint8_t openqueue_edfGetPacket(uint8_t list, open_addr_t *toNeighbor) {
+    uint8_t i;
+    uint8_t next;
+    uint8_t earliest;
+    OpenQueueEntry_t *pkt;
+
+    earliest = OPENQUEUE_NO_ENTRY;
+    i = openqueue_vars.txLists[list].head;
+    while (i != OPENQUEUE_NO_ENTRY) {
+        next = openqueue_vars.txNext[i];
+        pkt = openqueue_getEntry(i);
+        if (
+                pkt->owner == COMPONENT_SIXTOP_TO_IEEE802154E &&
+                (
+                        list != OPENQUEUE_TXLIST_UNICAST ||
+                        packetfunctions_sameAddress(toNeighbor, &pkt->l2_nextORpreviousHop)
+                )
+                ) {
+            if (pkt->has_expiration_asn && pkt->drop_flag && openqueue_isExpired(pkt)) {
+                // don't waste a cell on it
+                openqueue_vars.numDeadlineDropped++;
+                LOG_WARNING(COMPONENT_OPENQUEUE, ERR_6LORH_DEADLINE_DROPPED, (errorparameter_t) 0,
+                            (errorparameter_t) 0);
+                openqueue_dropTxPacket(i);
+            } else if (
+                    earliest == OPENQUEUE_NO_ENTRY ||
+                    (
+                            pkt->has_expiration_asn &&
+                            (
+                                    openqueue_getEntry(earliest)->has_expiration_asn == FALSE ||
+                                    asnfunctions_compare(
+                                            &pkt->expiration_asn,
+                                            &openqueue_getEntry(earliest)->expiration_asn
+                                    ) < 0
+                            )
+                    )
+                    ) {
+                earliest = i;
+            }
+        }
+        i = next;
+    }
+
+    return earliest;
+}
+
+bool openqueue_isExpired(OpenQueueEntry_t *pkt) {
+    asn_t now;
+
+    openqueue_getAsn(&now);
+    return asnfunctions_compare(&pkt->expiration_asn, &now) < 0;
+}
+#endif
+
+#if OPENQUEUE_AQM || DEADLINE_OPTION
+/**
+\brief Drop a packet handed to IEEE802154E, as if its transmission failed.
+
+\note Must be called with interrupts disabled.
+*/
+void openqueue_dropTxPacket(uint8_t i) {
+    OpenQueueEntry_t *pkt;
+
+    pkt = openqueue_getEntry(i);
+
+    // hand the packet back to sixtop, like IEEE802154E does after the last retry
+    pkt->l2_sendDoneError = E_FAIL;
+    openqueue_txUnlink(i);
+    pkt->owner = COMPONENT_IEEE802154E_TO_SIXTOP;
+    scheduler_push_task(task_sixtopNotifSendDone, TASKPRIO_SIXTOP_NOTIF_TXDONE);
+}
+
+void openqueue_getAsn(asn_t *asn) {
+    uint8_t array[5];
+
+    ieee154e_getAsn(array);
+    asnfunctions_fromArray(asn, array);
+}
+#endif
+
 void openqueue_reset_entry(OpenQueueEntry_t *entry) {
     //admin
     entry->creator = COMPONENT_NULL;
@@ -518,6 +1256,10 @@ void openqueue_reset_entry(OpenQueueEntry_t *entry) {
     entry->is_cjoin_response = FALSE;
 #if OPENWSN_6LO_FRAGMENTATION_C
     entry->is_big_packet = FALSE;
+#endif
+#if DEADLINE_OPTION
+    entry->drop_flag = FALSE;
+    entry->has_expiration_asn = FALSE;
 #endif
     //l4
     entry->l4_protocol = IANA_UNDEFINED;
@@ -528,9 +1270,15 @@ void openqueue_reset_entry(OpenQueueEntry_t *entry) {
     entry->l3_useSourceRouting = FALSE;
 #if OPENWSN_6LO_FRAGMENTATION_C
     entry->l3_isFragment = FALSE;
+    entry->l3_nextSegment = OPENQUEUE_NO_ENTRY;
+    entry->l3_segmentLength = 0;
 #endif
     //l2
     entry->l2_sixtop_command = IANA_6TOP_CMD_NONE;
+    if (entry->l2_sixtop_cellListsHandle < OPENQUEUE_NUM_SIXTOP_CELLLISTS) {
+        openqueue_vars.sixtopCellListsUsed[entry->l2_sixtop_cellListsHandle] = FALSE;
+    }
+    entry->l2_sixtop_cellListsHandle = OPENQUEUE_NO_ENTRY;
     entry->l2_nextORpreviousHop.type = ADDR_NONE;
     entry->l2_frameType = IEEE154_TYPE_UNDEFINED;
     entry->l2_retriesLeft = 0;
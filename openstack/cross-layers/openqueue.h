@@ -26,6 +26,59 @@
 #define BIGQUEUELENGTH  0
 #endif
 
+#define OPENQUEUE_NUM_ENTRIES  (QUEUELENGTH + BIGQUEUELENGTH)
+
+#define OPENQUEUE_NO_ENTRY  0xff
+
+#if OPENQUEUE_NUM_ENTRIES >= OPENQUEUE_NO_ENTRY
+#error "QUEUELENGTH + BIGQUEUELENGTH must be smaller than OPENQUEUE_NO_ENTRY"
+#endif
+
+// number of neighbors which can have their own transmit list at the same time
+#ifndef OPENQUEUE_TX_NEIGHBORS
+#define OPENQUEUE_TX_NEIGHBORS  4
+#endif
+
+/**
+\brief Lists of the packets handed to IEEE802154E, one per kind of cell.
+
+Unicast packets are kept in the list of their next hop, except 6P responses
+which go first. Unicast packets to a neighbor without a free list go to
+OPENQUEUE_TXLIST_UNICAST.
+*/
+enum {
+    OPENQUEUE_TXLIST_EB = 0,            // EBs, sent on the minimal cell
+    OPENQUEUE_TXLIST_DIO = 1,           // multicast DIOs, sent on the minimal cell
+    OPENQUEUE_TXLIST_6PRESPONSE = 2,    // 6P responses to any neighbor
+    OPENQUEUE_TXLIST_BROADCAST = 3,     // other broadcast packets, never picked by IEEE802154E
+    OPENQUEUE_TXLIST_UNICAST = 4,       // unicast packets to neighbors without a list of their own
+    OPENQUEUE_TXLIST_NEIGHBOR = 5,      // first per-neighbor list
+};
+
+#define OPENQUEUE_NUM_TXLISTS  (OPENQUEUE_TXLIST_NEIGHBOR + OPENQUEUE_TX_NEIGHBORS)
+
+// number of 6P responses which can record cell lists at the same time
+#ifndef OPENQUEUE_NUM_SIXTOP_CELLLISTS
+#define OPENQUEUE_NUM_SIXTOP_CELLLISTS  2
+#endif
+
+#if OPENQUEUE_AQM
+// acceptable sojourn time of a data packet, in slots (about 3 slotframes of 101 slots)
+#ifndef OPENQUEUE_AQM_TARGET
+#define OPENQUEUE_AQM_TARGET  300
+#endif
+
+// time the sojourn time may stay above target before dropping, in slots
+#ifndef OPENQUEUE_AQM_INTERVAL
+#define OPENQUEUE_AQM_INTERVAL  1000
+#endif
+
+// number of creators whose drops are counted separately
+#ifndef OPENQUEUE_AQM_NUM_CREATORS
+#define OPENQUEUE_AQM_NUM_CREATORS  4
+#endif
+#endif
+
 //=========================== typedef =========================================
 
 typedef struct {
@@ -33,12 +86,65 @@ typedef struct {
     uint8_t owner;
 } debugOpenQueueEntry_t;
 
+typedef struct {
+    uint8_t head;                               // index of the oldest entry, OPENQUEUE_NO_ENTRY when empty
+    uint8_t tail;                               // index of the newest entry
+    uint8_t numPackets;                         // number of entries in the list
+} openqueue_txList_t;
+
+typedef struct {
+    cellInfo_ht celllist_add[CELLLIST_MAX_LEN];     // cells to be added when the 6P response is sent
+    cellInfo_ht celllist_delete[CELLLIST_MAX_LEN];  // cells to be removed when the 6P response is sent
+} openqueue_sixtopCellLists_t;
+
+#if OPENQUEUE_AQM
+typedef struct {
+    asn_t aboveTargetSince;                     // when the sojourn time went above target
+    asn_t lastDrop;                             // when the last packet was dropped
+    uint8_t numDrops;                           // packets dropped since the sojourn time went above target
+    bool isAboveTarget;                         // sojourn time of the first packet is above target
+    bool isDropping;                            // dropping packets until the sojourn time goes below target
+} openqueue_aqm_t;
+
+typedef struct {
+    uint8_t creator;                            // COMPONENT_NULL for the counter of all other creators
+    uint16_t numDrops;
+} openqueue_aqmDrops_t;
+#endif
+
 //=========================== module variables ================================
 
 typedef struct {
     OpenQueueEntry_t queue[QUEUELENGTH];
+    uint8_t nextFree[QUEUELENGTH];              // index of the next free entry, valid for free entries only
+    bool isLowPriority[QUEUELENGTH];            // creator was above COMPONENT_SIXTOP_RES, counted in numLowPriority
+    uint8_t freeList;                           // index of the first free entry, OPENQUEUE_NO_ENTRY when full
+    uint8_t numFree;                            // number of free entries
+    uint8_t numLowPriority;                     // number of entries held by components above COMPONENT_SIXTOP_RES
 #if OPENWSN_6LO_FRAGMENTATION_C
     OpenQueueBigEntry_t big_queue[BIGQUEUELENGTH];
+#endif
+    // entries handed to IEEE802154E, big_queue entries are indexed after queue entries
+    openqueue_txList_t txLists[OPENQUEUE_NUM_TXLISTS];
+    open_addr_t txNeighbors[OPENQUEUE_TX_NEIGHBORS];  // next hop of each per-neighbor list, ADDR_NONE when unused
+    uint8_t txList[OPENQUEUE_NUM_ENTRIES];      // list the entry is in, OPENQUEUE_NO_ENTRY when in none
+    uint8_t txNext[OPENQUEUE_NUM_ENTRIES];      // index of the next entry in the same list
+    uint8_t txPrev[OPENQUEUE_NUM_ENTRIES];      // index of the previous entry in the same list
+    // cell lists of the 6P responses, referenced by l2_sixtop_cellListsHandle
+    openqueue_sixtopCellLists_t sixtopCellLists[OPENQUEUE_NUM_SIXTOP_CELLLISTS];
+    bool sixtopCellListsUsed[OPENQUEUE_NUM_SIXTOP_CELLLISTS];
+#if OPENQUEUE_AQM
+    // active queue management of the unicast transmit lists
+    asn_t enqueueAsn[OPENQUEUE_NUM_ENTRIES];    // when the entry was handed to IEEE802154E
+    openqueue_aqm_t aqm[OPENQUEUE_NUM_TXLISTS];
+    openqueue_aqmDrops_t aqmDrops[OPENQUEUE_AQM_NUM_CREATORS];
+#endif
+#if DEADLINE_OPTION
+    // outcome of the packets with an expiration time
+    uint16_t numDeadlineMet;
+    uint16_t numDeadlineMissed;
+    uint16_t numDeadlineFailed;
+    uint16_t numDeadlineDropped;
 #endif
 } openqueue_vars_t;
 
@@ -60,12 +166,26 @@ owerror_t openqueue_freePacketBuffer(OpenQueueEntry_t *pkt);
 
 void openqueue_removeAllCreatedBy(uint8_t creator);
 
+void openqueue_setCreator(OpenQueueEntry_t *pkt, uint8_t creator);
+
+#if OPENWSN_6LO_FRAGMENTATION_C
+OpenQueueEntry_t* openqueue_getNextSegment(OpenQueueEntry_t *pkt);
+
+void openqueue_setNextSegment(OpenQueueEntry_t *pkt, OpenQueueEntry_t *segment);
+#endif
+
 bool openqueue_isHighPriorityEntryEnough(void);
 
 // called by ICMPv6
 void openqueue_updateNextHopPayload(open_addr_t *newNextHop);
 
 // called by res
+void openqueue_sixtopEnqueuePacket(OpenQueueEntry_t *pkt);
+
+openqueue_sixtopCellLists_t* openqueue_sixtopAllocateCellLists(OpenQueueEntry_t *pkt);
+
+openqueue_sixtopCellLists_t* openqueue_sixtopGetCellLists(OpenQueueEntry_t *pkt);
+
 OpenQueueEntry_t* openqueue_sixtopGetSentPacket(void);
 
 OpenQueueEntry_t* openqueue_sixtopGetReceivedPacket(void);
@@ -85,6 +205,21 @@ OpenQueueEntry_t* openqueue_macGetDIOPacket(void);
 
 OpenQueueEntry_t* openqueue_macGetUnicastPacket(open_addr_t *toNeighbor);
 
+void openqueue_macTxDone(OpenQueueEntry_t *pkt);
+
+#if OPENQUEUE_AQM
+void openqueue_macAqmCheck(open_addr_t *toNeighbor);
+
+uint16_t openqueue_getNumAqmDrops(uint8_t creator);
+#endif
+
+#if DEADLINE_OPTION
+void openqueue_getDeadlineStats(uint16_t *numMet, uint16_t *numMissed, uint16_t *numFailed, uint16_t *numDropped);
+#endif
+
+// called by MSF and neighbors
+uint8_t openqueue_getNumTxPackets(open_addr_t *toNeighbor);
+
 // called by transport layer
 OpenQueueEntry_t* openqueue_getPacketByComponent(uint8_t component);
 /**
@@ -1,7 +1,10 @@
+#include <stddef.h>
+
 #include "config.h"
 #include "packetfunctions.h"
 #include "IEEE802154_security.h"
 #include "openserial.h"
+#include "openchecksum.h"
 #include "openqueue.h"
 #include "idmanager.h"
 #include "radio.h"
@@ -10,8 +13,6 @@
 
 //=========================== prototypes ======================================
 
-void onesComplementSum(uint8_t *global_sum, uint8_t *ptr, int length);
-
 //=========================== public ==========================================
 
 //======= address translation
@@ -299,20 +300,71 @@ owerror_t packetfunctions_reserveHeader(OpenQueueEntry_t **pkt, uint16_t header_
     available_bytes = IEEE802154_FRAME_SIZE - LENGTH_CRC - IEEE802154_SECURITY_TAG_LEN;
 
 #if OPENWSN_6LO_FRAGMENTATION_C
-    if ((*pkt)->is_big_packet == FALSE && ((*pkt)->length + header_length) > available_bytes) {
-        // CASE 1: small packet exceeding it boundaries, try copy to big packet.
+    uint16_t segment_length;
+    OpenQueueEntry_t *hpkt;
+
+    segment_length = packetfunctions_getSegmentLength(*pkt);
+
+    if ((*pkt)->is_big_packet == FALSE && (segment_length + header_length) > available_bytes) {
+        // CASE 1: small packet exceeding it boundaries, put the header in a new segment or copy to big packet.
 
         // below the fragmentation layer, we cannot use big packets
         if ((*pkt)->owner < COMPONENT_FRAG) {
             return E_FAIL;
         }
 
+        if ((*pkt)->length + header_length > IPV6_PACKET_SIZE) {
+            LOG_ERROR(COMPONENT_PACKETFUNCTIONS, ERR_PACKET_TOO_LONG,
+                      (errorparameter_t) (*pkt)->length,
+                      (errorparameter_t) header_length);
+            return E_FAIL;
+        }
+
+        // the layers up to UDP only read the packet through the functions of this module, the layers above
+        // expect a contiguous buffer
+        if (
+                (*pkt)->owner <= COMPONENT_SOCK_TO_UDP &&
+                header_length <= available_bytes &&
+                (hpkt = openqueue_getFreePacketBuffer((*pkt)->creator)) != NULL
+                ) {
+            // CASE 1a: the header goes in a new first segment, the bytes already written are not copied
+
+            // move the metadata, but not the buffer
+            memcpy(hpkt, (*pkt), offsetof(OpenQueueEntry_t, packet));
+            // the 6P cell lists move to the new first segment, they are released once
+            (*pkt)->l2_sixtop_cellListsHandle = OPENQUEUE_NO_ENTRY;
+
+            hpkt->payload = &hpkt->packet[available_bytes - header_length];
+            hpkt->length = (*pkt)->length + header_length;
+            hpkt->l3_segmentLength = header_length;
+            openqueue_setNextSegment(hpkt, (*pkt));
+
+            // the previous first segment is freed with the packet
+            (*pkt)->l3_segmentLength = segment_length;
+            (*pkt)->owner = COMPONENT_PACKETFUNCTIONS;
+
+            // set pointer
+            (*pkt) = hpkt;
+
+            return E_SUCCESS;
+        }
+
+        // the segments of a split packet cannot be copied to a big packet
+        if (openqueue_getNextSegment(*pkt) != NULL) {
+            LOG_ERROR(COMPONENT_PACKETFUNCTIONS, ERR_PACKET_TOO_LONG,
+                      (errorparameter_t) (*pkt)->length,
+                      (errorparameter_t) header_length);
+            return E_FAIL;
+        }
+
         OpenQueueEntry_t *bpkt;
         if ((bpkt = openqueue_getFreeBigPacketBuffer((*pkt)->creator)) == NULL) {
             return E_FAIL;
         }
 
         memcpy(bpkt, (*pkt), sizeof(OpenQueueEntry_t));
+        // the 6P cell lists stay with the small packet until the copy succeeds
+        bpkt->l2_sixtop_cellListsHandle = OPENQUEUE_NO_ENTRY;
 
         // reset some packet metadata
         bpkt->length = 0;
@@ -335,19 +387,33 @@ owerror_t packetfunctions_reserveHeader(OpenQueueEntry_t **pkt, uint16_t header_
 
         LOG_VERBOSE(COMPONENT_PACKETFUNCTIONS, ERR_COPY_TO_BPKT, (*pkt)->length + header_length, available_bytes);
 
+        // move the 6P cell lists, so that releasing the small packet does not release them
+        bpkt->l2_sixtop_cellListsHandle = (*pkt)->l2_sixtop_cellListsHandle;
+        (*pkt)->l2_sixtop_cellListsHandle = OPENQUEUE_NO_ENTRY;
+
         // release normal OpenQueueEntry
         openqueue_freePacketBuffer((*pkt));
 
         // set pointer
         (*pkt) = bpkt;
-    } else if ((*pkt)->is_big_packet == FALSE && (*pkt)->length + header_length <= available_bytes){
+    } else if ((*pkt)->is_big_packet == FALSE && segment_length + header_length <= available_bytes){
         // CASE 2: within boundaries small packet, do normal allocation
+        if (openqueue_getNextSegment(*pkt) != NULL) {
+            if ((*pkt)->length + header_length > IPV6_PACKET_SIZE) {
+                LOG_ERROR(COMPONENT_PACKETFUNCTIONS, ERR_PACKET_TOO_LONG,
+                          (errorparameter_t) (*pkt)->length,
+                          (errorparameter_t) header_length);
+                return E_FAIL;
+            }
+            (*pkt)->l3_segmentLength += header_length;
+        }
         (*pkt)->payload -= header_length;
         (*pkt)->length += header_length;
+        segment_length += header_length;
 
         // check for buffer overflow on the left and on the right
         if ((uint8_t * )((*pkt)->payload) < (uint8_t * )((*pkt)->packet) ||
-            (*pkt)->payload + (*pkt)->length > &(*pkt)->packet[IEEE802154_FRAME_SIZE]) {
+            (*pkt)->payload + segment_length > &(*pkt)->packet[IEEE802154_FRAME_SIZE]) {
             LOG_CRITICAL(COMPONENT_PACKETFUNCTIONS, ERR_PACKET_TOO_LONG,
                          (errorparameter_t) (*pkt)->length,
                          (errorparameter_t) header_length);
@@ -412,13 +478,17 @@ void packetfunctions_tossHeader(OpenQueueEntry_t **pkt, uint16_t header_length)
     if ((*pkt)->is_big_packet == FALSE) {
         // CASE 1: is a small packet, just toss bytes
         if ((uint8_t * )((*pkt)->payload + header_length) > &((*pkt)->packet[IEEE802154_FRAME_SIZE]) ||
-            (*pkt)->length - header_length < 0) {
+            (*pkt)->length - header_length < 0 ||
+            packetfunctions_getSegmentLength(*pkt) < header_length) {
             LOG_CRITICAL(COMPONENT_PACKETFUNCTIONS, ERR_PACKET_TOO_SHORT,
                          (errorparameter_t) (*pkt)->length,
                          (errorparameter_t) header_length);
             return;
         }
 
+        if (openqueue_getNextSegment(*pkt) != NULL) {
+            (*pkt)->l3_segmentLength -= header_length;
+        }
         (*pkt)->payload += header_length;
         (*pkt)->length -= header_length;
     } else {
@@ -444,6 +514,8 @@ void packetfunctions_tossHeader(OpenQueueEntry_t **pkt, uint16_t header_length)
             }
 
             memcpy(spkt, (*pkt), sizeof(OpenQueueEntry_t));
+            // the 6P cell lists stay with the big packet until the copy succeeds
+            spkt->l2_sixtop_cellListsHandle = OPENQUEUE_NO_ENTRY;
 
             spkt->length = 0;
             spkt->is_big_packet = FALSE;
@@ -459,6 +531,10 @@ void packetfunctions_tossHeader(OpenQueueEntry_t **pkt, uint16_t header_length)
 
             LOG_VERBOSE(COMPONENT_PACKETFUNCTIONS, ERR_COPY_TO_SPKT, (*pkt)->length, available_bytes);
 
+            // move the 6P cell lists, so that releasing the big packet does not release them
+            spkt->l2_sixtop_cellListsHandle = (*pkt)->l2_sixtop_cellListsHandle;
+            (*pkt)->l2_sixtop_cellListsHandle = OPENQUEUE_NO_ENTRY;
+
             // release OpenQueueBigEntry
             openqueue_freePacketBuffer((*pkt));
 
@@ -507,6 +583,60 @@ void packetfunctions_tossFooter(OpenQueueEntry_t **pkt, uint16_t footer_length)
     }
 }
 
+#if OPENWSN_6LO_FRAGMENTATION_C
+//======= split packets
+
+/**
+\brief Number of bytes of a packet held in its first segment.
+
+A packet is split when packetfunctions_reserveHeader() puts a header in a new
+entry rather than copying the packet to a big entry, see
+openqueue_getNextSegment(). pkt->payload then only points to pkt->l3_segmentLength
+bytes, while pkt->length still counts the bytes of all the segments.
+*/
+uint16_t packetfunctions_getSegmentLength(OpenQueueEntry_t *pkt) {
+    if (openqueue_getNextSegment(pkt) == NULL) {
+        return pkt->length;
+    }
+    return pkt->l3_segmentLength;
+}
+
+/**
+\brief Copy bytes out of a packet, which may be split.
+
+\param pkt    The packet.
+\param offset Offset of the first byte to copy, from pkt->payload.
+\param dst    Where to copy the bytes to.
+\param length Number of bytes to copy.
+*/
+void packetfunctions_readBytes(OpenQueueEntry_t *pkt, uint16_t offset, uint8_t *dst, uint16_t length) {
+    uint16_t segment_length;
+    uint16_t num_bytes;
+
+    while (pkt != NULL && length > 0) {
+        segment_length = packetfunctions_getSegmentLength(pkt);
+        if (offset < segment_length) {
+            num_bytes = segment_length - offset;
+            if (num_bytes > length) {
+                num_bytes = length;
+            }
+            memcpy(dst, pkt->payload + offset, num_bytes);
+            dst += num_bytes;
+            length -= num_bytes;
+            offset = 0;
+        } else {
+            offset -= segment_length;
+        }
+        pkt = openqueue_getNextSegment(pkt);
+    }
+
+    if (length > 0) {
+        LOG_CRITICAL(COMPONENT_PACKETFUNCTIONS, ERR_PACKET_TOO_SHORT,
+                     (errorparameter_t) offset,
+                     (errorparameter_t) length);
+    }
+}
+#endif
 
 //======= packet duplication
 // function duplicates a frame from one OpenQueueEntry structure to the other,
@@ -517,6 +647,9 @@ void packetfunctions_duplicatePacket(OpenQueueEntry_t *dst, OpenQueueEntry_t *sr
 
     memcpy(dst, src, sizeof(OpenQueueEntry_t));
 
+    // the 6P cell lists stay with the original, which releases them
+    dst->l2_sixtop_cellListsHandle = OPENQUEUE_NO_ENTRY;
+
     // Calculate where payload starts in the buffer
     dst->payload = &dst->packet[src->payload - src->packet]; // update pointers
 
@@ -537,19 +670,10 @@ void packetfunctions_duplicatePacket(OpenQueueEntry_t *dst, OpenQueueEntry_t *sr
 
 void packetfunctions_calculateCRC(OpenQueueEntry_t *msg) {
     uint16_t crc;
-    uint8_t i;
-    uint8_t count;
+
     crc = 0;
-    for (count = 1; count < msg->length - 2; count++) {
-        crc = crc ^ (uint8_t) * (msg->payload + count);
-        //crc = crc ^ (uint16_t)*ptr++ << 8;
-        for (i = 0; i < 8; i++) {
-            if (crc & 0x1) {
-                crc = crc >> 1 ^ 0x8408;
-            } else {
-                crc = crc >> 1;
-            }
-        }
+    if (msg->length > 3) {
+        crc = openchecksum_crc16(crc, msg->payload + 1, msg->length - 3);
     }
     *(msg->payload + (msg->length - 2)) = crc % 256;
     *(msg->payload + (msg->length - 1)) = crc / 256;
@@ -557,19 +681,10 @@ void packetfunctions_calculateCRC(OpenQueueEntry_t *msg) {
 
 bool packetfunctions_checkCRC(OpenQueueEntry_t *msg) {
     uint16_t crc;
-    uint8_t i;
-    uint8_t count;
+
     crc = 0;
-    for (count = 0; count < msg->length - 2; count++) {
-        crc = crc ^ (uint8_t) * (msg->payload + count);
-        //crc = crc ^ (uint16_t)*ptr++ << 8;
-        for (i = 0; i < 8; i++) {
-            if (crc & 0x1) {
-                crc = crc >> 1 ^ 0x8408;
-            } else {
-                crc = crc >> 1;
-            }
-        }
+    if (msg->length > 2) {
+        crc = openchecksum_crc16(crc, msg->payload, msg->length - 2);
     }
     if (*(msg->payload + (msg->length - 2)) == crc % 256 &&
         *(msg->payload + (msg->length - 1)) == crc / 256) {
@@ -584,48 +699,34 @@ bool packetfunctions_checkCRC(OpenQueueEntry_t *msg) {
 //see http://www-net.cs.umass.edu/kurose/transport/UDP.html, or http://tools.ietf.org/html/rfc1071
 //see http://en.wikipedia.org/wiki/User_Datagram_Protocol#IPv6_PSEUDO-HEADER
 void packetfunctions_calculateChecksum(OpenQueueEntry_t *msg, uint8_t *checksum_ptr) {
-    uint8_t temp_checksum[2];
+    uint32_t sum;
+    uint16_t checksum;
+    open_addr_t source;
+#if OPENWSN_6LO_FRAGMENTATION_C
     uint8_t little_helper[2];
-    open_addr_t localscopeAddress;
+    OpenQueueEntry_t *segment;
+    uint8_t *ptr;
+    uint16_t length;
+    bool odd;
+#endif
 
-    // initialize running checksum
-    temp_checksum[0] = 0;
-    temp_checksum[1] = 0;
+    // initialize running checksum, carries are folded back only once at the end
+    sum = 0;
 
     //===== IPv6 pseudo header
 
-    // determine the source and destination address format
-    if (packetfunctions_isBroadcastMulticast(&msg->l3_destinationAdd) == TRUE) {
-        // use link local address for source address (prefix and EUI64)
-
-        // source address
-        onesComplementSum(temp_checksum, (uint8_t *) linklocalprefix, 8);
-        memcpy(&localscopeAddress, idmanager_getMyID(ADDR_64B), sizeof(open_addr_t));
-        // invert 'u' bit (section 2.5.1 at https://www.ietf.org/rfc/rfc2373.txt)
-        localscopeAddress.addr_64b[0] ^= 0x02;
-        onesComplementSum(temp_checksum, localscopeAddress.addr_64b, 8);
+    // source address
+    packetfunctions_getChecksumSource(&msg->l3_destinationAdd, &source);
+    sum = openchecksum_sum(sum, source.addr_128b, 16);
 
-        // boardcast destination address
-        onesComplementSum(temp_checksum, msg->l3_destinationAdd.addr_128b, 16);
-    } else {
-        // use 128-bit ipv6 address for source address and destination address
-
-        // source address
-        onesComplementSum(temp_checksum, (idmanager_getMyID(ADDR_PREFIX))->prefix, 8);
-        onesComplementSum(temp_checksum, (idmanager_getMyID(ADDR_64B))->addr_64b, 8);
-        // destination address
-        onesComplementSum(temp_checksum, msg->l3_destinationAdd.addr_128b, 16);
-    }
+    // destination address
+    sum = openchecksum_sum(sum, msg->l3_destinationAdd.addr_128b, 16);
 
     // length
-    little_helper[0] = (msg->length & 0xFF00) >> 8;
-    little_helper[1] = (msg->length & 0x00FF);
-    onesComplementSum(temp_checksum, little_helper, 2);
+    sum += (uint16_t) msg->length;
 
     // next header
-    little_helper[0] = 0;
-    little_helper[1] = msg->l4_protocol;
-    onesComplementSum(temp_checksum, little_helper, 2);
+    sum += msg->l4_protocol;
 
     //===== payload
 
@@ -633,31 +734,81 @@ void packetfunctions_calculateChecksum(OpenQueueEntry_t *msg, uint8_t *checksum_
     *checksum_ptr = 0;
     *(checksum_ptr + 1) = 0;
 
-    onesComplementSum(temp_checksum, msg->payload, msg->length);
-    temp_checksum[0] ^= 0xFF;
-    temp_checksum[1] ^= 0xFF;
+#if OPENWSN_6LO_FRAGMENTATION_C
+    // sum the segments of a split packet in turn, a 16-bit word can straddle two segments
+    odd = FALSE;
+    for (segment = msg; segment != NULL; segment = openqueue_getNextSegment(segment)) {
+        ptr = segment->payload;
+        length = packetfunctions_getSegmentLength(segment);
+        if (odd && length > 0) {
+            little_helper[1] = *ptr;
+            sum = openchecksum_sum(sum, little_helper, 2);
+            ptr++;
+            length--;
+            odd = FALSE;
+        }
+        if (length & 0x01) {
+            little_helper[0] = ptr[length - 1];
+            length--;
+            odd = TRUE;
+        }
+        sum = openchecksum_sum(sum, ptr, length);
+    }
+    if (odd) {
+        little_helper[1] = 0;
+        sum = openchecksum_sum(sum, little_helper, 2);
+    }
+#else
+    sum = openchecksum_sum(sum, msg->payload, msg->length);
+#endif
+    checksum = openchecksum_finish(sum);
 
     //write in packet
-    *checksum_ptr = temp_checksum[0];
-    *(checksum_ptr + 1) = temp_checksum[1];
+    *checksum_ptr = (checksum & 0xFF00) >> 8;
+    *(checksum_ptr + 1) = (checksum & 0x00FF);
 }
 
+/**
+\brief Adjust the checksum of a packet after a field it covers was rewritten.
+
+Instead of summing the whole packet again, only the difference between the old
+and the new value of the field is applied to the checksum (RFC1624). The field
+can be part of the packet or of the IPv6 pseudo header, it must start at an
+even offset.
+
+\param[in,out] checksum_ptr Where the checksum is in the packet.
+\param[in] oldData          The value of the field the checksum was computed
+   with.
+\param[in] newData          The new value of the field.
+\param[in] length           The length of the field, in bytes.
+*/
+void packetfunctions_updateChecksum(uint8_t *checksum_ptr, uint8_t *oldData, uint8_t *newData, uint8_t length) {
+    uint16_t checksum;
+
+    checksum = packetfunctions_ntohs(checksum_ptr);
+    checksum = openchecksum_update(checksum, oldData, newData, length);
+    packetfunctions_htons(checksum, checksum_ptr);
+}
 
-void onesComplementSum(uint8_t *global_sum, uint8_t *ptr, int length) {
-    uint32_t sum = 0xFFFF & (global_sum[0] << 8 | global_sum[1]);
-    while (length > 1) {
-        sum += 0xFFFF & (*ptr << 8 | *(ptr + 1));
-        ptr += 2;
-        length -= 2;
-    }
-    if (length) {
-        sum += (0xFF & *ptr) << 8;
-    }
-    while (sum >> 16) {
-        sum = (sum & 0xFFFF) + (sum >> 16);
+/**
+\brief Source address of the IPv6 pseudo header for a given destination.
+
+This is the address packetfunctions_calculateChecksum() puts in the pseudo
+header: the link-local address for a broadcast or multicast destination, the
+global address otherwise.
+*/
+void packetfunctions_getChecksumSource(open_addr_t *destination, open_addr_t *source) {
+    source->type = ADDR_128B;
+    if (packetfunctions_isBroadcastMulticast(destination) == TRUE) {
+        // use link local address for source address (prefix and EUI64)
+        memcpy(&source->addr_128b[0], linklocalprefix, 8);
+        memcpy(&source->addr_128b[8], idmanager_getMyID(ADDR_64B)->addr_64b, 8);
+        // invert 'u' bit (section 2.5.1 at https://www.ietf.org/rfc/rfc2373.txt)
+        source->addr_128b[8] ^= 0x02;
+    } else {
+        memcpy(&source->addr_128b[0], idmanager_getMyID(ADDR_PREFIX)->prefix, 8);
+        memcpy(&source->addr_128b[8], idmanager_getMyID(ADDR_64B)->addr_64b, 8);
     }
-    global_sum[0] = (sum >> 8) & 0xFF;
-    global_sum[1] = sum & 0xFF;
 }
 
 //======= endianness
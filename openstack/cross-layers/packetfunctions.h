@@ -52,6 +52,13 @@ owerror_t packetfunctions_reserveFooter(OpenQueueEntry_t **pkt, uint16_t footer_
 
 void packetfunctions_tossFooter(OpenQueueEntry_t **pkt, uint16_t footer_length);
 
+#if OPENWSN_6LO_FRAGMENTATION_C
+// split packets
+uint16_t packetfunctions_getSegmentLength(OpenQueueEntry_t *pkt);
+
+void packetfunctions_readBytes(OpenQueueEntry_t *pkt, uint16_t offset, uint8_t *dst, uint16_t length);
+#endif
+
 // packet duplication
 void packetfunctions_duplicatePacket(OpenQueueEntry_t *dst, OpenQueueEntry_t *src);
 
@@ -63,6 +70,10 @@ bool packetfunctions_checkCRC(OpenQueueEntry_t *msg);
 // calculate checksum
 void packetfunctions_calculateChecksum(OpenQueueEntry_t *msg, uint8_t *checksum_ptr);
 
+void packetfunctions_updateChecksum(uint8_t *checksum_ptr, uint8_t *oldData, uint8_t *newData, uint8_t length);
+
+void packetfunctions_getChecksumSource(open_addr_t *destination, open_addr_t *source);
+
 // endianness
 void packetfunctions_htons(uint16_t val, uint8_t *dest);
 
@@ -0,0 +1,397 @@
+#include "config.h"
+
+#if OPENWSN_SNAPSHOT_C
+
+#include <stddef.h>
+#include "opendefs.h"
+#include "snapshot.h"
+#include "storage.h"
+#include "openchecksum.h"
+#include "openserial.h"
+#include "scheduler.h"
+#include "idmanager.h"
+#include "IEEE802154E.h"
+#include "IEEE802154_security.h"
+#include "asnfunctions.h"
+#include "neighbors.h"
+#include "icmpv6rpl.h"
+#include "packetfunctions.h"
+
+#if OPENWSN_CJOIN_C
+#include "cjoin.h"
+#endif
+
+//=========================== variables =======================================
+
+snapshot_vars_t snapshot_vars;
+
+//=========================== prototypes ======================================
+
+void snapshot_timer_cb(opentimers_id_t id);
+
+bool snapshot_read(void);
+
+void snapshot_save(void);
+
+bool snapshot_take(void);
+
+void snapshot_fillNeighbor(snapshot_neighbor_t *neighbor, neighborRow_t *row);
+
+void snapshot_restore(void);
+
+void snapshot_discard(uint8_t reason);
+
+void snapshot_getAsn(asn_t *asn);
+
+uint16_t snapshot_crc(void);
+
+//=========================== public ==========================================
+
+/**
+\brief Initialize this module.
+
+Reads the snapshot saved before the reset, if any. Call this function after
+all the other modules of the stack are initialized.
+*/
+void snapshot_init(void) {
+
+    memset(&snapshot_vars, 0, sizeof(snapshot_vars_t));
+
+    // the DAGroot does not join, it has nothing to restore
+    if (idmanager_getIsDAGroot() == FALSE && snapshot_read() == TRUE) {
+        snapshot_vars.state = SNAPSHOT_STATE_PENDING;
+    } else {
+        snapshot_vars.state = SNAPSHOT_STATE_IDLE;
+    }
+
+    snapshot_vars.timerId = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_RPL);
+    opentimers_scheduleIn(
+            snapshot_vars.timerId,
+            SNAPSHOT_CHECK_PERIOD,
+            TIME_MS,
+            TIMER_PERIODIC,
+            snapshot_timer_cb
+    );
+}
+
+/**
+\brief Erase the saved snapshot.
+
+The next reset is followed by a regular join, unless a new snapshot is saved in
+the meantime.
+*/
+void snapshot_erase(void) {
+
+    storage_erase();
+    snapshot_vars.savedCrc = 0;
+    if (snapshot_vars.state == SNAPSHOT_STATE_PENDING) {
+        snapshot_vars.state = SNAPSHOT_STATE_IDLE;
+    }
+}
+
+//=========================== private =========================================
+
+void snapshot_timer_cb(opentimers_id_t id) {
+
+    if (ieee154e_isSynch() == FALSE) {
+        snapshot_vars.numChecks = 0;
+        return;
+    }
+    snapshot_vars.numChecks++;
+
+    switch (snapshot_vars.state) {
+        case SNAPSHOT_STATE_PENDING:
+            snapshot_restore();
+            break;
+        case SNAPSHOT_STATE_IDLE:
+            if (snapshot_vars.numChecks >= SNAPSHOT_SAVE_PERIOD) {
+                snapshot_vars.numChecks = 0;
+                snapshot_save();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+\brief Read the saved snapshot and check that it is complete and ours.
+
+\returns TRUE if the snapshot can be restored, FALSE otherwise.
+*/
+bool snapshot_read(void) {
+    snapshot_image_t *image;
+
+    image = &snapshot_vars.image;
+    if (storage_read((uint8_t *) image, sizeof(snapshot_image_t)) != sizeof(snapshot_image_t)) {
+        return FALSE;
+    }
+    if (
+            image->magic != SNAPSHOT_MAGIC ||
+            image->version != SNAPSHOT_VERSION ||
+            image->numNeighbors == 0 ||
+            image->numNeighbors > SNAPSHOT_MAX_NEIGHBORS ||
+            image->numCells > SNAPSHOT_MAX_CELLS ||
+            image->crc != openchecksum_crc16(0, (uint8_t *) image, offsetof(snapshot_image_t, crc)) ||
+            memcmp(image->eui64, idmanager_getMyID(ADDR_64B)->addr_64b, sizeof(image->eui64)) != 0
+            ) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+\brief Save the snapshot if it changed, or if the saved one gets old.
+
+\pre The mote is synchronized.
+*/
+void snapshot_save(void) {
+    uint16_t crc;
+
+    if (snapshot_take() == FALSE) {
+        return;
+    }
+
+    // the saved snapshot also gets too old to be restored if nothing changes
+    crc = snapshot_crc();
+    if (
+            crc == snapshot_vars.savedCrc &&
+            ieee154e_asnDiff(&snapshot_vars.image.asn) < SNAPSHOT_MAX_AGE / 2
+            ) {
+        return;
+    }
+
+    snapshot_getAsn(&snapshot_vars.image.asn);
+    snapshot_vars.image.crc = openchecksum_crc16(
+            0,
+            (uint8_t *) &snapshot_vars.image,
+            offsetof(snapshot_image_t, crc)
+    );
+    if (storage_write((uint8_t *) &snapshot_vars.image, sizeof(snapshot_image_t)) == E_SUCCESS) {
+        snapshot_vars.savedCrc = crc;
+    }
+}
+
+/**
+\brief Fill in the snapshot from the current state of the stack.
+
+The ASN of the snapshot is left to the one it was last saved at.
+
+\returns TRUE if the mote has a parent and a DODAG to save, FALSE otherwise.
+*/
+bool snapshot_take(void) {
+    snapshot_image_t *image;
+    open_addr_t parent;
+    neighborRow_t row;
+    slotinfo_element_t cell;
+    uint8_t parentIndex;
+    uint8_t i;
+
+    image = &snapshot_vars.image;
+
+    if (
+            icmpv6rpl_getPreferredParentEui64(&parent) == FALSE ||
+            icmpv6rpl_getPreferredParentIndex(&parentIndex) == FALSE
+            ) {
+        return FALSE;
+    }
+    if (icmpv6rpl_getRPLDODAGid(image->dodagid) != E_SUCCESS) {
+        return FALSE;
+    }
+
+    image->magic = SNAPSHOT_MAGIC;
+    image->version = SNAPSHOT_VERSION;
+    memcpy(image->eui64, idmanager_getMyID(ADDR_64B)->addr_64b, sizeof(image->eui64));
+    memcpy(image->parent, parent.addr_64b, sizeof(image->parent));
+    memcpy(image->prefix, idmanager_getMyID(ADDR_PREFIX)->prefix, sizeof(image->prefix));
+
+    // link-layer keys
+#if OPENWSN_CJOIN_C
+    image->isJoined = cjoin_getIsJoined();
+#else
+    image->isJoined = FALSE;
+#endif
+    image->beaconKeyIndex = IEEE802154_security_getBeaconKeyIndex();
+    IEEE802154_security_getBeaconKey(image->beaconKey);
+    image->dataKeyIndex = IEEE802154_security_getDataKeyIndex();
+    IEEE802154_security_getDataKey(image->dataKey);
+
+    // neighbors which advertised a rank, the parent first
+    memset(image->neighbors, 0, sizeof(image->neighbors));
+    neighbors_getNeighborRow(parentIndex, &row);
+    snapshot_fillNeighbor(&image->neighbors[0], &row);
+    image->numNeighbors = 1;
+    for (i = 0; i < MAXNUMNEIGHBORS && image->numNeighbors < SNAPSHOT_MAX_NEIGHBORS; i++) {
+        if (
+                i == parentIndex ||
+                neighbors_getNeighborRow(i, &row) == FALSE ||
+                row.DAGrank == DEFAULTDAGRANK
+                ) {
+            continue;
+        }
+        snapshot_fillNeighbor(&image->neighbors[image->numNeighbors], &row);
+        image->numNeighbors++;
+    }
+
+    // negotiated cells
+    memset(image->cells, 0, sizeof(image->cells));
+    image->numCells = 0;
+    for (i = 0; i < SCHEDULE_NUM_CELLS && image->numCells < SNAPSHOT_MAX_CELLS; i++) {
+        if (schedule_getNegotiatedCell(i, &cell) == FALSE) {
+            continue;
+        }
+        image->cells[image->numCells].slotOffset = cell.slotOffset;
+        image->cells[image->numCells].type = cell.link_type;
+        image->cells[image->numCells].shared = cell.shared;
+        image->cells[image->numCells].channelOffset = cell.channelOffset;
+        memcpy(image->cells[image->numCells].neighbor, cell.address.addr_64b, LENGTH_ADDR64b);
+        image->numCells++;
+    }
+
+    return TRUE;
+}
+
+void snapshot_fillNeighbor(snapshot_neighbor_t *neighbor, neighborRow_t *row) {
+
+    memcpy(neighbor->addr_64b, row->addr_64b.addr_64b, LENGTH_ADDR64b);
+    neighbor->DAGrank = row->DAGrank;
+    neighbor->rssi = row->rssi;
+    neighbor->joinPrio = row->joinPrio;
+    neighbor->sequenceNumber = row->sequenceNumber;
+    neighbor->numTx = row->numTx;
+    neighbor->numTxACK = row->numTxACK;
+    neighbor->numWraps = row->numWraps;
+}
+
+/**
+\brief Restore the snapshot read at boot, once the parent is heard.
+
+The snapshot is discarded if it is too old, or if the parent is not heard within
+SNAPSHOT_PARENT_WAIT seconds after synchronizing.
+
+\pre The mote is synchronized.
+*/
+void snapshot_restore(void) {
+    snapshot_image_t *image;
+    open_addr_t address;
+    neighborRow_t row;
+    asn_t now;
+    uint8_t i;
+
+    image = &snapshot_vars.image;
+
+    if (ieee154e_asnDiff(&image->asn) > SNAPSHOT_MAX_AGE) {
+        snapshot_discard(0);
+        return;
+    }
+
+    // the parent is heard once it is in the neighbor table, which was empty at boot
+    address.type = ADDR_64B;
+    memcpy(address.addr_64b, image->parent, LENGTH_ADDR64b);
+    for (i = 0; i < MAXNUMNEIGHBORS; i++) {
+        if (neighbors_getNeighborRow(i, &row) && packetfunctions_sameAddress(&row.addr_64b, &address)) {
+            break;
+        }
+    }
+    if (i == MAXNUMNEIGHBORS) {
+        if (snapshot_vars.numChecks >= SNAPSHOT_PARENT_WAIT) {
+            snapshot_discard(1);
+        }
+        return;
+    }
+
+    // link-layer keys
+    if (image->beaconKeyIndex != IEEE802154_SECURITY_KEYINDEX_INVALID) {
+        IEEE802154_security_setBeaconKey(image->beaconKeyIndex, image->beaconKey);
+    }
+    if (image->dataKeyIndex != IEEE802154_SECURITY_KEYINDEX_INVALID) {
+        IEEE802154_security_setDataKey(image->dataKeyIndex, image->dataKey);
+    }
+#if OPENWSN_CJOIN_C
+    if (image->isJoined) {
+        cjoin_setIsJoined(TRUE);
+    }
+#endif
+
+    // prefix and DODAG
+    address.type = ADDR_PREFIX;
+    memcpy(address.prefix, image->prefix, sizeof(address.prefix));
+    idmanager_setMyID(&address);
+    icmpv6rpl_writeDODAGid(image->dodagid);
+
+    // neighbors, as if they were just heard
+    snapshot_getAsn(&now);
+    for (i = 0; i < image->numNeighbors; i++) {
+        memset(&row, 0, sizeof(neighborRow_t));
+        row.addr_64b.type = ADDR_64B;
+        memcpy(row.addr_64b.addr_64b, image->neighbors[i].addr_64b, LENGTH_ADDR64b);
+        row.DAGrank = image->neighbors[i].DAGrank;
+        row.rssi = image->neighbors[i].rssi;
+        row.joinPrio = image->neighbors[i].joinPrio;
+        row.sequenceNumber = image->neighbors[i].sequenceNumber;
+        row.numTx = image->neighbors[i].numTx;
+        row.numTxACK = image->neighbors[i].numTxACK;
+        row.numWraps = image->neighbors[i].numWraps;
+        neighbors_restoreNeighborRow(&row, &now);
+    }
+
+    // negotiated cells
+    address.type = ADDR_64B;
+    for (i = 0; i < image->numCells; i++) {
+        memcpy(address.addr_64b, image->cells[i].neighbor, LENGTH_ADDR64b);
+        schedule_addActiveSlot(
+                image->cells[i].slotOffset,
+                (cellType_t) image->cells[i].type,
+                image->cells[i].shared,
+                FALSE,
+                image->cells[i].channelOffset,
+                &address
+        );
+    }
+
+    // select the parent from the restored ranks
+    icmpv6rpl_updateMyDAGrankAndParentSelection();
+
+    snapshot_vars.savedCrc = snapshot_crc();
+    snapshot_vars.state = SNAPSHOT_STATE_IDLE;
+    snapshot_vars.numChecks = 0;
+
+    LOG_SUCCESS(COMPONENT_SNAPSHOT, ERR_SNAPSHOT_RESTORED,
+                (errorparameter_t) image->numCells,
+                (errorparameter_t) image->numNeighbors);
+}
+
+void snapshot_discard(uint8_t reason) {
+
+    snapshot_vars.state = SNAPSHOT_STATE_IDLE;
+    snapshot_vars.numChecks = 0;
+
+    LOG_INFO(COMPONENT_SNAPSHOT, ERR_SNAPSHOT_DISCARDED, (errorparameter_t) reason, (errorparameter_t) 0);
+}
+
+void snapshot_getAsn(asn_t *asn) {
+    uint8_t array[5];
+
+    ieee154e_getAsn(array);
+    asnfunctions_fromArray(asn, array);
+}
+
+/**
+\brief CRC of the snapshot, leaving out the ASN it was saved at.
+
+Used to tell whether the state changed since the snapshot was saved.
+*/
+uint16_t snapshot_crc(void) {
+    uint16_t crc;
+
+    crc = openchecksum_crc16(0, (uint8_t *) &snapshot_vars.image, offsetof(snapshot_image_t, asn));
+    crc = openchecksum_crc16(
+            crc,
+            (uint8_t *) &snapshot_vars.image + offsetof(snapshot_image_t, parent),
+            offsetof(snapshot_image_t, crc) - offsetof(snapshot_image_t, parent)
+    );
+    return crc;
+}
+
+#endif /* OPENWSN_SNAPSHOT_C */
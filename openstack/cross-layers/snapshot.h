@@ -0,0 +1,113 @@
+#ifndef OPENWSN_SNAPSHOT_H
+#define OPENWSN_SNAPSHOT_H
+
+/**
+\addtogroup cross-layers
+\{
+\addtogroup Snapshot
+\{
+
+\brief Persistent snapshot of the state needed to rejoin the network.
+
+The snapshot holds the negotiated cells of the default slotframe, the neighbor
+table, the RPL parent, prefix and DODAGID, and the link-layer keys. It is
+written to the "storage" bsp module every SNAPSHOT_SAVE_PERIOD seconds, if it
+changed. After a reset, once the mote is synchronized, it is restored if it was
+taken less than SNAPSHOT_MAX_AGE slots earlier and the parent is heard within
+SNAPSHOT_PARENT_WAIT seconds. Otherwise, it is discarded and the mote joins as
+usual.
+*/
+
+#include "opendefs.h"
+#include "opentimers.h"
+#include "schedule.h"
+
+//=========================== define ==========================================
+
+#define SNAPSHOT_MAGIC              0x5348  // "SH"
+#define SNAPSHOT_VERSION            1
+
+#ifndef SNAPSHOT_MAX_NEIGHBORS
+#define SNAPSHOT_MAX_NEIGHBORS      8
+#endif
+
+#ifndef SNAPSHOT_MAX_CELLS
+#define SNAPSHOT_MAX_CELLS          NUMSLOTSOFF
+#endif
+
+#define SNAPSHOT_CHECK_PERIOD       1000    // in ms
+
+typedef enum {
+    SNAPSHOT_STATE_IDLE = 0,    // nothing to restore, saving
+    SNAPSHOT_STATE_PENDING,     // a valid snapshot was read, waiting to restore it
+} snapshot_state_t;
+
+//=========================== typedef =========================================
+
+BEGIN_PACK
+typedef struct {
+    uint8_t addr_64b[8];
+    dagrank_t DAGrank;
+    int8_t rssi;
+    uint8_t joinPrio;
+    uint8_t sequenceNumber;
+    uint8_t numTx;
+    uint8_t numTxACK;
+    uint8_t numWraps;
+} snapshot_neighbor_t;
+END_PACK
+
+BEGIN_PACK
+typedef struct {
+    slotOffset_t slotOffset;
+    uint8_t type;
+    bool shared;
+    channelOffset_t channelOffset;
+    uint8_t neighbor[8];
+} snapshot_cell_t;
+END_PACK
+
+BEGIN_PACK
+typedef struct {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t eui64[8];                   // the snapshot is only restored by the mote which took it
+    asn_t asn;                          // when the snapshot was taken
+    uint8_t parent[8];
+    uint8_t prefix[8];
+    uint8_t dodagid[16];
+    bool isJoined;
+    uint8_t beaconKeyIndex;
+    uint8_t beaconKey[16];
+    uint8_t dataKeyIndex;
+    uint8_t dataKey[16];
+    uint8_t numNeighbors;
+    snapshot_neighbor_t neighbors[SNAPSHOT_MAX_NEIGHBORS];  // the parent first
+    uint8_t numCells;
+    snapshot_cell_t cells[SNAPSHOT_MAX_CELLS];
+    uint16_t crc;                       // over all the fields above
+} snapshot_image_t;
+END_PACK
+
+//=========================== module variables ================================
+
+typedef struct {
+    snapshot_image_t image;             // last snapshot read or saved
+    snapshot_state_t state;
+    opentimers_id_t timerId;
+    uint8_t numChecks;                  // number of checks since synchronized, or since saved
+    uint16_t savedCrc;                  // CRC of the saved snapshot, without its ASN
+} snapshot_vars_t;
+
+//=========================== prototypes ======================================
+
+void snapshot_init(void);
+
+void snapshot_erase(void);
+
+/**
+\}
+\}
+*/
+
+#endif /* OPENWSN_SNAPSHOT_H */
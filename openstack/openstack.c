@@ -16,7 +16,9 @@
 #include "openqueue.h"
 #include "openrandom.h"
 #include "opentimers.h"
+#include "snapshot.h"
 //-- 02a-TSCH
+#include "asn_events.h"
 #include "adaptive_sync.h"
 #include "IEEE802154E.h"
 //-- 02b-RES
@@ -64,6 +66,7 @@ void openstack_init(void) {
     openrandom_init();
 
     //-- 02a-TSCH
+    asn_events_init();   // before ieee154e, which dispatches the events
 #if OPENWSN_ADAPTIVE_SYNC_C
     adaptive_sync_init();
 #endif
@@ -103,5 +106,10 @@ void openstack_init(void) {
     //===== applications
     //openapps_init();
 
+    //===== snapshot, once the state it restores is initialized
+#if OPENWSN_SNAPSHOT_C
+    snapshot_init();
+#endif
+
     LOG_SUCCESS(COMPONENT_OPENWSN, ERR_BOOTED, (errorparameter_t) 0, (errorparameter_t) 0);
 }
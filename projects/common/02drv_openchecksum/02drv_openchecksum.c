@@ -0,0 +1,264 @@
+/**
+\brief This is a program which benchmarks the "openchecksum" driver module.
+
+Since the driver modules for different platforms have the same declaration, you
+can use this project with any platform.
+
+For a 16-byte, a 127-byte (one IEEE802.15.4 frame) and a 1280-byte (IPv6
+minimum MTU) buffer, this application measures BENCH_NUM_ROUNDS times:
+- the CRC-16 computed a bit at a time, as packetfunctions used to, and from the
+  lookup table of openchecksum;
+- the UDP checksum of the buffer, i.e. the IPv6 pseudo header followed by the
+  buffer, summed through a 2-byte accumulator folded after every field, as
+  packetfunctions used to, and with the 32-bit accumulator of openchecksum.
+The results of both implementations are compared, the number of differences is
+stored in app_vars.numMismatches.
+
+On real hardware, timestamps are read from the sctimer and averaged over the
+rounds, as in 02drv_scheduler. On the python board, the host's monotonic clock
+is used instead, and the results are printed on the console.
+
+When done, the error LED turns on. The results are stored in app_vars.
+*/
+
+#include "stdint.h"
+#include "stdio.h"
+#include "string.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+#include "sctimer.h"
+// driver modules required
+#include "openchecksum.h"
+
+#ifdef PYTHON_BOARD
+#include <time.h>
+#endif
+
+//=========================== defines =========================================
+
+#define BENCH_NUM_ROUNDS       1000
+#define BENCH_NUM_SIZES        3
+#define BENCH_BUFFER_LEN       1280
+
+static const uint16_t bench_sizes[BENCH_NUM_SIZES] = {16, 127, 1280};
+
+//=========================== variables =======================================
+
+typedef struct {
+    uint16_t length;
+    uint32_t crcBitwiseTotal;   // sum of the durations, in timestamp units
+    uint32_t crcTableTotal;
+    uint32_t sumLegacyTotal;
+    uint32_t sumTotal;
+} bench_result_t;
+
+typedef struct {
+    bench_result_t result[BENCH_NUM_SIZES];
+    uint8_t        buffer[BENCH_BUFFER_LEN];
+    uint8_t        source[16];
+    uint8_t        destination[16];
+    uint16_t       numMismatches;
+} app_vars_t;
+
+app_vars_t app_vars;
+
+//=========================== prototypes ======================================
+
+uint32_t bench_now(void);
+void     bench_run(uint8_t size);
+uint16_t bench_crcBitwise(uint8_t *ptr, uint16_t length);
+uint16_t bench_checksumLegacy(uint8_t *ptr, uint16_t length);
+uint16_t bench_checksum(uint8_t *ptr, uint16_t length);
+void     bench_onesComplementSum(uint8_t *global_sum, uint8_t *ptr, int length);
+
+//=========================== main ============================================
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main(void) {
+    uint16_t i;
+    uint8_t  size;
+
+    memset(&app_vars,0,sizeof(app_vars_t));
+
+    board_init();
+
+    // arbitrary but reproducible content
+    for (i=0;i<BENCH_BUFFER_LEN;i++) {
+        app_vars.buffer[i] = (uint8_t)(i*37+11);
+    }
+    for (i=0;i<16;i++) {
+        app_vars.source[i]      = (uint8_t)(0xbb+i);
+        app_vars.destination[i] = (uint8_t)(0x20+i*3);
+    }
+
+    for (size=0;size<BENCH_NUM_SIZES;size++) {
+        bench_run(size);
+    }
+
+#ifdef PYTHON_BOARD
+    printf("length crc-bit(ns) crc-table(ns) sum-legacy(ns) sum(ns)\n");
+    for (size=0;size<BENCH_NUM_SIZES;size++) {
+        printf(
+            "%6d %11d %13d %14d %7d\n",
+            app_vars.result[size].length,
+            (int)(app_vars.result[size].crcBitwiseTotal/BENCH_NUM_ROUNDS),
+            (int)(app_vars.result[size].crcTableTotal/BENCH_NUM_ROUNDS),
+            (int)(app_vars.result[size].sumLegacyTotal/BENCH_NUM_ROUNDS),
+            (int)(app_vars.result[size].sumTotal/BENCH_NUM_ROUNDS)
+        );
+    }
+    printf("mismatches: %d\n",app_vars.numMismatches);
+#endif
+
+    leds_error_on();
+
+    while(1) {
+        board_sleep();
+    }
+}
+
+//=========================== private =========================================
+
+/**
+\brief Measure both implementations over a buffer of a given length.
+*/
+void bench_run(uint8_t size) {
+    uint16_t length;
+    uint16_t round;
+    uint16_t reference;
+    uint16_t result;
+    uint32_t t0;
+    uint32_t t1;
+    uint32_t t2;
+
+    length = bench_sizes[size];
+
+    for (round=0;round<BENCH_NUM_ROUNDS;round++) {
+        // CRC-16
+        t0 = bench_now();
+        reference = bench_crcBitwise(app_vars.buffer,length);
+        t1 = bench_now();
+        result = openchecksum_crc16(0,app_vars.buffer,length);
+        t2 = bench_now();
+
+        app_vars.result[size].crcBitwiseTotal += t1-t0;
+        app_vars.result[size].crcTableTotal   += t2-t1;
+        if (result!=reference) {
+            app_vars.numMismatches++;
+        }
+
+        // UDP checksum
+        t0 = bench_now();
+        reference = bench_checksumLegacy(app_vars.buffer,length);
+        t1 = bench_now();
+        result = bench_checksum(app_vars.buffer,length);
+        t2 = bench_now();
+
+        app_vars.result[size].sumLegacyTotal += t1-t0;
+        app_vars.result[size].sumTotal       += t2-t1;
+        if (result!=reference) {
+            app_vars.numMismatches++;
+        }
+    }
+    app_vars.result[size].length = length;
+}
+
+/**
+\brief CRC-16 computed a bit at a time.
+
+This is how packetfunctions computed the CRC before it used openchecksum.
+*/
+uint16_t bench_crcBitwise(uint8_t *ptr, uint16_t length) {
+    uint16_t crc;
+    uint16_t count;
+    uint8_t  i;
+
+    crc = 0;
+    for (count=0;count<length;count++) {
+        crc = crc ^ ptr[count];
+        for (i=0;i<8;i++) {
+            if (crc & 0x1) {
+                crc = crc >> 1 ^ 0x8408;
+            } else {
+                crc = crc >> 1;
+            }
+        }
+    }
+    return crc;
+}
+
+/**
+\brief UDP checksum over a 2-byte accumulator, folded after every field.
+
+This is how packetfunctions computed the checksum before it used openchecksum.
+*/
+uint16_t bench_checksumLegacy(uint8_t *ptr, uint16_t length) {
+    uint8_t temp_checksum[2];
+    uint8_t little_helper[2];
+
+    temp_checksum[0] = 0;
+    temp_checksum[1] = 0;
+
+    bench_onesComplementSum(temp_checksum,&app_vars.source[0],8);
+    bench_onesComplementSum(temp_checksum,&app_vars.source[8],8);
+    bench_onesComplementSum(temp_checksum,app_vars.destination,16);
+
+    little_helper[0] = (length & 0xFF00) >> 8;
+    little_helper[1] = (length & 0x00FF);
+    bench_onesComplementSum(temp_checksum,little_helper,2);
+
+    little_helper[0] = 0;
+    little_helper[1] = IANA_UDP;
+    bench_onesComplementSum(temp_checksum,little_helper,2);
+
+    bench_onesComplementSum(temp_checksum,ptr,length);
+
+    return (uint16_t)(~((temp_checksum[0] << 8) | temp_checksum[1]));
+}
+
+void bench_onesComplementSum(uint8_t *global_sum, uint8_t *ptr, int length) {
+    uint32_t sum = 0xFFFF & (global_sum[0] << 8 | global_sum[1]);
+    while (length > 1) {
+        sum += 0xFFFF & (*ptr << 8 | *(ptr + 1));
+        ptr += 2;
+        length -= 2;
+    }
+    if (length) {
+        sum += (0xFF & *ptr) << 8;
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    global_sum[0] = (sum >> 8) & 0xFF;
+    global_sum[1] = sum & 0xFF;
+}
+
+/**
+\brief UDP checksum over the 32-bit accumulator of openchecksum.
+*/
+uint16_t bench_checksum(uint8_t *ptr, uint16_t length) {
+    uint32_t sum;
+
+    sum  = openchecksum_sum(0,&app_vars.source[0],8);
+    sum  = openchecksum_sum(sum,&app_vars.source[8],8);
+    sum  = openchecksum_sum(sum,app_vars.destination,16);
+    sum += length;
+    sum += IANA_UDP;
+    sum  = openchecksum_sum(sum,ptr,length);
+
+    return openchecksum_finish(sum);
+}
+
+uint32_t bench_now(void) {
+#ifdef PYTHON_BOARD
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint32_t)(ts.tv_sec*1000000000UL+ts.tv_nsec);
+#else
+    return sctimer_readCounter();
+#endif
+}
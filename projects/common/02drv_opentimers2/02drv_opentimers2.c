@@ -1,50 +1,82 @@
 /**
-\brief This is a program which shows how to use the "opentimers" driver module.
+\brief This is a program which benchmarks the interrupt handler of the
+"opentimers" driver module.
 
 Since the driver modules for different platforms have the same declaration, you
 can use this project with any platform.
 
-This application allows you to verify the correct functioning of the opentimers
-drivers. It starts 3 periodic timers, with periods APP_DLY_TIMER0_ticks,
-APP_DLY_TIMER1_ticks and APP_DLY_TIMER2_ticks. Each timer is attached an LED
-(error, radio, sync, resp/).
-
-When you run the application, you should see the LEDs blinking.
-
-\author Tengfei Chang <tengfei.chang@inria.fr>, April 2017.
-\author Thomas Watteyne <thomas.watteyne@inria.fr>, July 2017.
+For 5, 15 and 64 running timers, this application starts that many periodic
+timers with different periods, then calls the opentimers interrupt handler
+BENCH_NUM_ROUNDS times. Each call fires the earliest timer, reschedules it and
+selects the next one, so the number of running timers stays constant. For
+comparison, it also measures the linear scan over all timers the driver used
+to select the next timer, which ran twice per interrupt. This is a selection
+only comparison: the scan is timed alone, not the rest of the old interrupt
+handler.
+
+A size runs with at most as many timers as the opentimers pool has free, so
+with the default pool the larger sizes run with fewer timers; numTimers holds
+the count actually used. Build with stackcfg=timers:64 to raise the pool
+(OPENTIMERS_NUM_EXTRA) so that every size runs in full.
+
+On real hardware, timestamps are read from the sctimer and averaged over the
+rounds, as in 02drv_scheduler. On the python board, the host's monotonic clock
+is used instead, and the results are printed on the console.
+
+When done, the error LED turns on. The results are stored in app_vars.
 */
 
 #include "stdint.h"
 #include "stdio.h"
+#include "string.h"
 // bsp modules required
 #include "board.h"
 #include "leds.h"
 #include "sctimer.h"
 // driver modules required
 #include "opentimers.h"
+// kernel modules required
+#include "scheduler.h"
+
+#ifdef PYTHON_BOARD
+#include <time.h>
+#endif
 
 //=========================== defines =========================================
 
-#define APP_DLY_TIMER0_ticks   16384    // half second @ 32kHz
-#define APP_DLY_TIMER1_ticks   16384    // a little bit more than half second @ 32kHz
-#define APP_DLY_TIMER2_ticks   32768    // one  second @ 32kHz
+#define BENCH_NUM_ROUNDS       1000
+#define BENCH_NUM_SIZES        3
+#define BENCH_PERIOD_BASE      16384    // half second @ 32kHz
+#define BENCH_PERIOD_STEP      37       // ticks between the periods of two timers
+
+static const uint8_t bench_sizes[BENCH_NUM_SIZES] = {5, 15, 64};
 
 //=========================== variables =======================================
 
 typedef struct {
-    opentimers_id_t timer0;
-    opentimers_id_t timer1;
-    opentimers_id_t timer2;
+    uint8_t  numTimers;     // running timers, bench_sizes capped to the free timers
+    uint32_t isrTotal;      // sum of the interrupt handler durations, in timestamp units
+    uint32_t selectTotal;   // sum of the linear selection durations, in timestamp units
+} bench_result_t;
+
+typedef struct {
+    bench_result_t result[BENCH_NUM_SIZES];
+    uint32_t       numTimersFired;
 } app_vars_t;
 
 app_vars_t app_vars;
 
+extern opentimers_vars_t opentimers_vars;
+
 //=========================== prototypes ======================================
 
-void cb_timer0(opentimers_id_t id);
-void cb_timer1(opentimers_id_t id);
-void cb_timer2(opentimers_id_t id);
+// interrupt handler of the opentimers driver
+void            opentimers_timer_callback(void);
+
+void            bench_timer_cb(opentimers_id_t id);
+uint32_t        bench_now(void);
+void            bench_run(uint8_t size);
+opentimers_id_t bench_linearNext(void);
 
 //=========================== main ============================================
 
@@ -52,54 +84,145 @@ void cb_timer2(opentimers_id_t id);
 \brief The program starts executing here.
 */
 int mote_main(void) {
-    
+    uint8_t size;
+
     memset(&app_vars,0,sizeof(app_vars_t));
-    
+
     board_init();
-    opentimers_init();
-   
-    app_vars.timer0 = opentimers_create();
-    opentimers_scheduleIn(
-        app_vars.timer0,          // timerId
-        APP_DLY_TIMER0_ticks,     // duration
-        TIME_TICS,                // timetype
-        TIMER_PERIODIC,           // timertype
-        cb_timer0                 // callback
-    );
-   
-    app_vars.timer1 = opentimers_create();
-    opentimers_scheduleIn(
-        app_vars.timer1,          // timerId
-        APP_DLY_TIMER0_ticks,     // duration
-        TIME_TICS,                // timetype
-        TIMER_PERIODIC,           // timertype
-        cb_timer1                 // callback
-    );
-   
-    app_vars.timer2 = opentimers_create();
-    opentimers_scheduleIn(
-        app_vars.timer2,          // timerId
-        APP_DLY_TIMER0_ticks,     // duration
-        TIME_TICS,                // timetype
-        TIMER_PERIODIC,           // timertype
-        cb_timer2                 // callback
-    );
-    
+
+    for (size=0;size<BENCH_NUM_SIZES;size++) {
+        bench_run(size);
+    }
+
+#ifdef PYTHON_BOARD
+    printf("  size timers isr(ns) select(ns)\n");
+    for (size=0;size<BENCH_NUM_SIZES;size++) {
+        printf(
+            "%6d %6d %7d %10d\n",
+            bench_sizes[size],
+            app_vars.result[size].numTimers,
+            (int)(app_vars.result[size].isrTotal/BENCH_NUM_ROUNDS),
+            (int)(app_vars.result[size].selectTotal/BENCH_NUM_ROUNDS)
+        );
+    }
+#endif
+
+    leds_error_on();
+
     while(1) {
         board_sleep();
     }
 }
 
-//=========================== callbacks =======================================
+//=========================== private =========================================
 
-void cb_timer0(opentimers_id_t id) {
-    leds_error_toggle();
+/**
+\brief Measure the interrupt handler with a given number of running timers.
+*/
+void bench_run(uint8_t size) {
+    uint8_t            numTimers;
+    uint8_t            i;
+    uint16_t           round;
+    opentimers_id_t    id;
+    uint32_t           t0;
+    uint32_t           t1;
+    uint32_t           t2;
+    opentimers_stats_t stats;
+
+    INTERRUPT_DECLARATION();
+
+    scheduler_init();
+    opentimers_init();
+
+    // run with as many timers as the pool can hold
+    opentimers_getStats(&stats);
+    numTimers = bench_sizes[size];
+    if (numTimers>stats.poolSize-stats.numUsed-stats.numReservedLeft) {
+        numTimers = stats.poolSize-stats.numUsed-stats.numReservedLeft;
+    }
+
+    for (i=0;i<numTimers;i++) {
+        id = opentimers_create(TIMER_GENERAL_PURPOSE,TASKPRIO_OPENTIMERS);
+        opentimers_scheduleIn(
+            id,                                     // timerId
+            BENCH_PERIOD_BASE+i*BENCH_PERIOD_STEP,  // duration
+            TIME_TICS,                              // timetype
+            TIMER_PERIODIC,                         // timertype
+            bench_timer_cb                          // callback
+        );
+    }
+
+    for (round=0;round<BENCH_NUM_ROUNDS;round++) {
+        // the hardware timer must not fire while the handler is called here
+        DISABLE_INTERRUPTS();
+        t0 = bench_now();
+        opentimers_timer_callback();
+        t1 = bench_now();
+        bench_linearNext();
+        t2 = bench_now();
+        ENABLE_INTERRUPTS();
+
+        app_vars.result[size].isrTotal    += t1-t0;
+        app_vars.result[size].selectTotal += t2-t1;
+
+        // drop the task pushed by the expired timer
+        while (scheduler_pop_task()!=NULL) {
+            app_vars.numTimersFired++;
+        }
+    }
+    app_vars.result[size].numTimers = numTimers;
+
+    for (id=0;id<MAX_NUM_TIMERS;id++) {
+        opentimers_destroy(id);
+    }
+}
+
+/**
+\brief Select the next timer to fire by scanning all the timers.
+
+This is the selection the interrupt handler used before the running timers
+were kept in a heap. Only this loop is reproduced; the old handler ran it twice
+per interrupt, around the firing of the expired timers.
+*/
+opentimers_id_t bench_linearNext(void) {
+    uint8_t          i;
+    uint8_t          idToSchedule;
+    PORT_TIMER_WIDTH timerGap;
+    PORT_TIMER_WIDTH tempTimerGap;
+
+    i = 0;
+    while (i<MAX_NUM_TIMERS && opentimers_vars.timersBuf[i].isrunning==FALSE){
+        i++;
+    }
+    if (i==MAX_NUM_TIMERS) {
+        return ERROR_NO_AVAILABLE_ENTRIES;
+    }
+    timerGap     = (opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+    idToSchedule = i;
+    for (i=idToSchedule+1;i<MAX_NUM_TIMERS;i++){
+        if (opentimers_vars.timersBuf[i].isrunning){
+            tempTimerGap = (opentimers_vars.timersBuf[i].currentCompareValue-opentimers_vars.lastCompareValue) & MAX_TICKS_IN_SINGLE_CLOCK;
+            if (tempTimerGap < timerGap){
+                timerGap     = tempTimerGap;
+                idToSchedule = i;
+            }
+        }
+    }
+    return idToSchedule;
 }
 
-void cb_timer1(opentimers_id_t id) {
-    leds_radio_toggle();
+uint32_t bench_now(void) {
+#ifdef PYTHON_BOARD
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint32_t)(ts.tv_sec*1000000000UL+ts.tv_nsec);
+#else
+    return sctimer_readCounter();
+#endif
 }
 
-void cb_timer2(opentimers_id_t id) {
-    leds_sync_toggle();
-}
\ No newline at end of file
+//=========================== callbacks =======================================
+
+void bench_timer_cb(opentimers_id_t id) {
+}
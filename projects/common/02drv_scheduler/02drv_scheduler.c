@@ -0,0 +1,147 @@
+/**
+\brief This is a program which benchmarks the "scheduler" kernel module.
+
+Since the kernel modules for different platforms have the same declaration, you
+can use this project with any platform.
+
+For each queue depth between 0 and TASK_LIST_DEPTH-1, this application fills
+the scheduler with that many tasks of mixed priorities, then measures
+BENCH_NUM_ROUNDS times how long it takes to push one more task and to pop the
+highest priority one. The queue depth hence stays constant during the
+measurement.
+
+On real hardware, timestamps are read from the sctimer. A single push or pop
+is much shorter than a 32kHz tick, but since the operations are not aligned with
+the timer, the sum of the measured tick differences divided by the number of
+rounds converges to the average duration of the operation. On the python
+board, the sctimer is driven by the simulator and does not advance while the C
+code executes, so the host's monotonic clock is used instead, and the results
+are printed on the console.
+
+When done, the error LED turns on. The results are stored in app_vars.
+*/
+
+#include "stdint.h"
+#include "stdio.h"
+#include "string.h"
+// bsp modules required
+#include "board.h"
+#include "leds.h"
+#include "sctimer.h"
+// kernel modules required
+#include "scheduler.h"
+
+#ifdef PYTHON_BOARD
+#include <time.h>
+#endif
+
+//=========================== defines =========================================
+
+#define BENCH_NUM_ROUNDS   1000
+#define BENCH_TASK_PRIO    TASKPRIO_RPL
+
+//=========================== variables =======================================
+
+typedef struct {
+    uint32_t pushTotal;     // sum of the push durations, in timestamp units
+    uint32_t popTotal;      // sum of the pop durations, in timestamp units
+} bench_result_t;
+
+typedef struct {
+    bench_result_t result[TASK_LIST_DEPTH];
+    uint32_t       numTasksExecuted;
+} app_vars_t;
+
+app_vars_t app_vars;
+
+//=========================== prototypes ======================================
+
+void     bench_task_cb(void);
+uint32_t bench_now(void);
+void     bench_run(uint8_t depth);
+
+//=========================== main ============================================
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main(void) {
+    uint8_t depth;
+
+    memset(&app_vars,0,sizeof(app_vars_t));
+
+    board_init();
+
+    for (depth=0;depth<TASK_LIST_DEPTH;depth++) {
+        bench_run(depth);
+    }
+
+#ifdef PYTHON_BOARD
+    printf("depth push(ns) pop(ns)\n");
+    for (depth=0;depth<TASK_LIST_DEPTH;depth++) {
+        printf(
+            "%5d %8d %7d\n",
+            depth,
+            (int)(app_vars.result[depth].pushTotal/BENCH_NUM_ROUNDS),
+            (int)(app_vars.result[depth].popTotal/BENCH_NUM_ROUNDS)
+        );
+    }
+#endif
+
+    leds_error_on();
+
+    while(1) {
+        board_sleep();
+    }
+}
+
+//=========================== private =========================================
+
+/**
+\brief Measure push and pop at a constant queue depth.
+*/
+void bench_run(uint8_t depth) {
+    uint8_t  i;
+    uint16_t round;
+    uint32_t t0;
+    uint32_t t1;
+    uint32_t t2;
+
+    scheduler_init();
+
+    // fill the queue, spreading tasks over all priorities
+    for (i=0;i<depth;i++) {
+        scheduler_push_task(bench_task_cb,(task_prio_t)(TASKPRIO_SIXTOP_NOTIF_RX+i%(TASKPRIO_MAX-1)));
+    }
+
+    for (round=0;round<BENCH_NUM_ROUNDS;round++) {
+        t0 = bench_now();
+        scheduler_push_task(bench_task_cb,BENCH_TASK_PRIO);
+        t1 = bench_now();
+        scheduler_pop_task();
+        t2 = bench_now();
+
+        app_vars.result[depth].pushTotal += t1-t0;
+        app_vars.result[depth].popTotal  += t2-t1;
+    }
+
+    // empty the queue
+    while (scheduler_pop_task()!=NULL);
+}
+
+uint32_t bench_now(void) {
+#ifdef PYTHON_BOARD
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint32_t)(ts.tv_sec*1000000000UL+ts.tv_nsec);
+#else
+    return sctimer_readCounter();
+#endif
+}
+
+//=========================== callbacks =======================================
+
+void bench_task_cb(void) {
+    app_vars.numTasksExecuted++;
+}
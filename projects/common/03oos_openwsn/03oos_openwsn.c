@@ -7,13 +7,47 @@
 #include "config.h"
 #include "board.h"
 #include "scheduler.h"
+#include "opentimers.h"
 #include "openstack.h"
 #include "opendefs.h"
+#include "IEEE802154E.h"
+#include "asn_events.h"
+#include "asnfunctions.h"
 
 #include "cf_crazyflie.h"
+#include "cf_syslink.h"
+#include "cf_api_commander_high_level.h"
+#include "cf_movement_queue.h"
+
+//=========================== defines =========================================
+
+// the flight, in slots from CRAZYFLIE_FLIGHT_START_ASN
+#define CRAZYFLIE_FLIGHT_START_ASN    0x0800
+#define CRAZYFLIE_FLIGHT_TAKEOFF      50
+#define CRAZYFLIE_FLIGHT_MOVE         52    // the movement queue counts slots from here
+#define CRAZYFLIE_FLIGHT_STOP         600
+
+//=========================== variables =======================================
+
+static asn_events_id_t crazyflieMoveEventId;
+
+//=========================== prototypes ======================================
+
+void crazyflie_syslinkRx_cb(void);
+void crazyflie_syslink_task_cb(void);
+void crazyflie_timer_cb(opentimers_id_t id);
+void crazyflie_flight_schedule(void);
+void crazyflie_flight_getAsn(asn_t *asn, uint32_t numSlots);
+void crazyflie_flight_enable_cb(void);
+void crazyflie_flight_takeoff_cb(void);
+void crazyflie_flight_move_cb(void);
+void crazyflie_flight_stop_cb(void);
+
+//=========================== main ============================================
 
 int mote_main(void) {
-   
+   opentimers_id_t crazyflieTimerId;
+
    // initialize
    board_init();
    // crazyflie
@@ -22,8 +56,108 @@ int mote_main(void) {
    scheduler_init();
    openstack_init();
 
+   // crazyflie: syslink frames are processed when the UART has received them,
+   // the keepalive and power management run from a periodic timer
+   crazyflieSetSyslinkRxCb(crazyflie_syslinkRx_cb);
+   crazyflieTimerId = opentimers_create(TIMER_GENERAL_PURPOSE, TASKPRIO_CRAZYFLIE);
+   opentimers_scheduleIn(
+       crazyflieTimerId,
+       SYSLINK_SEND_PERIOD_MS,
+       TIME_MS,
+       TIMER_PERIODIC,
+       crazyflie_timer_cb
+   );
+
+   // crazyflie: the flight is triggered by the ASN, the same for the swarm
+   crazyflie_flight_schedule();
+
    // start
    scheduler_start();
    return 0; // this line should never be reached
 }
 
+//=========================== callbacks =======================================
+
+/**
+\brief Called from the UART interrupt when a complete syslink frame is queued.
+*/
+void crazyflie_syslinkRx_cb(void) {
+   // a single pending task drains all the frames received in the meantime
+   scheduler_push_task_coalesce(crazyflie_syslink_task_cb, TASKPRIO_CRAZYFLIE);
+}
+
+void crazyflie_syslink_task_cb(void) {
+   crazyflieSyslinkHandle();
+}
+
+void crazyflie_timer_cb(opentimers_id_t id) {
+   // also drain syslink, in case a frame arrived while the task list was full
+   crazyflieSyslinkHandle();
+   crazyfliePeriodicHandle();
+}
+
+//=========================== flight ==========================================
+
+/**
+\brief Register the steps of the flight as ASN events.
+
+The drone is enabled at CRAZYFLIE_FLIGHT_START_ASN, takes off
+CRAZYFLIE_FLIGHT_TAKEOFF slots later, then follows the movement queue at every
+slot from CRAZYFLIE_FLIGHT_MOVE until it stops CRAZYFLIE_FLIGHT_STOP slots
+after the start.
+*/
+void crazyflie_flight_schedule(void) {
+   asn_t asn;
+
+   crazyflie_flight_getAsn(&asn, 0);
+   asn_events_schedule(&asn, 0, crazyflie_flight_enable_cb, TASKPRIO_CRAZYFLIE);
+
+   crazyflie_flight_getAsn(&asn, CRAZYFLIE_FLIGHT_TAKEOFF);
+   asn_events_schedule(&asn, 0, crazyflie_flight_takeoff_cb, TASKPRIO_CRAZYFLIE);
+
+   crazyflie_flight_getAsn(&asn, CRAZYFLIE_FLIGHT_MOVE + 1);
+   crazyflieMoveEventId = asn_events_schedule(&asn, 1, crazyflie_flight_move_cb, TASKPRIO_CRAZYFLIE);
+
+   crazyflie_flight_getAsn(&asn, CRAZYFLIE_FLIGHT_STOP);
+   asn_events_schedule(&asn, 0, crazyflie_flight_stop_cb, TASKPRIO_CRAZYFLIE);
+}
+
+/**
+\brief The ASN of a step of the flight.
+
+\param[out] asn      Where to write the ASN.
+\param[in]  numSlots Number of slots after CRAZYFLIE_FLIGHT_START_ASN.
+*/
+void crazyflie_flight_getAsn(asn_t *asn, uint32_t numSlots) {
+   memset(asn, 0, sizeof(asn_t));
+   asnfunctions_add(asn, CRAZYFLIE_FLIGHT_START_ASN + numSlots);
+}
+
+void crazyflie_flight_enable_cb(void) {
+   high_level_enable();
+}
+
+void crazyflie_flight_takeoff_cb(void) {
+   high_level_takeoff(0.7, 1.0, 0.0);
+}
+
+void crazyflie_flight_move_cb(void) {
+   uint8_t array[5];
+   asn_t now;
+   asn_t start;
+   int32_t elapsed;
+
+   ieee154e_getAsn(array);
+   asnfunctions_fromArray(&now, array);
+   crazyflie_flight_getAsn(&start, CRAZYFLIE_FLIGHT_MOVE);
+   elapsed = asnfunctions_diff(&now, &start);
+   if (elapsed > 0) {
+      cf_movement_queue_handle((uint32_t) elapsed);
+   }
+}
+
+void crazyflie_flight_stop_cb(void) {
+   asn_events_cancel(crazyflieMoveEventId);
+   crazyflieEmergencyStop();
+   crazyflieShutdown();
+}
@@ -0,0 +1,307 @@
+/**
+\brief This program tests the "snapshot" cross-layer module.
+
+It runs the stack without a network and drives the snapshot through three
+scenarios, resetting the stack by initializing it again. The storage keeps its
+content across those resets, as it does across resets of the board:
+- save, reset and restore: a snapshot of the parent, the DODAG and a negotiated
+  cell is saved, then restored once the parent is heard after the reset.
+- too old: a snapshot read more than SNAPSHOT_MAX_AGE slots after it was saved
+  is discarded, even if the parent is heard.
+- parent not heard: a snapshot is discarded when the parent is not heard within
+  SNAPSHOT_PARENT_WAIT checks after synchronizing.
+
+The snapshot is only available on the python board, build with
+"board=python modules=snapshot". Use projects/python/test_snapshot.py to run
+it. Each check is printed on the console; the error LED turns on if any check
+fails.
+*/
+
+#include "config.h"
+#include "opendefs.h"
+#include "board.h"
+#include "leds.h"
+#include "scheduler.h"
+#include "opentimers.h"
+#include "openstack.h"
+#include "IEEE802154E.h"
+#include "asnfunctions.h"
+#include "schedule.h"
+#include "neighbors.h"
+#include "icmpv6rpl.h"
+#include "packetfunctions.h"
+#include "snapshot.h"
+
+#if OPENWSN_SNAPSHOT_C
+#include "storage.h"
+#endif
+
+//=========================== defines =========================================
+
+#define TEST_ASN_START         0x010000 // ASN the mote synchronizes at, in the first life
+#define TEST_ASN_LATER         200      // slots between the save and the next synchronization
+#define TEST_PARENT            0x10     // first byte of the EUI64 of the parent
+#define TEST_PARENT_RANK       256
+#define TEST_SLOTOFFSET        20
+#define TEST_CHANNELOFFSET     6
+#define TEST_DODAGID           0xbb     // first byte of the DODAGID
+
+//=========================== variables =======================================
+
+typedef struct {
+    uint8_t numPassed;
+    uint8_t numFailed;
+} app_vars_t;
+
+app_vars_t app_vars;
+
+extern ieee154e_vars_t ieee154e_vars;
+extern snapshot_vars_t snapshot_vars;
+
+//=========================== prototypes ======================================
+
+// the periodic check of the snapshot module
+void snapshot_timer_cb(opentimers_id_t id);
+
+void test_saveResetRestore(void);
+void test_tooOld(void);
+void test_parentNotHeard(void);
+void test_reset(void);
+void test_sync(uint32_t asn);
+void test_tick(uint8_t numChecks);
+void test_hear(void);
+void test_getParent(open_addr_t *address);
+bool test_hasCell(void);
+bool test_hasState(void);
+void test_check(bool passed, const char *name);
+
+//=========================== main ============================================
+
+/**
+\brief The program starts executing here.
+*/
+int mote_main(void) {
+
+    memset(&app_vars,0,sizeof(app_vars_t));
+
+    board_init();
+
+#if OPENWSN_SNAPSHOT_C
+    storage_erase();
+    test_saveResetRestore();
+    test_tooOld();
+    test_parentNotHeard();
+    storage_erase();
+#endif
+
+#ifdef PYTHON_BOARD
+#if OPENWSN_SNAPSHOT_C
+    printf("%d passed, %d failed\n",app_vars.numPassed,app_vars.numFailed);
+#else
+    printf("snapshot not built, build with modules=snapshot\n");
+#endif
+#endif
+
+    if (app_vars.numFailed>0) {
+        leds_error_on();
+    }
+
+    while(1) {
+        board_sleep();
+    }
+}
+
+//=========================== private =========================================
+
+#if OPENWSN_SNAPSHOT_C
+
+/**
+\brief Save a snapshot, reset, and restore it once the parent is heard.
+*/
+void test_saveResetRestore(void) {
+    open_addr_t   parent;
+    neighborRow_t row;
+    uint8_t       dodagid[16];
+
+    // first life: join, then let the snapshot be saved
+    test_reset();
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_IDLE, "nothing to restore at first boot");
+    test_sync(TEST_ASN_START);
+
+    test_getParent(&parent);
+    memset(&row,0,sizeof(neighborRow_t));
+    memcpy(&row.addr_64b,&parent,sizeof(open_addr_t));
+    row.DAGrank = TEST_PARENT_RANK;
+    neighbors_restoreNeighborRow(&row,&ieee154e_vars.asn);
+
+    memset(dodagid,0,sizeof(dodagid));
+    dodagid[0] = TEST_DODAGID;
+    icmpv6rpl_writeDODAGid(dodagid);
+    icmpv6rpl_updateMyDAGrankAndParentSelection();
+
+    schedule_addActiveSlot(
+        TEST_SLOTOFFSET,        // slot offset
+        CELLTYPE_TX,            // type of slot
+        FALSE,                  // shared?
+        FALSE,                  // auto cell?
+        TEST_CHANNELOFFSET,     // channel offset
+        &parent                 // neighbor
+    );
+    test_check(test_hasState(), "parent, DODAG and cell set up");
+
+    test_tick(SNAPSHOT_SAVE_PERIOD);
+    test_check(snapshot_vars.savedCrc!=0, "snapshot saved");
+
+    // second life: the snapshot waits for the parent
+    test_reset();
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_PENDING, "snapshot read after reset");
+    test_check(test_hasState()==FALSE, "state lost by the reset");
+
+    test_sync(TEST_ASN_START+TEST_ASN_LATER);
+    test_tick(1);
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_PENDING, "restore waits for the parent");
+
+    test_hear();
+    test_tick(1);
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_IDLE, "snapshot used once the parent is heard");
+    test_check(test_hasState(), "parent, DODAG and cell restored");
+}
+
+/**
+\brief Discard a snapshot which is too old, even if the parent is heard.
+
+\pre test_saveResetRestore() saved a snapshot at TEST_ASN_START.
+*/
+void test_tooOld(void) {
+
+    test_reset();
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_PENDING, "too old: snapshot read after reset");
+
+    test_sync(TEST_ASN_START+SNAPSHOT_MAX_AGE+1);
+    test_hear();
+    test_tick(1);
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_IDLE, "too old: snapshot discarded");
+    test_check(test_hasCell()==FALSE, "too old: cell not restored");
+}
+
+/**
+\brief Discard a snapshot when the parent is not heard in time.
+
+\pre test_saveResetRestore() saved a snapshot at TEST_ASN_START.
+*/
+void test_parentNotHeard(void) {
+
+    test_reset();
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_PENDING, "no parent: snapshot read after reset");
+
+    test_sync(TEST_ASN_START+TEST_ASN_LATER);
+    test_tick(SNAPSHOT_PARENT_WAIT-1);
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_PENDING, "no parent: still waiting");
+
+    test_tick(1);
+    test_check(snapshot_vars.state==SNAPSHOT_STATE_IDLE, "no parent: snapshot discarded");
+    test_check(test_hasCell()==FALSE, "no parent: cell not restored");
+}
+
+/**
+\brief Initialize the stack again, as after a reset of the board.
+*/
+void test_reset(void) {
+    scheduler_init();
+    openstack_init();
+}
+
+/**
+\brief Synchronize the MAC at a given ASN, without a network.
+*/
+void test_sync(uint32_t asn) {
+    memset(&ieee154e_vars.asn,0,sizeof(asn_t));
+    asnfunctions_add(&ieee154e_vars.asn,asn);
+    ieee154e_vars.isSync = TRUE;
+}
+
+/**
+\brief Run the periodic check of the snapshot module, as its timer does.
+*/
+void test_tick(uint8_t numChecks) {
+    while (numChecks>0) {
+        snapshot_timer_cb(snapshot_vars.timerId);
+        numChecks--;
+    }
+}
+
+/**
+\brief Receive a frame from the parent.
+*/
+void test_hear(void) {
+    open_addr_t parent;
+
+    test_getParent(&parent);
+    neighbors_indicateRx(&parent,-50,&ieee154e_vars.asn,FALSE,0,FALSE);
+}
+
+void test_getParent(open_addr_t *address) {
+    uint8_t i;
+
+    memset(address,0,sizeof(open_addr_t));
+    address->type = ADDR_64B;
+    for (i=0;i<LENGTH_ADDR64b;i++) {
+        address->addr_64b[i] = TEST_PARENT+i;
+    }
+}
+
+/**
+\brief Whether the cell to the parent is in the schedule.
+*/
+bool test_hasCell(void) {
+    open_addr_t        parent;
+    slotinfo_element_t cell;
+    uint8_t            i;
+
+    test_getParent(&parent);
+    for (i=0;i<SCHEDULE_NUM_CELLS;i++) {
+        if (
+            schedule_getNegotiatedCell(i,&cell) &&
+            cell.slotOffset==TEST_SLOTOFFSET &&
+            cell.channelOffset==TEST_CHANNELOFFSET &&
+            packetfunctions_sameAddress(&cell.address,&parent)
+        ) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+\brief Whether the mote has the parent, the DODAG and the cell of the test.
+*/
+bool test_hasState(void) {
+    open_addr_t parent;
+    open_addr_t address;
+    uint8_t     dodagid[16];
+
+    test_getParent(&parent);
+    if (
+        icmpv6rpl_getPreferredParentEui64(&address)==FALSE ||
+        packetfunctions_sameAddress(&address,&parent)==FALSE
+    ) {
+        return FALSE;
+    }
+    if (icmpv6rpl_getRPLDODAGid(dodagid)!=E_SUCCESS || dodagid[0]!=TEST_DODAGID) {
+        return FALSE;
+    }
+    return test_hasCell();
+}
+
+void test_check(bool passed, const char *name) {
+    if (passed) {
+        app_vars.numPassed++;
+    } else {
+        app_vars.numFailed++;
+    }
+#ifdef PYTHON_BOARD
+    printf("%s %s\n",passed ? "PASS" : "FAIL",name);
+#endif
+}
+
+#endif /* OPENWSN_SNAPSHOT_C */
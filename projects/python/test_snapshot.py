@@ -0,0 +1,64 @@
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import re
+import shutil
+import tempfile
+
+#============================ get notification IDs ============================
+
+f = open(os.path.join('..','..','bsp','boards','python','openwsnmodule_obj.h'))
+lines = f.readlines()
+f.close()
+
+notifString = []
+
+for line in lines:
+    m = re.search('MOTE_NOTIF_(\w+)',line)
+    if m:
+        if m.group(1) not in notifString:
+            notifString += [m.group(1)]
+
+def notifId(s):
+    assert s in notifString
+    return notifString.index(s)
+
+import oos_snapshot
+
+# the snapshot runs without a network: the bsp calls do nothing, the test
+# reports a failure by turning the error LED on, and ends in board_sleep()
+
+failed = [False]
+
+def eui64_get():
+   return range(8)
+
+def leds_error_on():
+   failed[0] = True
+   return 0
+
+def board_sleep():
+   shutil.rmtree(storageDir)
+   os._exit(1 if failed[0] else 0)
+
+# keep the storage of the mote apart
+storageDir = tempfile.mkdtemp()
+os.environ['OPENWSN_STORAGE_DIR'] = storageDir
+
+# create instance
+mote = oos_snapshot.OpenMote()
+
+# install default callback, which ignores its arguments
+for i in range(len(notifString)-1):
+    mote.set_callback(i,lambda *args:0)
+
+# overwrite some callbacks
+mote.set_callback(notifId('eui64_get'),     eui64_get)
+mote.set_callback(notifId('leds_error_on'), leds_error_on)
+mote.set_callback(notifId('board_sleep'),   board_sleep)
+
+# run the test, the process exits from board_sleep()
+mote.supply_on()
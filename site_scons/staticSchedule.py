@@ -0,0 +1,318 @@
+import os
+import json
+
+'''
+Generates the static schedule of a deployment, at build time.
+
+The schedule is described in a JSON file, passed to the build with
+stackcfg=static-schedule:<file>. The generated header holds the cells of all the
+motes of the deployment, each mote loads its own cells at boot, in a slotframe
+of their own which is not managed by 6top.
+
+Description format:
+
+    {
+        "slotframeLength": 101,
+        "nodes": {
+            "root": "14-15-92-cc-00-00-00-01",
+            "a":    "14-15-92-cc-00-00-00-02",
+            "b":    "14-15-92-cc-00-00-00-03"
+        },
+        "links": [
+            {"from": "a", "to": "root", "slotOffset": 10, "channelOffset": 2}
+        ],
+        "flows": [
+            {"path": ["b", "a", "root"], "cells": 2}
+        ]
+    }
+
+"links" are cells placed by hand, "shared" can be set to true for a shared
+cell. "flows" are cells allocated by the generator: for each of the "cells"
+rounds, each hop of the path gets a dedicated cell, in the first slots after
+the one of the previous hop, so that a packet crosses the path within a
+slotframe.
+
+Optional keys:
+    handle                  handle of the static slotframe, default 1
+    defaultSlotframeLength  SLOTFRAME_LENGTH of the build, default 101
+    minimalCells            SCHEDULE_MINIMAL_6TISCH_ACTIVE_CELLS, default 1
+    numChannelOffsets       number of channel offsets to use, default 16
+
+A cell is rejected when one of its motes already has a cell in the same slot,
+when it falls in the same slot as the minimal cells, or as the autonomous cells
+of its motes and of their neighbors, all in the default slotframe.
+
+Can also be run by hand: python staticSchedule.py <description> <header>
+'''
+
+#============================ defines =========================================
+
+DEFAULT_HANDLE              = 1
+DEFAULT_SLOTFRAME_LENGTH    = 101
+DEFAULT_MINIMAL_CELLS       = 1
+DEFAULT_NUM_CHANNEL_OFFSETS = 16
+
+CELLTYPE_TX                 = 'CELLTYPE_TX'
+CELLTYPE_RX                 = 'CELLTYPE_RX'
+
+#============================ public ==========================================
+
+class StaticScheduleError(Exception):
+    pass
+
+def generate(target, source, env):
+    '''SCons action, generates the header target[0] from the description source[0].'''
+    try:
+        generateFile(str(source[0]), str(target[0]))
+    except StaticScheduleError as err:
+        raise StaticScheduleError('{0}: {1}'.format(source[0], err))
+    return None
+
+def generateFile(descriptionFile, headerFile):
+    f = open(descriptionFile, 'r')
+    try:
+        description = json.load(f)
+    finally:
+        f.close()
+
+    header = buildHeader(
+        allocate(description),
+        os.path.basename(descriptionFile),
+    )
+
+    f = open(headerFile, 'w')
+    try:
+        f.write(header)
+    finally:
+        f.close()
+
+def allocate(description):
+    '''
+    Computes the cells of each mote.
+
+    :returns: a dictionary with the slotframe handle and length, and the cells
+        of each mote, indexed by mote name
+    '''
+    schedule = StaticSchedule(description)
+    for link in description.get('links', []):
+        schedule.addLink(link)
+    for flow in description.get('flows', []):
+        schedule.addFlow(flow)
+    return schedule.result()
+
+#============================ private =========================================
+
+def parseEui64(name, text):
+    try:
+        eui64 = [int(b, 16) for b in text.replace(':', '-').split('-')]
+    except ValueError:
+        eui64 = []
+    if len(eui64) != 8 or [b for b in eui64 if b < 0 or b > 0xff]:
+        raise StaticScheduleError('invalid EUI64 "{0}" for node "{1}"'.format(text, name))
+    return eui64
+
+def gcd(a, b):
+    while b:
+        a, b = b, a % b
+    return a
+
+class StaticSchedule(object):
+
+    def __init__(self, description):
+        self.handle             = description.get('handle', DEFAULT_HANDLE)
+        self.length             = description.get('slotframeLength', DEFAULT_SLOTFRAME_LENGTH)
+        self.defaultLength      = description.get('defaultSlotframeLength', DEFAULT_SLOTFRAME_LENGTH)
+        self.minimalCells       = description.get('minimalCells', DEFAULT_MINIMAL_CELLS)
+        self.numChannelOffsets  = description.get('numChannelOffsets', DEFAULT_NUM_CHANNEL_OFFSETS)
+
+        if self.handle <= 0 or self.handle > 0xff:
+            raise StaticScheduleError('handle must be in 1..255, 0 is the slotframe advertised in EBs')
+        if self.length <= 0 or self.length > 0xffff:
+            raise StaticScheduleError('invalid slotframe length {0}'.format(self.length))
+
+        self.nodes = {}
+        for (name, eui64) in description.get('nodes', {}).items():
+            self.nodes[name] = parseEui64(name, eui64)
+        if len(set([tuple(e) for e in self.nodes.values()])) != len(self.nodes):
+            raise StaticScheduleError('several nodes have the same EUI64')
+
+        # neighbors of each mote, whose autonomous cells it may use
+        self.neighbors = dict([(name, set()) for name in self.nodes])
+        for link in description.get('links', []):
+            self._addNeighbors([link.get('from'), link.get('to')])
+        for flow in description.get('flows', []):
+            self._addNeighbors(flow.get('path', []))
+
+        self.cells = dict([(name, {}) for name in self.nodes])   # per mote, by slot offset
+        self.channels = {}                                          # channel offsets in use, by slot offset
+
+    def addLink(self, link):
+        (tx, rx) = (link.get('from'), link.get('to'))
+        slotOffset = link.get('slotOffset')
+        channelOffset = link.get('channelOffset')
+        if slotOffset is None or channelOffset is None:
+            raise StaticScheduleError('link {0} -> {1} needs a slotOffset and a channelOffset'.format(tx, rx))
+        if channelOffset < 0 or channelOffset >= self.numChannelOffsets:
+            raise StaticScheduleError('link {0} -> {1}: invalid channel offset {2}'.format(tx, rx, channelOffset))
+        if channelOffset in self.channels.get(slotOffset, set()):
+            raise StaticScheduleError(
+                'link {0} -> {1}: channel offset {2} already used in slot {3}'.format(tx, rx, channelOffset, slotOffset)
+            )
+        reason = self._whyNotFree(tx, rx, slotOffset)
+        if reason:
+            raise StaticScheduleError('link {0} -> {1}: {2}'.format(tx, rx, reason))
+        self._addCell(tx, rx, slotOffset, channelOffset, link.get('shared', False))
+
+    def addFlow(self, flow):
+        path = flow.get('path', [])
+        if len(path) < 2:
+            raise StaticScheduleError('flow {0} needs at least 2 nodes'.format(path))
+        slotOffset = self.minimalCells - 1
+        for _ in range(flow.get('cells', 1)):
+            for (tx, rx) in zip(path[:-1], path[1:]):
+                slotOffset = self._nextFreeSlot(tx, rx, slotOffset)
+                if slotOffset is None:
+                    raise StaticScheduleError('flow {0}: no slot left for {1} -> {2}'.format(path, tx, rx))
+                channelOffset = self._freeChannel(slotOffset)
+                if channelOffset is None:
+                    raise StaticScheduleError('flow {0}: no channel left in slot {1}'.format(path, slotOffset))
+                self._addCell(tx, rx, slotOffset, channelOffset, False)
+
+    def result(self):
+        return {
+            'handle':   self.handle,
+            'length':   self.length,
+            'nodes':    sorted(
+                [
+                    (self.nodes[name], name, [self.cells[name][s] for s in sorted(self.cells[name])])
+                    for name in self.nodes
+                ]
+            ),
+        }
+
+    #======================== private =========================================
+
+    def _addNeighbors(self, path):
+        for name in path:
+            if name not in self.nodes:
+                raise StaticScheduleError('unknown node "{0}"'.format(name))
+        for (a, b) in zip(path[:-1], path[1:]):
+            if a == b:
+                raise StaticScheduleError('node "{0}" linked to itself'.format(a))
+            self.neighbors[a].add(b)
+            self.neighbors[b].add(a)
+
+    def _autonomousSlotOffset(self, name):
+        # same hash as msf_hashFunction_getSlotoffset()
+        moteId = (self.nodes[name][6] << 8) + self.nodes[name][7]
+        return self.minimalCells + moteId % (self.defaultLength - self.minimalCells)
+
+    def _defaultSlotOffsets(self, name):
+        # slot offsets the mote may use in the default slotframe
+        slotOffsets = set(range(self.minimalCells))
+        for n in [name] + list(self.neighbors[name]):
+            slotOffsets.add(self._autonomousSlotOffset(n))
+        return slotOffsets
+
+    def _whyNotFree(self, tx, rx, slotOffset):
+        if slotOffset < 0 or slotOffset >= self.length:
+            return 'slot offset {0} out of the slotframe'.format(slotOffset)
+        period = gcd(self.length, self.defaultLength)
+        for name in [tx, rx]:
+            if slotOffset in self.cells[name]:
+                return 'node {0} already has a cell in slot {1}'.format(name, slotOffset)
+            for s in self._defaultSlotOffsets(name):
+                if (slotOffset - s) % period == 0:
+                    return 'slot {0} falls on the minimal or autonomous cell of node {1}'.format(slotOffset, name)
+        return None
+
+    def _nextFreeSlot(self, tx, rx, after):
+        for i in range(1, self.length + 1):
+            slotOffset = (after + i) % self.length
+            if self._whyNotFree(tx, rx, slotOffset) is None and self._freeChannel(slotOffset) is not None:
+                return slotOffset
+        return None
+
+    def _freeChannel(self, slotOffset):
+        for channelOffset in range(self.numChannelOffsets):
+            if channelOffset not in self.channels.get(slotOffset, set()):
+                return channelOffset
+        return None
+
+    def _addCell(self, tx, rx, slotOffset, channelOffset, shared):
+        self.channels.setdefault(slotOffset, set()).add(channelOffset)
+        self.cells[tx][slotOffset] = (slotOffset, channelOffset, CELLTYPE_TX, shared, rx)
+        self.cells[rx][slotOffset] = (slotOffset, channelOffset, CELLTYPE_RX, shared, tx)
+
+def buildHeader(schedule, descriptionName):
+    nodes = schedule['nodes']
+    numCells = sum([len(cells) for (_, _, cells) in nodes])
+    if numCells > 0xffff:
+        raise StaticScheduleError('too many cells')
+    maxNodeCells = max([len(cells) for (_, _, cells) in nodes] + [0])
+    eui64s = dict([(name, eui64) for (eui64, name, _) in nodes])
+
+    def formatEui64(eui64):
+        return '{' + ','.join(['0x{0:02x}'.format(b) for b in eui64]) + '}'
+
+    output = []
+    output += ['/**']
+    output += ['\\brief Static schedule, generated from {0} by site_scons/staticSchedule.py.'.format(descriptionName)]
+    output += ['']
+    output += ['Do not edit, this file is generated at build time. It is only included by']
+    output += ['schedule.c.']
+    output += ['*/']
+    output += ['']
+    output += ['#ifndef OPENWSN_SCHEDULE_STATIC_H']
+    output += ['#define OPENWSN_SCHEDULE_STATIC_H']
+    output += ['']
+    output += ['#define SCHEDULE_STATIC_FRAME_HANDLE    {0}'.format(schedule['handle'])]
+    output += ['#define SCHEDULE_STATIC_FRAME_LENGTH    {0}'.format(schedule['length'])]
+    output += ['#define SCHEDULE_STATIC_NUM_NODES       {0}'.format(len(nodes))]
+    output += ['#define SCHEDULE_STATIC_NUM_CELLS       {0}'.format(numCells)]
+    output += ['#define SCHEDULE_STATIC_MAX_NODE_CELLS  {0}'.format(maxNodeCells)]
+    output += ['']
+    output += ['static const staticScheduleNode_t schedule_static_nodes[SCHEDULE_STATIC_NUM_NODES] = {']
+    firstCell = 0
+    for (eui64, name, cells) in nodes:
+        output += ['    {{{0}, {1}, {2}}}, // {3}'.format(formatEui64(eui64), firstCell, len(cells), name)]
+        firstCell += len(cells)
+    output += ['};']
+    output += ['']
+    if numCells > 0:
+        output += ['static const staticScheduleCell_t schedule_static_cells[SCHEDULE_STATIC_NUM_CELLS] = {']
+        for (eui64, name, cells) in nodes:
+            for (slotOffset, channelOffset, cellType, shared, neighbor) in cells:
+                output += [
+                    '    {{{0}, {1}, {2}, {3}, {4}}}, // {5} {6} {7}'.format(
+                        slotOffset,
+                        channelOffset,
+                        cellType,
+                        'TRUE' if shared else 'FALSE',
+                        formatEui64(eui64s[neighbor]),
+                        name,
+                        '->' if cellType == CELLTYPE_TX else '<-',
+                        neighbor,
+                    )
+                ]
+        output += ['};']
+    else:
+        output += ['static const staticScheduleCell_t schedule_static_cells[1];']
+    output += ['']
+    output += ['#endif /* OPENWSN_SCHEDULE_STATIC_H */']
+    output += ['']
+
+    return '\n'.join(output)
+
+#============================ main ============================================
+
+if __name__ == '__main__':
+    import sys
+    if len(sys.argv) != 3:
+        sys.stderr.write('usage: python staticSchedule.py <description> <header>\n')
+        sys.exit(1)
+    try:
+        generateFile(sys.argv[1], sys.argv[2])
+    except StaticScheduleError as err:
+        sys.stderr.write('{0}\n'.format(err))
+        sys.exit(1)